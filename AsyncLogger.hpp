@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <NvInfer.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace common
+{
+
+//! Logger for TensorRT info/warning/errors that never blocks the calling thread on I/O.
+//!
+//! Messages are pushed into a bounded lock-free ring buffer and written out in batches
+//! by a background thread, with a single flush per batch. When the buffer is full,
+//! messages are dropped and counted; the count is reported in the log stream.
+class AsyncLogger : public nvinfer1::ILogger
+{
+public:
+    enum class Format
+    {
+        kTEXT,       //!< "[YYYY-mm-dd HH:MM:SS SEVERITY] message"
+        kJSON_LINES, //!< One JSON object per line: {"time": ..., "severity": ..., "msg": ...}
+    };
+
+    //! \param capacity Number of records the ring buffer holds. Rounded up to a power of 2.
+    AsyncLogger(Severity verbosity = Severity::kWARNING, std::ostream& ostream = std::cout,
+        Format format = Format::kTEXT, size_t capacity = 4096)
+        : mVerbosity(verbosity)
+        , mOstream(&ostream)
+        , mFormat(format)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        mMask = size - 1;
+        mCells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i)
+        {
+            mCells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mWriter = std::thread(&AsyncLogger::drain, this);
+    }
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    ~AsyncLogger()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mWakeWriter.notify_one();
+        mWriter.join();
+    }
+
+    void log(Severity severity, const char* msg) noexcept override
+    {
+        if (severity > mVerbosity)
+        {
+            return;
+        }
+        Record record;
+        record.severity = severity;
+        record.time = std::chrono::system_clock::now();
+        try
+        {
+            record.msg = msg;
+        }
+        catch (...)
+        {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (!push(record))
+        {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        mPushed.fetch_add(1, std::memory_order_release);
+        if (mWriterIdle.load(std::memory_order_acquire))
+        {
+            mWakeWriter.notify_one();
+        }
+    }
+
+    //! Block until every message logged before this call has been written and flushed.
+    void flush()
+    {
+        const uint64_t target = mPushed.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWakeWriter.notify_one();
+        mFlushed.wait(lock, [&] { return mWritten >= target; });
+    }
+
+    void setVerbosity(Severity verbosity)
+    {
+        mVerbosity = verbosity;
+    }
+
+    //! Number of messages discarded so far because the ring buffer was full.
+    uint64_t droppedCount() const
+    {
+        return mDropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Record
+    {
+        Severity severity;
+        std::chrono::system_clock::time_point time;
+        std::string msg;
+    };
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    // Bounded multi-producer queue after D. Vyukov. Each cell carries a sequence number telling
+    // producers and the consumer whether it is free to be written or ready to be read.
+    bool push(Record& record)
+    {
+        size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true)
+        {
+            cell = &mCells[pos & mMask];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = mEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->record = std::move(record);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Only ever called from the writer thread.
+    bool pop(Record& record)
+    {
+        const size_t pos = mDequeuePos;
+        Cell* cell = &mCells[pos & mMask];
+        const size_t seq = cell->sequence.load(std::memory_order_acquire);
+        if (seq != pos + 1)
+        {
+            return false;
+        }
+        record = std::move(cell->record);
+        cell->sequence.store(pos + mMask + 1, std::memory_order_release);
+        mDequeuePos = pos + 1;
+        return true;
+    }
+
+    static const char* severityString(Severity severity)
+    {
+        return severity == Severity::kINTERNAL_ERROR ? "    BUG"
+            : severity == Severity::kERROR           ? "  ERROR"
+            : severity == Severity::kWARNING         ? "WARNING"
+            : severity == Severity::kINFO            ? "   INFO"
+            : severity == Severity::kVERBOSE         ? "VERBOSE"
+                                                     : "UNKNOWN";
+    }
+
+    // Timestamps only change once per second, so the formatted string is cached.
+    const char* timeString(std::chrono::system_clock::time_point time)
+    {
+        const time_t rawtime = std::chrono::system_clock::to_time_t(time);
+        if (rawtime != mCachedTime)
+        {
+            std::tm tm;
+#ifdef _MSC_VER
+            gmtime_s(&tm, &rawtime);
+#else
+            gmtime_r(&rawtime, &tm);
+#endif
+            strftime(mTimeBuf, sizeof(mTimeBuf), "%Y-%m-%d %H:%M:%S", &tm);
+            mCachedTime = rawtime;
+        }
+        return mTimeBuf;
+    }
+
+    static void appendJsonString(std::string& out, const std::string& s)
+    {
+        out += '"';
+        for (const char c : s)
+        {
+            switch (c)
+            {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+        }
+        out += '"';
+    }
+
+    void format(std::string& out, Severity severity, std::chrono::system_clock::time_point time, const std::string& msg)
+    {
+        const char* sevstr = severityString(severity);
+        if (mFormat == Format::kJSON_LINES)
+        {
+            while (*sevstr == ' ')
+            {
+                ++sevstr;
+            }
+            out += "{\"time\": \"";
+            out += timeString(time);
+            out += "\", \"severity\": \"";
+            out += sevstr;
+            out += "\", \"msg\": ";
+            appendJsonString(out, msg);
+            out += "}\n";
+        }
+        else
+        {
+            out += '[';
+            out += timeString(time);
+            out += ' ';
+            out += sevstr;
+            out += "] ";
+            out += msg;
+            out += '\n';
+        }
+    }
+
+    void drain()
+    {
+        std::string batch;
+        Record record;
+        uint64_t reportedDrops = 0;
+        while (true)
+        {
+            uint64_t count = 0;
+            while (pop(record))
+            {
+                format(batch, record.severity, record.time, record.msg);
+                ++count;
+            }
+            const uint64_t dropped = mDropped.load(std::memory_order_relaxed);
+            if (dropped != reportedDrops)
+            {
+                format(batch, Severity::kWARNING, std::chrono::system_clock::now(),
+                    std::to_string(dropped - reportedDrops) + " log messages dropped (logger buffer full)");
+                reportedDrops = dropped;
+            }
+            if (!batch.empty())
+            {
+                mOstream->write(batch.data(), batch.size());
+                mOstream->flush();
+                batch.clear();
+            }
+
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWritten += count;
+            mFlushed.notify_all();
+            if (mWritten < mPushed.load(std::memory_order_acquire))
+            {
+                continue;
+            }
+            if (mStop)
+            {
+                break;
+            }
+            mWriterIdle.store(true, std::memory_order_release);
+            // The timeout bounds the latency of a wakeup lost between the check above and the wait.
+            mWakeWriter.wait_for(lock, std::chrono::milliseconds(50));
+            mWriterIdle.store(false, std::memory_order_release);
+        }
+    }
+
+    Severity mVerbosity;
+    std::ostream* mOstream;
+    Format mFormat;
+
+    std::unique_ptr<Cell[]> mCells;
+    size_t mMask{0};
+    std::atomic<size_t> mEnqueuePos{0};
+    size_t mDequeuePos{0};
+
+    std::atomic<uint64_t> mPushed{0};
+    std::atomic<uint64_t> mDropped{0};
+    uint64_t mWritten{0}; // Guarded by mMutex
+    bool mStop{false};    // Guarded by mMutex
+    std::atomic<bool> mWriterIdle{false};
+
+    time_t mCachedTime{0};
+    char mTimeBuf[32]{};
+
+    std::mutex mMutex;
+    std::condition_variable mWakeWriter;
+    std::condition_variable mFlushed;
+    std::thread mWriter;
+};
+
+} // namespace common
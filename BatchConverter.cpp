@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "BatchConverter.hpp"
+#include "ModelImporter.hpp"
+#include "common.hpp"
+
+#include <NvInferPlugin.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <sys/resource.h> // For ::getrusage
+#include <thread>
+
+using std::cerr;
+using std::endl;
+
+namespace batch
+{
+
+namespace
+{
+
+  // Counting semaphore limiting the number of concurrent engine builds.
+  class BuildSlots {
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    int _available;
+  public:
+    explicit BuildSlots(int count) : _available(count) {}
+    void acquire() {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _cv.wait(lock, [this] { return _available > 0; });
+      --_available;
+    }
+    void release() {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_available;
+      }
+      _cv.notify_one();
+    }
+  };
+
+  // Holds one build slot for the lifetime of the guard, so the slot is returned even if the build throws.
+  class BuildSlotGuard {
+    BuildSlots& _slots;
+  public:
+    explicit BuildSlotGuard(BuildSlots& slots) : _slots(slots) { _slots.acquire(); }
+    ~BuildSlotGuard() { _slots.release(); }
+    BuildSlotGuard(const BuildSlotGuard&) = delete;
+    BuildSlotGuard& operator=(const BuildSlotGuard&) = delete;
+  };
+
+  double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+
+  long process_peak_rss_kb() {
+    struct rusage usage;
+    if( ::getrusage(RUSAGE_SELF, &usage) != 0 ) {
+      return 0;
+    }
+    return usage.ru_maxrss;
+  }
+
+  // Resets the peak resident set size reported as VmHWM to the current one.
+  // Unlike ru_maxrss, VmHWM can be reset, which allows per-job peaks when
+  // jobs run one at a time.
+  bool reset_peak_rss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.close();
+    return static_cast<bool>(clear_refs);
+  }
+
+  // Returns VmHWM in kB, or -1 if it cannot be read.
+  long peak_rss_since_reset_kb() {
+    std::ifstream status("/proc/self/status");
+    for( std::string line; std::getline(status, line); ) {
+      if( line.compare(0, 6, "VmHWM:") == 0 ) {
+        return atol(line.c_str() + 6);
+      }
+    }
+    return -1;
+  }
+
+  std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for( char c : s ) {
+      if( c == '"' || c == '\\' ) { out += '\\'; out += c; }
+      else if( c == '\n' ) { out += "\\n"; }
+      else if( static_cast<unsigned char>(c) < 0x20 ) { out += ' '; }
+      else { out += c; }
+    }
+    return out + "\"";
+  }
+
+  std::string parser_errors(nvonnxparser::IParser& parser) {
+    std::ostringstream ss;
+    for( int i=0; i<parser.getNbErrors(); ++i ) {
+      nvonnxparser::IParserError const* error = parser.getError(i);
+      if( i ) { ss << "; "; }
+      if( error->node() != -1 ) { ss << "node " << error->node() << ": "; }
+      ss << error->desc();
+    }
+    return ss.str();
+  }
+
+  void convert(const Job& job, nvinfer1::IBuilder& builder, BuildSlots& build_slots,
+               nvinfer1::ILogger& logger, Result* result) {
+    const auto explicitBatch = 1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
+
+    auto parse_start = std::chrono::steady_clock::now();
+    // The model must stay alive until the engine is built, since the network refers to its weights.
+    ::ONNX_NAMESPACE::ModelProto onnx_model;
+    {
+      common::MappedFile onnx_file(job.model_filename.c_str());
+      if( !onnx_file ) {
+        result->error = "Input file not found";
+        return;
+      }
+      if( !common::ParseFromBuffer(&onnx_model, onnx_file.data(), onnx_file.size()) ) {
+        result->error = "Failed to deserialize ONNX model";
+        return;
+      }
+    }
+    auto network = common::infer_object(builder.createNetworkV2(explicitBatch));
+    auto parser = common::infer_object(new onnx2trt::ModelImporter(network.get(), &logger));
+    if( !parser->parseModelProto(onnx_model, job.model_filename.c_str()) ) {
+      result->error = parser_errors(*parser);
+      result->parse_ms = elapsed_ms(parse_start);
+      return;
+    }
+    result->parsed = true;
+    result->parse_ms = elapsed_ms(parse_start);
+
+    auto config = common::infer_object(builder.createBuilderConfig());
+    config->setMaxWorkspaceSize(job.max_workspace_size);
+    if( job.fp16 && builder.platformHasFastFp16() ) {
+      config->setFlag(nvinfer1::BuilderFlag::kFP16);
+    }
+    builder.setMaxBatchSize(job.max_batch_size);
+
+    nvinfer1::ICudaEngine* engine_ptr = nullptr;
+    {
+      BuildSlotGuard slot(build_slots);
+      auto build_start = std::chrono::steady_clock::now();
+      engine_ptr = builder.buildEngineWithConfig(*network, *config);
+      result->build_ms = elapsed_ms(build_start);
+    }
+    if( !engine_ptr ) {
+      result->error = "Failed to build engine";
+      return;
+    }
+    auto engine = common::infer_object(engine_ptr);
+    auto engine_plan = common::infer_object(engine->serialize());
+    std::ofstream engine_file(job.engine_filename.c_str(), std::ios::binary);
+    if( !engine_file ) {
+      result->error = "Failed to open output file for writing";
+      return;
+    }
+    engine_file.write((char*)engine_plan->data(), engine_plan->size());
+    result->built = static_cast<bool>(engine_file);
+    if( !result->built ) {
+      result->error = "Failed to write engine";
+    }
+  }
+
+} // anonymous namespace
+
+bool read_manifest(const std::string& filename, std::vector<Job>* jobs) {
+  std::ifstream manifest(filename.c_str());
+  if( !manifest ) {
+    cerr << "ERROR: Failed to open manifest " << filename << endl;
+    return false;
+  }
+  int line_number = 0;
+  for( std::string line; std::getline(manifest, line); ) {
+    ++line_number;
+    std::istringstream fields(line);
+    Job job;
+    if( !(fields >> job.model_filename) || job.model_filename[0] == '#' ) {
+      continue;
+    }
+    if( !(fields >> job.engine_filename) ) {
+      cerr << "ERROR: " << filename << ":" << line_number
+           << ": expected '<model> <engine> [options]'" << endl;
+      return false;
+    }
+    for( std::string option; fields >> option; ) {
+      const size_t eq = option.find('=');
+      const std::string key = option.substr(0, eq);
+      const std::string value = eq == std::string::npos ? "" : option.substr(eq + 1);
+      if(      key == "workspace" ) { job.max_workspace_size = atoll(value.c_str()); }
+      else if( key == "max_batch" ) { job.max_batch_size = atoll(value.c_str()); }
+      else if( key == "fp16"      ) { job.fp16 = value != "0"; }
+      else {
+        cerr << "ERROR: " << filename << ":" << line_number
+             << ": unknown option '" << key << "'" << endl;
+        return false;
+      }
+    }
+    jobs->push_back(job);
+  }
+  return true;
+}
+
+std::vector<Result> run(const std::vector<Job>& jobs, const Options& options,
+                        nvinfer1::ILogger& logger) {
+  std::vector<Result> results(jobs.size());
+  initLibNvInferPlugins(&logger, "");
+
+  BuildSlots build_slots(std::max(options.build_concurrency, 1));
+  std::atomic<size_t> next_job(0);
+  const int nworkers = std::max(1, std::min<int>(options.parse_workers, jobs.size()));
+  auto worker = [&]() {
+    // Builders are reused for all jobs handled by this worker.
+    auto builder = common::infer_object(nvinfer1::createInferBuilder(logger));
+    for( size_t i = next_job++; i < jobs.size(); i = next_job++ ) {
+      // The peak can only be attributed to this job if no other job runs.
+      const bool per_job_peak = nworkers == 1 && reset_peak_rss();
+      try {
+        convert(jobs[i], *builder, build_slots, logger, &results[i]);
+      } catch( const std::exception& e ) {
+        results[i].error = e.what();
+      }
+      results[i].process_peak_rss_kb = process_peak_rss_kb();
+      if( per_job_peak ) {
+        results[i].peak_rss_kb = peak_rss_since_reset_kb();
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for( int i=0; i<nworkers; ++i ) {
+    workers.emplace_back(worker);
+  }
+  for( auto& thread : workers ) {
+    thread.join();
+  }
+  return results;
+}
+
+void write_summary(std::ostream& stream, const std::vector<Job>& jobs,
+                   const std::vector<Result>& results, double total_ms) {
+  size_t nsucceeded = 0;
+  stream << "{\n  \"models\": [\n";
+  for( size_t i=0; i<jobs.size(); ++i ) {
+    const Result& result = results[i];
+    nsucceeded += result.built;
+    stream << "    {\"model\": " << json_string(jobs[i].model_filename)
+           << ", \"engine\": " << json_string(jobs[i].engine_filename)
+           << ", \"status\": \"" << (result.built ? "ok" : result.parsed ? "build_failed" : "parse_failed") << "\""
+           << ", \"parse_ms\": " << result.parse_ms
+           << ", \"build_ms\": " << result.build_ms
+           << ", \"process_peak_rss_kb\": " << result.process_peak_rss_kb;
+    if( result.peak_rss_kb >= 0 ) {
+      stream << ", \"peak_rss_kb\": " << result.peak_rss_kb;
+    }
+    if( !result.error.empty() ) {
+      stream << ", \"error\": " << json_string(result.error);
+    }
+    stream << "}" << (i + 1 < jobs.size() ? "," : "") << "\n";
+  }
+  stream << "  ],\n"
+         << "  \"succeeded\": " << nsucceeded << ",\n"
+         << "  \"failed\": " << jobs.size() - nsucceeded << ",\n"
+         << "  \"total_ms\": " << total_ms << "\n"
+         << "}" << endl;
+}
+
+} // namespace batch
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <NvInfer.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Batch mode for onnx2trt: converts many models in one process, so that protobuf,
+// the plugin library and the builders are initialized only once.
+namespace batch
+{
+
+  // One line of the manifest:
+  //   model.onnx engine.trt [workspace=<bytes>] [fp16=0|1] [max_batch=<n>]
+  // Blank lines and lines starting with '#' are ignored.
+  struct Job {
+    std::string model_filename;
+    std::string engine_filename;
+    size_t max_workspace_size = 1 << 30;
+    size_t max_batch_size = 32;
+    bool fp16 = false;
+  };
+
+  struct Result {
+    bool parsed = false;
+    bool built = false;
+    std::string error;
+    double parse_ms = 0.;
+    double build_ms = 0.;
+    // Process-wide peak resident set size when the job finished. Jobs run
+    // concurrently, so this is an upper bound on the job's own footprint.
+    long process_peak_rss_kb = 0;
+    // Peak resident set size while this job ran, or -1 if it could not be
+    // measured separately (more than one worker, or no /proc/self/clear_refs).
+    long peak_rss_kb = -1;
+  };
+
+  struct Options {
+    int parse_workers = 1;      // Workers parsing models, each with its own builder and parser.
+    int build_concurrency = 1;  // Maximum number of engines being built at once.
+  };
+
+  // Returns false and prints a message to cerr if the manifest cannot be read.
+  bool read_manifest(const std::string& filename, std::vector<Job>* jobs);
+
+  // Converts all jobs and returns one result per job, in manifest order.
+  std::vector<Result> run(const std::vector<Job>& jobs, const Options& options,
+                          nvinfer1::ILogger& logger);
+
+  // Writes the per-model summary as JSON.
+  void write_summary(std::ostream& stream, const std::vector<Job>& jobs,
+                     const std::vector<Result>& results, double total_ms);
+
+} // namespace batch
@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "GraphPartitioner.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <unordered_set>
+
+namespace onnx2trt
+{
+
+namespace
+{
+
+// Graph of clusters of nodes, kept acyclic by only contracting edges whose endpoints are not also connected through
+// some other cluster. Clusters also keep a topological order, which bounds the searches for such paths: a path from
+// a to b only goes through clusters ordered between them.
+class ClusterGraph
+{
+public:
+    ClusterGraph(PartitionGraph const& graph, std::vector<size_t> const& position)
+        : mParent(graph.supported.size())
+        , mSucc(graph.supported.size())
+        , mPred(graph.supported.size())
+        , mMinPos(position)
+        , mOrder(position)
+    {
+        std::iota(mParent.begin(), mParent.end(), 0);
+        for (auto const& tensor : graph.tensors)
+        {
+            if (tensor.producer == kNO_PRODUCER)
+            {
+                continue;
+            }
+            for (size_t consumer : tensor.consumers)
+            {
+                if (consumer != tensor.producer)
+                {
+                    mSucc[tensor.producer].insert(consumer);
+                    mPred[consumer].insert(tensor.producer);
+                }
+            }
+        }
+    }
+
+    size_t find(size_t node)
+    {
+        while (mParent[node] != node)
+        {
+            mParent[node] = mParent[mParent[node]];
+            node = mParent[node];
+        }
+        return node;
+    }
+
+    // Contracts the edge between the clusters of producer and consumer if that keeps the graph acyclic.
+    bool tryMerge(size_t producer, size_t consumer)
+    {
+        size_t a = find(producer);
+        size_t b = find(consumer);
+        std::vector<size_t> after;
+        if (a == b || reachableIndirectly(a, b, &after))
+        {
+            return false;
+        }
+        reorderForMerge(a, b, after);
+        if (mSucc[a].size() + mPred[a].size() < mSucc[b].size() + mPred[b].size())
+        {
+            std::swap(a, b);
+        }
+        // Fold b into a, which takes the order assigned to the merged cluster.
+        mOrder[a] = mOrder[b];
+        mParent[b] = a;
+        mMinPos[a] = std::min(mMinPos[a], mMinPos[b]);
+        for (size_t s : mSucc[b])
+        {
+            mPred[s].erase(b);
+            if (s != a)
+            {
+                mPred[s].insert(a);
+                mSucc[a].insert(s);
+            }
+        }
+        for (size_t p : mPred[b])
+        {
+            mSucc[p].erase(b);
+            if (p != a)
+            {
+                mSucc[p].insert(a);
+                mPred[a].insert(p);
+            }
+        }
+        mSucc[a].erase(b);
+        mPred[a].erase(b);
+        mSucc[b].clear();
+        mPred[b].clear();
+        return true;
+    }
+
+    std::unordered_set<size_t> const& successors(size_t cluster) const
+    {
+        return mSucc[cluster];
+    }
+
+    size_t minPosition(size_t cluster) const
+    {
+        return mMinPos[cluster];
+    }
+
+private:
+    // Whether there is a path from a to b through at least one other cluster. Otherwise, sets *reached to the
+    // clusters ordered before b that are reachable from a, none of which can reach b.
+    bool reachableIndirectly(size_t a, size_t b, std::vector<size_t>* reached)
+    {
+        const size_t limit = mOrder[b];
+        std::vector<size_t> stack;
+        std::unordered_set<size_t> visited;
+        for (size_t s : mSucc[a])
+        {
+            if (s != b && mOrder[s] < limit)
+            {
+                stack.push_back(s);
+                visited.insert(s);
+            }
+        }
+        while (!stack.empty())
+        {
+            const size_t c = stack.back();
+            stack.pop_back();
+            reached->push_back(c);
+            for (size_t s : mSucc[c])
+            {
+                if (s == b)
+                {
+                    return true;
+                }
+                if (mOrder[s] < limit && visited.insert(s).second)
+                {
+                    stack.push_back(s);
+                }
+            }
+        }
+        return false;
+    }
+
+    // Reassigns the orders of the clusters between a and b so that b directly follows a, with the clusters that
+    // reach b before them and the clusters reachable from a (after) behind them. Both groups keep their relative
+    // order, and only move towards their side, so every other edge stays ordered (as in Pearce-Kelly).
+    void reorderForMerge(size_t a, size_t b, std::vector<size_t>& after)
+    {
+        const size_t limit = mOrder[a];
+        std::vector<size_t> before;
+        std::vector<size_t> stack;
+        std::unordered_set<size_t> visited;
+        for (size_t p : mPred[b])
+        {
+            if (p != a && mOrder[p] > limit)
+            {
+                stack.push_back(p);
+                visited.insert(p);
+            }
+        }
+        while (!stack.empty())
+        {
+            const size_t c = stack.back();
+            stack.pop_back();
+            before.push_back(c);
+            for (size_t p : mPred[c])
+            {
+                if (mOrder[p] > limit && visited.insert(p).second)
+                {
+                    stack.push_back(p);
+                }
+            }
+        }
+        auto byOrder = [this](size_t x, size_t y) { return mOrder[x] < mOrder[y]; };
+        std::sort(before.begin(), before.end(), byOrder);
+        std::sort(after.begin(), after.end(), byOrder);
+        std::vector<size_t> slots{mOrder[a], mOrder[b]};
+        for (size_t c : before)
+        {
+            slots.push_back(mOrder[c]);
+        }
+        for (size_t c : after)
+        {
+            slots.push_back(mOrder[c]);
+        }
+        std::sort(slots.begin(), slots.end());
+        size_t next = 0;
+        for (size_t c : before)
+        {
+            mOrder[c] = slots[next++];
+        }
+        mOrder[a] = slots[next++];
+        mOrder[b] = slots[next++];
+        for (size_t c : after)
+        {
+            mOrder[c] = slots[next++];
+        }
+    }
+
+    std::vector<size_t> mParent;
+    std::vector<std::unordered_set<size_t>> mSucc;
+    std::vector<std::unordered_set<size_t>> mPred;
+    std::vector<size_t> mMinPos;
+    std::vector<size_t> mOrder; // Topological order of clusters, by their roots
+};
+
+struct Edge
+{
+    size_t producer;
+    size_t consumer;
+    int64_t bytes;
+};
+
+std::vector<Edge> supportedEdges(PartitionGraph const& graph)
+{
+    std::vector<Edge> edges;
+    for (auto const& tensor : graph.tensors)
+    {
+        if (tensor.producer == kNO_PRODUCER || !graph.supported[tensor.producer])
+        {
+            continue;
+        }
+        for (size_t consumer : tensor.consumers)
+        {
+            if (consumer != tensor.producer && graph.supported[consumer])
+            {
+                edges.push_back({tensor.producer, consumer, tensor.bytes});
+            }
+        }
+    }
+    return edges;
+}
+
+// Contracts the given edges in order and returns the resulting clusters of supported nodes in execution order.
+Partitioning contractEdges(PartitionGraph const& graph, std::vector<size_t> const& topoOrder,
+    std::vector<size_t> const& position, std::vector<Edge> const& edges)
+{
+    ClusterGraph clusters(graph, position);
+    // An edge rejected earlier can become contractible once the clusters on the path blocking it have been merged.
+    for (bool merged = true; merged;)
+    {
+        merged = false;
+        for (auto const& edge : edges)
+        {
+            merged = clusters.tryMerge(edge.producer, edge.consumer) || merged;
+        }
+    }
+
+    // Kahn's algorithm over clusters, preferring clusters that start earliest.
+    const size_t nbNodes = graph.supported.size();
+    std::vector<int> inDegree(nbNodes, 0);
+    std::vector<bool> isRoot(nbNodes, false);
+    for (size_t node = 0; node < nbNodes; ++node)
+    {
+        isRoot[clusters.find(node)] = true;
+    }
+    for (size_t c = 0; c < nbNodes; ++c)
+    {
+        if (isRoot[c])
+        {
+            for (size_t s : clusters.successors(c))
+            {
+                ++inDegree[s];
+            }
+        }
+    }
+    auto later = [&clusters](size_t x, size_t y) { return clusters.minPosition(x) > clusters.minPosition(y); };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> ready(later);
+    for (size_t c = 0; c < nbNodes; ++c)
+    {
+        if (isRoot[c] && inDegree[c] == 0)
+        {
+            ready.push(c);
+        }
+    }
+    std::vector<size_t> rank(nbNodes, 0);
+    size_t nbRanked = 0;
+    while (!ready.empty())
+    {
+        const size_t c = ready.top();
+        ready.pop();
+        rank[c] = nbRanked++;
+        for (size_t s : clusters.successors(c))
+        {
+            if (--inDegree[s] == 0)
+            {
+                ready.push(s);
+            }
+        }
+    }
+
+    std::vector<int> partitionOfCluster(nbNodes, -1);
+    std::vector<size_t> supportedRoots;
+    for (size_t c = 0; c < nbNodes; ++c)
+    {
+        if (isRoot[c] && graph.supported[c])
+        {
+            supportedRoots.push_back(c);
+        }
+    }
+    std::sort(supportedRoots.begin(), supportedRoots.end(), [&rank](size_t x, size_t y) { return rank[x] < rank[y]; });
+    for (size_t i = 0; i < supportedRoots.size(); ++i)
+    {
+        partitionOfCluster[supportedRoots[i]] = static_cast<int>(i);
+    }
+    Partitioning partitioning(supportedRoots.size());
+    for (size_t node : topoOrder)
+    {
+        if (graph.supported[node])
+        {
+            partitioning[partitionOfCluster[clusters.find(node)]].push_back(node);
+        }
+    }
+    return partitioning;
+}
+
+} // anonymous namespace
+
+PartitionCost evaluatePartitioning(PartitionGraph const& graph, Partitioning const& partitioning)
+{
+    // Region of each node: its partition, or -1 for nodes left outside of all partitions.
+    std::vector<int> region(graph.supported.size(), -1);
+    for (size_t i = 0; i < partitioning.size(); ++i)
+    {
+        for (size_t node : partitioning[i])
+        {
+            region[node] = static_cast<int>(i);
+        }
+    }
+    PartitionCost cost;
+    cost.nbPartitions = partitioning.size();
+    std::vector<int> destinations;
+    for (auto const& tensor : graph.tensors)
+    {
+        if (tensor.producer == kNO_PRODUCER)
+        {
+            continue;
+        }
+        destinations.clear();
+        for (size_t consumer : tensor.consumers)
+        {
+            if (region[consumer] != region[tensor.producer])
+            {
+                destinations.push_back(region[consumer]);
+            }
+        }
+        std::sort(destinations.begin(), destinations.end());
+        const auto nbDestinations = std::unique(destinations.begin(), destinations.end()) - destinations.begin();
+        cost.transferBytes += nbDestinations * tensor.bytes;
+    }
+    return cost;
+}
+
+Partitioning partitionGraph(
+    PartitionGraph const& graph, std::vector<size_t> const& topoOrder, int64_t partitionOverheadBytes)
+{
+    std::vector<size_t> position(graph.supported.size(), 0);
+    for (size_t i = 0; i < topoOrder.size(); ++i)
+    {
+        position[topoOrder[i]] = i;
+    }
+
+    std::vector<Edge> edges = supportedEdges(graph);
+    std::sort(edges.begin(), edges.end(), [&position](Edge const& x, Edge const& y) {
+        return position[x.consumer] < position[y.consumer]
+            || (position[x.consumer] == position[y.consumer] && position[x.producer] < position[y.producer]);
+    });
+    std::vector<Partitioning> candidates;
+    candidates.push_back(contractEdges(graph, topoOrder, position, edges));
+    std::stable_sort(edges.begin(), edges.end(), [](Edge const& x, Edge const& y) { return x.bytes > y.bytes; });
+    candidates.push_back(contractEdges(graph, topoOrder, position, edges));
+
+    size_t best = 0;
+    int64_t bestCost = evaluatePartitioning(graph, candidates[0]).total(partitionOverheadBytes);
+    for (size_t i = 1; i < candidates.size(); ++i)
+    {
+        const int64_t cost = evaluatePartitioning(graph, candidates[i]).total(partitionOverheadBytes);
+        if (cost < bestCost)
+        {
+            best = i;
+            bestCost = cost;
+        }
+    }
+    return candidates[best];
+}
+
+} // namespace onnx2trt
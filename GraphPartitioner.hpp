@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Partitioning of a graph into subgraphs of supported nodes, independent of ONNX so it can be tested on
+// synthetic graphs.
+namespace onnx2trt
+{
+
+constexpr size_t kNO_PRODUCER = std::numeric_limits<size_t>::max();
+
+// Estimated fixed cost of a partition boundary in the calling framework (launch, synchronization), expressed in
+// bytes so that it can be compared with transfer sizes.
+constexpr int64_t kDEFAULT_PARTITION_OVERHEAD_BYTES = 1 << 20;
+
+struct PartitionTensor
+{
+    size_t producer{kNO_PRODUCER}; // Graph inputs and initializers have no producer
+    std::vector<size_t> consumers; // Including nodes that only read the tensor from one of their subgraphs
+    int64_t bytes{0};
+};
+
+struct PartitionGraph
+{
+    std::vector<bool> supported; // One entry per node
+    std::vector<PartitionTensor> tensors;
+};
+
+// Node indices of each partition, in topological order.
+using Partitioning = std::vector<std::vector<size_t>>;
+
+struct PartitionCost
+{
+    size_t nbPartitions{0};
+    // Bytes of tensors crossing partition boundaries. A tensor is counted once for every region (partition, or
+    // the unsupported nodes taken together) other than its producer's that consumes it.
+    int64_t transferBytes{0};
+
+    int64_t total(int64_t partitionOverheadBytes) const
+    {
+        return transferBytes + static_cast<int64_t>(nbPartitions) * partitionOverheadBytes;
+    }
+};
+
+PartitionCost evaluatePartitioning(PartitionGraph const& graph, Partitioning const& partitioning);
+
+// Splits the supported nodes into maximal convex, connected subgraphs: no path between two nodes of a subgraph
+// leaves it, so each subgraph can run as a single unit. Candidate partitionings are formed by contracting edges
+// between supported nodes, either largest tensors first or in topological order; the one with the lowest cost is
+// returned, with partitions in an order in which they can be executed.
+Partitioning partitionGraph(PartitionGraph const& graph, std::vector<size_t> const& topoOrder,
+    int64_t partitionOverheadBytes = kDEFAULT_PARTITION_OVERHEAD_BYTES);
+
+} // namespace onnx2trt
@@ -27,10 +27,152 @@
 
 #include <list>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace onnx2trt
 {
 
+// Generates names that are unique among all names generated so far, by appending "_<n>" to repeated basenames.
+// Each basename has its own suffix counter, so a basename that is repeated many times does not probe the suffixes
+// it used before, and lookups are hashed rather than ordered comparisons.
+class UniqueNameGenerator
+{
+public:
+    std::string generate(const std::string& basename)
+    {
+        if (mUsedNames.insert(basename).second)
+        {
+            return basename;
+        }
+        int64_t& suffix = mNextSuffixes[basename];
+        std::string candidate;
+        do
+        {
+            candidate = basename + "_" + std::to_string(suffix++);
+        } while (!mUsedNames.insert(candidate).second);
+        return candidate;
+    }
+    void reserve(size_t count)
+    {
+        mUsedNames.reserve(count);
+    }
+
+private:
+    std::unordered_set<std::string> mUsedNames;
+    StringMap<int64_t> mNextSuffixes;
+};
+
+// TensorRT does not support casts on shape tensors, and only some layers can produce them. A tensor becomes a shape
+// tensor once a layer consumes it as one, so after each node of the top-level graph the inputs of the layers it
+// added are checked, and newly found shape tensors are followed back through their producers. Every tensor is
+// fixed at most once, rather than the whole network being walked after the import.
+class ShapeTensorTracker
+{
+public:
+    // Attributes the layers added since the last call to the given node, and fixes the shape tensors they reveal.
+    void update(IImporterContext* ctx, int nodeIndex)
+    {
+        nvinfer1::INetworkDefinition* network = ctx->network();
+        const int firstLayer = static_cast<int>(mLayerNodes.size());
+        const int nbLayers = network->getNbLayers();
+        for (int i = firstLayer; i < nbLayers; ++i)
+        {
+            nvinfer1::ILayer* layer = network->getLayer(i);
+            mLayerNodes.push_back(nodeIndex);
+            for (int j = 0; j < layer->getNbOutputs(); ++j)
+            {
+                mProducers[layer->getOutput(j)] = std::make_pair(i, j);
+            }
+        }
+        for (int i = firstLayer; i < nbLayers; ++i)
+        {
+            nvinfer1::ILayer* layer = network->getLayer(i);
+            for (int j = 0; j < layer->getNbInputs(); ++j)
+            {
+                fixProducer(ctx, layer->getInput(j));
+            }
+        }
+    }
+    // Network outputs can be shape tensors without having a consumer. Layers added after the last node, such as
+    // constants and identities for the outputs, are not attributed to any node.
+    void finalize(IImporterContext* ctx)
+    {
+        update(ctx, -1);
+        for (int i = 0; i < ctx->network()->getNbOutputs(); ++i)
+        {
+            fixProducer(ctx, ctx->network()->getOutput(i));
+        }
+    }
+    // Indices of the nodes that produced a shape tensor with a layer that cannot produce shape tensors.
+    const std::unordered_set<int>& unsupportedNodes() const
+    {
+        return mUnsupportedNodes;
+    }
+
+private:
+    void fixProducer(IImporterContext* ctx, nvinfer1::ITensor* tensor)
+    {
+        std::vector<nvinfer1::ITensor*> pending{tensor};
+        while (!pending.empty())
+        {
+            nvinfer1::ITensor* shapeTensor = pending.back();
+            pending.pop_back();
+            if (!shapeTensor || !shapeTensor->isShapeTensor())
+            {
+                continue;
+            }
+            const auto producer = mProducers.find(shapeTensor);
+            if (producer == mProducers.end() || !mFixedTensors.insert(shapeTensor).second)
+            {
+                continue;
+            }
+            const int layerIndex = producer->second.first;
+            nvinfer1::ILayer* layer = ctx->network()->getLayer(layerIndex);
+            fixOutputType(ctx, layer, producer->second.second, mLayerNodes[layerIndex]);
+            for (int j = 0; j < layer->getNbInputs(); ++j)
+            {
+                pending.push_back(layer->getInput(j));
+            }
+        }
+    }
+    void fixOutputType(IImporterContext* ctx, nvinfer1::ILayer* layer, int outputIndex, int nodeIndex)
+    {
+        nvinfer1::ITensor& t = *layer->getOutput(outputIndex);
+        layer->resetOutputType(outputIndex);
+        // Assume that boolean tensors were not cast, and thus have their type correctly set.
+        const nvinfer1::DataType shapeTensorType
+            = t.getType() == nvinfer1::DataType::kBOOL ? nvinfer1::DataType::kBOOL : nvinfer1::DataType::kINT32;
+        layer->setOutputType(outputIndex, shapeTensorType);
+        // Set type only if necessary, to avoid TensorRT warnings
+        // about setting type of non-input/output tensors.
+        if (t.getType() != shapeTensorType)
+        {
+            t.setType(shapeTensorType);
+        }
+        // Some layers do not support shape tensor outputs. Keep track of the nodes that created them for
+        // supportsModel().
+        const nvinfer1::LayerType type = layer->getType();
+        const auto elementwiseOp = type == nvinfer1::LayerType::kELEMENTWISE
+            ? static_cast<nvinfer1::IElementWiseLayer*>(layer)->getOperation()
+            : nvinfer1::ElementWiseOperation::kSUM;
+        const auto reduceOp = type == nvinfer1::LayerType::kREDUCE
+            ? static_cast<nvinfer1::IReduceLayer*>(layer)->getOperation()
+            : nvinfer1::ReduceOperation::kSUM;
+        if (!supportsShapeTensor(type, elementwiseOp, reduceOp))
+        {
+            mUnsupportedNodes.insert(nodeIndex);
+            LOG_ERROR("Found unsupported shape tensor producing layer: " << layer->getName());
+        }
+    }
+
+    std::vector<int> mLayerNodes; // Index of the top-level node that created each layer, by layer index.
+    // Index of the layer producing each tensor, and of the tensor among the outputs of that layer.
+    std::unordered_map<nvinfer1::ITensor const*, std::pair<int, int>> mProducers;
+    // Shape tensors whose type has been fixed already. Other outputs of the same layer may become shape tensors later.
+    std::unordered_set<nvinfer1::ITensor const*> mFixedTensors;
+    std::unordered_set<int> mUnsupportedNodes;
+};
+
 class ImporterContext final : public IImporterContext
 {
     nvinfer1::INetworkDefinition* _network;
@@ -44,14 +186,18 @@ class ImporterContext final : public IImporterContext
     StringMap<float> mTensorRangeMins;
     StringMap<float> mTensorRangeMaxes;
     StringMap<nvinfer1::DataType> mLayerPrecisions;
-    std::set<std::string> mTensorNames; // Keep track of how many times a tensor name shows up, to avoid duplicate naming in TRT.
-    std::set<std::string> mLayerNames; // Keep track of how many times a tensor name shows up, to avoid duplicate naming in TRT.
-    int64_t mSuffixCounter = 0; // increasing suffix counter used to uniquify layer names.
-    std::unordered_set<std::string> mUnsupportedShapeTensors; // Container to hold output tensor names of layers that produce shape tensor outputs but do not natively support them.
-    StringMap<std::string> mLoopTensors; // Container to map subgraph tensors to their original outer graph names.
+    UniqueNameGenerator mTensorNames; // TRT requires unique tensor names.
+    UniqueNameGenerator mLayerNames; // TRT requires unique layer names.
+    ShapeTensorTracker mShapeTensors; // Fixes shape tensor types, and records nodes that produce unsupported ones.
+    // For each subgraph being imported, the names it defined, with the outer value each one shadowed, if any.
+    std::vector<StringMap<std::pair<bool, TensorOrWeights>>> mScopes;
     std::string mOnnxFileLocation; // Keep track of the directory of the parsed ONNX file
     std::list<std::string> mInitializerNames; // Keep track of unique names of any initializers
     RefitMap_t* mRefitMap; // Keep track of names of ONNX refittable weights with their corresponding TRT layer and role
+    int mLoopUnrollLimit{0}; // Maximum trip count of Loop and Scan nodes that are unrolled instead of imported as ILoop
+    int mMaxScanOutputLength{1024}; // Length of Loop scan outputs that cannot be derived from a trip count or condition
+    std::vector<std::pair<std::string, int>> mScanOutputLengthPatterns; // Per-node overrides, by node name pattern
+    StringMap<nvinfer1::IPluginCreator*> mPluginCreators; // Plugin creators found so far, by name, version and namespace
 
 public:
     ImporterContext(nvinfer1::INetworkDefinition* network, nvinfer1::ILogger* logger, RefitMap_t* refitMap)
@@ -84,13 +230,18 @@ public:
     {
         return mLayerPrecisions;
     }
-    virtual std::unordered_set<std::string>& unsupportedShapeTensors() override
+    virtual void updateShapeTensors(int nodeIndex) override
+    {
+        mShapeTensors.update(this, nodeIndex);
+    }
+    void finalizeShapeTensors()
     {
-        return mUnsupportedShapeTensors;
+        mShapeTensors.finalize(this);
     }
-    virtual StringMap<std::string>& loopTensors() override
+    // Indices of the top-level nodes that produced a shape tensor with a layer that does not support it.
+    const std::unordered_set<int>& unsupportedShapeTensorNodes() const
     {
-        return mLoopTensors;
+        return mShapeTensors.unsupportedNodes();
     }
     virtual void setOnnxFileLocation(std::string location) override
     {
@@ -104,11 +255,72 @@ public:
     {
         mRefitMap->insert({weightsName, WeightsPair_t{layerName, role}});
     }
+    virtual int getLoopUnrollLimit() const override
+    {
+        return mLoopUnrollLimit;
+    }
+    void setLoopUnrollLimit(int limit)
+    {
+        mLoopUnrollLimit = limit;
+    }
+    virtual int getMaxScanOutputLength(const std::string& nodeName, bool* nodeSpecific) const override
+    {
+        for (const auto& pattern : mScanOutputLengthPatterns)
+        {
+            if (matchesNamePattern(pattern.first, nodeName))
+            {
+                *nodeSpecific = true;
+                return pattern.second;
+            }
+        }
+        *nodeSpecific = false;
+        return mMaxScanOutputLength;
+    }
+    void setMaxScanOutputLength(int length, const char* nodeNamePattern)
+    {
+        if (nodeNamePattern)
+        {
+            mScanOutputLengthPatterns.emplace_back(nodeNamePattern, length);
+        }
+        else
+        {
+            mMaxScanOutputLength = length;
+        }
+    }
+    virtual nvinfer1::IPluginCreator* getPluginCreator(
+        const std::string& pluginName, const std::string& pluginVersion, const std::string& pluginNamespace) override
+    {
+        // Plugin names, versions and namespaces are C strings, so a NUL cannot be part of any of them.
+        std::string key;
+        key.reserve(pluginName.size() + pluginVersion.size() + pluginNamespace.size() + 2);
+        key.append(pluginName).push_back('\0');
+        key.append(pluginVersion).push_back('\0');
+        key.append(pluginNamespace);
+        auto cached = mPluginCreators.find(key);
+        if (cached != mPluginCreators.end())
+        {
+            return cached->second;
+        }
+        nvinfer1::IPluginCreator* creator = getPluginRegistry()->getPluginCreator(
+            pluginName.c_str(), pluginVersion.c_str(), pluginNamespace.c_str());
+        // Misses are not cached, as the plugin may still be registered before the next lookup.
+        if (creator)
+        {
+            mPluginCreators.emplace(std::move(key), creator);
+        }
+        return creator;
+    }
+    // Reserves room for the given number of tensors and layers, so that registering them does not rehash.
+    void reserveNames(size_t nbTensors, size_t nbLayers)
+    {
+        mTensors.reserve(nbTensors);
+        mTensorNames.reserve(nbTensors);
+        mLayerNames.reserve(nbLayers);
+    }
     // This actually handles weights as well, but is named this way to be consistent with the tensors()
     virtual void registerTensor(TensorOrWeights tensor, const std::string& basename) override
     {
-        // TRT requires unique tensor names.
-        const std::string uniqueName = generateUniqueName(mTensorNames, basename);
+        const std::string uniqueName = mTensorNames.generate(basename);
 
         if (tensor)
         {
@@ -131,9 +343,38 @@ public:
                 tensor.weights().setName(mInitializerNames.back().c_str());
             }
         }
-        // Overwrite previous tensors registered with the same name (this only happens when there are subgraphs,
-        // and in that case, overwriting is the desired behavior).
-        this->tensors()[basename] = std::move(tensor);
+        bindTensor(std::move(tensor), basename);
+    }
+    virtual void bindTensor(TensorOrWeights tensor, const std::string& basename) override
+    {
+        // Names of subgraphs may shadow those of the outer graph until the subgraph's scope is popped.
+        if (!mScopes.empty() && !mScopes.back().count(basename))
+        {
+            const auto outer = mTensors.find(basename);
+            mScopes.back().emplace(basename,
+                outer == mTensors.end() ? std::make_pair(false, TensorOrWeights{}) : std::make_pair(true, outer->second));
+        }
+        mTensors[basename] = std::move(tensor);
+    }
+    virtual void pushScope() override
+    {
+        mScopes.emplace_back();
+    }
+    virtual void popScope() override
+    {
+        assert(!mScopes.empty());
+        for (auto& entry : mScopes.back())
+        {
+            if (entry.second.first)
+            {
+                mTensors[entry.first] = std::move(entry.second.second);
+            }
+            else
+            {
+                mTensors.erase(entry.first);
+            }
+        }
+        mScopes.pop_back();
     }
 
     virtual void registerLayer(nvinfer1::ILayer* layer, const std::string& basename) override
@@ -142,7 +383,7 @@ public:
         if (layer)
         {
             const std::string name = basename.empty() ? layer->getName() : basename;
-            const std::string uniqueName = generateUniqueName(mLayerNames, name);
+            const std::string uniqueName = mLayerNames.generate(name);
 
             auto* ctx = this; // To enable logging.
             if (layer->getType() == nvinfer1::LayerType::kCONSTANT)
@@ -238,21 +479,6 @@ public:
             return _opsets.at(domain);
         }
     }
-private:
-    std::string generateUniqueName(std::set<std::string>& namesSet, const std::string& basename)
-    {
-        std::string candidate = basename;
-
-        while (namesSet.find(candidate) != namesSet.end())
-        {
-            candidate = basename + "_" + std::to_string(mSuffixCounter);
-            ++mSuffixCounter;
-        }
-
-        namesSet.insert(candidate);
-
-        return candidate;
-    }
 };
 
 } // namespace onnx2trt
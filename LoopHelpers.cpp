@@ -21,8 +21,14 @@
  */
 
 #include "LoopHelpers.hpp"
+#include "ModelImporter.hpp"
+#include "OnnxAttrs.hpp"
 #include "onnx2trt_utils.hpp"
 
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
 namespace onnx2trt
 {
 
@@ -37,4 +43,374 @@ nvinfer1::ITensor* addLoopCounter(IImporterContext* ctx, nvinfer1::ILoop* loop,
     return counter->getOutput(0);
 }
 
+namespace
+{
+
+bool getScalarWeight(const ShapedWeights& weights, int64_t* value)
+{
+    if (weights.count() != 1)
+    {
+        return false;
+    }
+    switch (weights.type)
+    {
+    case ::ONNX_NAMESPACE::TensorProto::INT32: *value = *static_cast<const int32_t*>(weights.values); return true;
+    case ::ONNX_NAMESPACE::TensorProto::INT64: *value = *static_cast<const int64_t*>(weights.values); return true;
+    case ::ONNX_NAMESPACE::TensorProto::BOOL: *value = *static_cast<const uint8_t*>(weights.values) != 0; return true;
+    default: return false;
+    }
+}
+
+// Whether the condition output of a Loop body is the condition input, possibly through an Identity node.
+bool isConditionLoopInvariant(const ::ONNX_NAMESPACE::GraphProto& body)
+{
+    const std::string& condIn = body.input(1).name();
+    const std::string& condOut = body.output(0).name();
+    if (condOut == condIn)
+    {
+        return true;
+    }
+    for (const auto& node : body.node())
+    {
+        for (const auto& output : node.output())
+        {
+            if (output == condOut)
+            {
+                return node.op_type() == "Identity" && node.input_size() == 1 && node.input(0) == condIn;
+            }
+        }
+    }
+    return false;
+}
+
+// Binds a body graph input to a value of the outer graph. Tensors are bound without renaming them, which matters for
+// network inputs.
+void bindBodyInput(IImporterContext* ctx, const TensorOrWeights& value, const std::string& name)
+{
+    if (value.is_weights())
+    {
+        ctx->registerTensor(value, name);
+    }
+    else
+    {
+        ctx->bindTensor(value, name);
+    }
+}
+
+// Node outputs are renamed when they are registered, so a value passed straight through from a node input must be
+// copied first.
+TensorOrWeights asNodeOutput(IImporterContext* ctx, TensorOrWeights value, const std::vector<TensorOrWeights>& inputs)
+{
+    for (const auto& input : inputs)
+    {
+        if (value.is_tensor() && input.is_tensor() && &value.tensor() == &input.tensor())
+        {
+            return identity(ctx, value);
+        }
+    }
+    return value;
+}
+
+// Stacks the per-iteration values of a scan output along a new axis.
+nvinfer1::ITensor* stackIterations(IImporterContext* ctx, const ::ONNX_NAMESPACE::NodeProto& node,
+    const std::vector<nvinfer1::ITensor*>& values, int axis)
+{
+    std::vector<nvinfer1::ITensor*> unsqueezed;
+    for (auto* value : values)
+    {
+        unsqueezed.push_back(unsqueezeTensor(ctx, node, *value, {axis}));
+    }
+    auto* concat = ctx->network()->addConcatenation(unsqueezed.data(), unsqueezed.size());
+    concat->setAxis(axis);
+    ctx->registerLayer(concat, getNodeName(node));
+    return concat->getOutput(0);
+}
+
+} // namespace
+
+NodeImportResult unrollLoop(IImporterContext* ctx, const ::ONNX_NAMESPACE::NodeProto& node,
+    std::vector<TensorOrWeights>& inputs, bool* unrolled)
+{
+    constexpr int NB_NON_STATE_INPUTS = 2;
+    constexpr int NB_DISCARDED_OUTPUTS = 1;
+    *unrolled = false;
+    OnnxAttrs attrs(node, ctx);
+    const ::ONNX_NAMESPACE::GraphProto& body = attrs.get<const ::ONNX_NAMESPACE::GraphProto&>("body");
+
+    int64_t tripCount{0};
+    if (!inputs.at(0) || !inputs.at(0).is_weights() || !getScalarWeight(inputs.at(0).weights(), &tripCount)
+        || tripCount < 1 || tripCount > ctx->getLoopUnrollLimit())
+    {
+        return std::vector<TensorOrWeights>{};
+    }
+    if (inputs.at(1))
+    {
+        int64_t cond{0};
+        if (!inputs.at(1).is_weights() || !getScalarWeight(inputs.at(1).weights(), &cond) || !cond
+            || !isConditionLoopInvariant(body))
+        {
+            return std::vector<TensorOrWeights>{};
+        }
+    }
+    *unrolled = true;
+    LOG_VERBOSE("Unrolling Loop node " << getNodeName(node) << " with " << tripCount << " iterations");
+
+    const int nbStateVars = node.input().size() - NB_NON_STATE_INPUTS;
+    const int nbScanOutputs = body.output_size() - NB_DISCARDED_OUTPUTS - nbStateVars;
+    std::vector<TensorOrWeights> stateVars(inputs.begin() + NB_NON_STATE_INPUTS, inputs.end());
+    std::vector<std::vector<nvinfer1::ITensor*>> scanValues(nbScanOutputs);
+
+    ShapedWeights cond = ctx->createTempWeights(::ONNX_NAMESPACE::TensorProto::BOOL, nvinfer1::Dims{0, {}});
+    *static_cast<uint8_t*>(cond.values) = 1;
+    for (int64_t iteration = 0; iteration < tripCount; ++iteration)
+    {
+        SubgraphScope scope(ctx);
+        ShapedWeights counter = ctx->createTempWeights(::ONNX_NAMESPACE::TensorProto::INT32, nvinfer1::Dims{0, {}});
+        *static_cast<int32_t*>(counter.values) = static_cast<int32_t>(iteration);
+        bindBodyInput(ctx, counter, body.input(0).name());
+        bindBodyInput(ctx, cond, body.input(1).name());
+        for (int i = 0; i < nbStateVars; ++i)
+        {
+            bindBodyInput(ctx, stateVars.at(i), body.input(i + NB_NON_STATE_INPUTS).name());
+        }
+
+        TRT_CHECK(onnx2trt::parseGraph(ctx, body));
+
+        // Read all outputs before the next iteration rebinds the inputs, since outputs may alias inputs.
+        for (int i = 0; i < nbStateVars; ++i)
+        {
+            stateVars.at(i) = ctx->tensors().at(body.output(i + NB_DISCARDED_OUTPUTS).name());
+        }
+        for (int i = 0; i < nbScanOutputs; ++i)
+        {
+            auto& scanOutput = ctx->tensors().at(body.output(i + NB_DISCARDED_OUTPUTS + nbStateVars).name());
+            scanValues.at(i).push_back(&convertToTensor(scanOutput, ctx));
+        }
+    }
+
+    std::vector<TensorOrWeights> nodeOutputs{};
+    for (auto& stateVar : stateVars)
+    {
+        nodeOutputs.emplace_back(asNodeOutput(ctx, stateVar, inputs));
+    }
+    for (const auto& values : scanValues)
+    {
+        nodeOutputs.emplace_back(stackIterations(ctx, node, values, 0));
+    }
+    return {nodeOutputs};
+}
+
+NodeImportResult unrollScan(IImporterContext* ctx, const ::ONNX_NAMESPACE::NodeProto& node,
+    std::vector<TensorOrWeights>& inputs, bool* unrolled)
+{
+    *unrolled = false;
+    // Opset 8 Scan also iterates over a batch axis, which is not handled here.
+    if (ctx->getOpsetVersion() < 9)
+    {
+        return std::vector<TensorOrWeights>{};
+    }
+    OnnxAttrs attrs(node, ctx);
+    const ::ONNX_NAMESPACE::GraphProto& body = attrs.get<const ::ONNX_NAMESPACE::GraphProto&>("body");
+    const int nbInputs = node.input().size();
+    const int nbScanInputs = attrs.get<int>("num_scan_inputs");
+    const int nbStateVars = nbInputs - nbScanInputs;
+    const int nbScanOutputs = node.output().size() - nbStateVars;
+    std::vector<int> scanInputAxes(attrs.get("scan_input_axes", std::vector<int>(nbScanInputs, 0)));
+    const std::vector<int> scanInputDirections(attrs.get("scan_input_directions", std::vector<int>(nbScanInputs, 0)));
+    const std::vector<int> scanOutputAxes(attrs.get("scan_output_axes", std::vector<int>(nbScanOutputs, 0)));
+    const std::vector<int> scanOutputDirections(
+        attrs.get("scan_output_directions", std::vector<int>(nbScanOutputs, 0)));
+
+    // All scan inputs have the same length, which must be known at parse time.
+    int tripCount{-1};
+    for (int i = 0; i < nbScanInputs; ++i)
+    {
+        const nvinfer1::Dims dims = inputs.at(nbStateVars + i).shape();
+        int& axis = scanInputAxes.at(i);
+        if (axis < 0)
+        {
+            axis += dims.nbDims;
+        }
+        if (axis < 0 || axis >= dims.nbDims || dims.d[axis] < 0)
+        {
+            return std::vector<TensorOrWeights>{};
+        }
+        tripCount = dims.d[axis];
+    }
+    if (tripCount < 1 || tripCount > ctx->getLoopUnrollLimit())
+    {
+        return std::vector<TensorOrWeights>{};
+    }
+    *unrolled = true;
+    LOG_VERBOSE("Unrolling Scan node " << getNodeName(node) << " with " << tripCount << " iterations");
+
+    std::vector<TensorOrWeights> stateVars(inputs.begin(), inputs.begin() + nbStateVars);
+    std::vector<nvinfer1::ITensor*> scanInputs;
+    for (int i = 0; i < nbScanInputs; ++i)
+    {
+        scanInputs.push_back(&convertToTensor(inputs.at(nbStateVars + i), ctx));
+    }
+    std::vector<std::vector<nvinfer1::ITensor*>> scanValues(nbScanOutputs);
+    for (int iteration = 0; iteration < tripCount; ++iteration)
+    {
+        SubgraphScope scope(ctx);
+        for (int i = 0; i < nbStateVars; ++i)
+        {
+            bindBodyInput(ctx, stateVars.at(i), body.input(i).name());
+        }
+        for (int i = 0; i < nbScanInputs; ++i)
+        {
+            const int index = scanInputDirections.at(i) == 1 ? tripCount - 1 - iteration : iteration;
+            auto* indexTensor = addConstantScalar(ctx, index, ::ONNX_NAMESPACE::TensorProto::INT32)->getOutput(0);
+            auto* gather = ctx->network()->addGather(*scanInputs.at(i), *indexTensor, scanInputAxes.at(i));
+            ctx->registerLayer(gather, getNodeName(node));
+            bindBodyInput(ctx, gather->getOutput(0), body.input(nbStateVars + i).name());
+        }
+
+        TRT_CHECK(onnx2trt::parseGraph(ctx, body));
+
+        for (int i = 0; i < nbStateVars; ++i)
+        {
+            stateVars.at(i) = ctx->tensors().at(body.output(i).name());
+        }
+        for (int i = 0; i < nbScanOutputs; ++i)
+        {
+            auto& scanOutput = ctx->tensors().at(body.output(nbStateVars + i).name());
+            scanValues.at(i).push_back(&convertToTensor(scanOutput, ctx));
+        }
+    }
+
+    std::vector<TensorOrWeights> nodeOutputs{};
+    for (auto& stateVar : stateVars)
+    {
+        nodeOutputs.emplace_back(asNodeOutput(ctx, stateVar, inputs));
+    }
+    for (int i = 0; i < nbScanOutputs; ++i)
+    {
+        std::vector<nvinfer1::ITensor*>& values = scanValues.at(i);
+        // For scan_output_directions, 1 indicates prepending each iteration's value.
+        if (scanOutputDirections.at(i) == 1)
+        {
+            std::reverse(values.begin(), values.end());
+        }
+        int axis = scanOutputAxes.at(i);
+        TRT_CHECK(convertAxis(axis, values.front()->getDimensions().nbDims + 1));
+        nodeOutputs.emplace_back(stackIterations(ctx, node, values, axis));
+    }
+    return {nodeOutputs};
+}
+
+nvinfer1::ITensor* inferLoopIterationBound(
+    IImporterContext* ctx, const ::ONNX_NAMESPACE::GraphProto& body, bool* exact)
+{
+    std::unordered_map<std::string, const ::ONNX_NAMESPACE::NodeProto*> producers;
+    for (const auto& node : body.node())
+    {
+        for (const auto& output : node.output())
+        {
+            producers[output] = &node;
+        }
+    }
+    const std::string& iteration = body.input(0).name();
+    auto isLoopInvariant = [&](const std::string& name) {
+        const auto& inputs = body.input();
+        return !producers.count(name)
+            && std::none_of(inputs.begin(), inputs.end(),
+                [&name](const ::ONNX_NAMESPACE::ValueInfoProto& input) { return input.name() == name; });
+    };
+    // Whether name is iteration + offset for a constant offset.
+    auto getIterationOffset = [&](const std::string& name, int64_t* offset) {
+        if (name == iteration)
+        {
+            *offset = 0;
+            return true;
+        }
+        const auto it = producers.find(name);
+        if (it == producers.end() || it->second->op_type() != "Add")
+        {
+            return false;
+        }
+        const auto& add = *it->second;
+        for (int i = 0; i < 2; ++i)
+        {
+            const auto other = ctx->tensors().find(add.input(1 - i));
+            if (add.input(i) == iteration && other != ctx->tensors().end() && other->second.is_weights()
+                && getScalarWeight(other->second.weights(), offset))
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Look through Identity and And for a comparison of the iteration number against a loop-invariant limit. Below an
+    // And, the comparison only bounds the number of iterations, since the other operand may end the loop earlier.
+    std::vector<std::pair<std::string, bool>> pending{{body.output(0).name(), true}};
+    while (!pending.empty())
+    {
+        const std::string name = pending.back().first;
+        const bool isExact = pending.back().second;
+        pending.pop_back();
+        const auto it = producers.find(name);
+        if (it == producers.end())
+        {
+            continue;
+        }
+        const auto& node = *it->second;
+        const std::string& op = node.op_type();
+        if (op == "Identity" || op == "And")
+        {
+            for (const auto& input : node.input())
+            {
+                pending.emplace_back(input, isExact && op == "Identity");
+            }
+            continue;
+        }
+        const bool less = op == "Less" || op == "LessOrEqual";
+        const bool greater = op == "Greater" || op == "GreaterOrEqual";
+        int64_t offset = 0;
+        if ((!less && !greater) || !getIterationOffset(node.input(less ? 0 : 1), &offset))
+        {
+            continue;
+        }
+        const std::string& limitName = node.input(less ? 1 : 0);
+        const auto limitIt = ctx->tensors().find(limitName);
+        if (!isLoopInvariant(limitName) || limitIt == ctx->tensors().end() || !limitIt->second.isInt32()
+            || volume(limitIt->second.shape()) != 1)
+        {
+            continue;
+        }
+        // Scan output lengths are shape tensors, so an INT32 network input used as the limit would have to be
+        // given as a shape input at runtime. Leave such loops to the configured default length instead.
+        if (limitIt->second.is_tensor() && limitIt->second.tensor().isNetworkInput())
+        {
+            continue;
+        }
+        // Iteration k runs if the condition computed by iteration k - 1 holds, i.e. k - 1 + offset < limit, so there
+        // are at most limit + 1 - offset iterations (one more for an inclusive comparison). Iteration 0 only depends
+        // on the initial condition, so there is at least one iteration however low the limit is.
+        const int64_t adjustment = 1 - offset + (op == "LessOrEqual" || op == "GreaterOrEqual");
+        *exact = isExact;
+        TensorOrWeights limit = limitIt->second;
+        int64_t limitValue = 0;
+        if (limit.is_weights() && getScalarWeight(limit.weights(), &limitValue))
+        {
+            return addConstantScalar(ctx, static_cast<int32_t>(std::max<int64_t>(limitValue + adjustment, 1)),
+                ::ONNX_NAMESPACE::TensorProto::INT32)
+                ->getOutput(0);
+        }
+        nvinfer1::ITensor* limitTensor = convertToScalar(ctx, &convertToTensor(limit, ctx));
+        nvinfer1::ITensor* adjustmentTensor
+            = addConstantScalar(ctx, static_cast<int32_t>(adjustment), ::ONNX_NAMESPACE::TensorProto::INT32)
+                  ->getOutput(0);
+        nvinfer1::ITensor* bound
+            = ctx->network()
+                  ->addElementWise(*limitTensor, *adjustmentTensor, nvinfer1::ElementWiseOperation::kSUM)
+                  ->getOutput(0);
+        nvinfer1::ITensor* one = addConstantScalar(ctx, 1, ::ONNX_NAMESPACE::TensorProto::INT32)->getOutput(0);
+        return ctx->network()->addElementWise(*bound, *one, nvinfer1::ElementWiseOperation::kMAX)->getOutput(0);
+    }
+    return nullptr;
+}
+
 } // namespace onnx2trt
@@ -31,4 +31,21 @@ namespace onnx2trt
 
 nvinfer1::ITensor* addLoopCounter(IImporterContext* ctx, nvinfer1::ILoop* loop, int32_t initial = 0);
 
+// Import a Loop node by instantiating its body once per iteration instead of building an ILoop. This requires a
+// constant trip count no larger than the context's unroll limit, and a condition that is absent or constant true.
+// *unrolled is set to false, with no layers added, when the node does not qualify.
+NodeImportResult unrollLoop(IImporterContext* ctx, const ::ONNX_NAMESPACE::NodeProto& node,
+    std::vector<TensorOrWeights>& inputs, bool* unrolled);
+
+// Same as above for Scan nodes, whose scan inputs must have a static length no larger than the unroll limit.
+NodeImportResult unrollScan(IImporterContext* ctx, const ::ONNX_NAMESPACE::NodeProto& node,
+    std::vector<TensorOrWeights>& inputs, bool* unrolled);
+
+// Returns an upper bound on the number of iterations of a Loop node without a trip count, as a scalar INT32 tensor,
+// when the condition output of its body compares the iteration number against a loop-invariant value that is not a
+// network input. *exact is set to whether the bound is the number of iterations, which it is not when the comparison
+// is combined with other conditions. Returns nullptr otherwise. Must be called after the body has been parsed.
+nvinfer1::ITensor* inferLoopIterationBound(
+    IImporterContext* ctx, const ::ONNX_NAMESPACE::GraphProto& body, bool* exact);
+
 } // namespace onnx2trt
@@ -21,6 +21,7 @@
  */
 
 #include "ModelImporter.hpp"
+#include "GraphPartitioner.hpp"
 #include "OnnxAttrs.hpp"
 #include "onnx2trt_utils.hpp"
 #include "onnx_utils.hpp"
@@ -29,7 +30,9 @@
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/text_format.h>
+#include <onnx/optimizer/optimize.h>
 
+#include <algorithm>
 #include <limits>
 #include <functional>
 #include <unordered_set>
@@ -97,6 +100,10 @@ Status parseGraph(IImporterContext* ctx, const ::ONNX_NAMESPACE::GraphProto& gra
     ASSERT(toposort(graph.node(), &topoOrder), ErrorCode::kINVALID_GRAPH);
 
     const string_map<NodeImporter>& opImporters = getBuiltinOpImporterMap();
+    const NodeImporter& fallbackImporter = opImporters.at("FallbackPluginImporter");
+    // Reused for every node, so that dispatching a node does not allocate once their capacity has grown.
+    std::vector<TensorOrWeights> nodeInputs;
+    std::vector<TensorOrWeights> outputs;
     for (const auto& nodeIndex : topoOrder)
     {
         if (currentNode)
@@ -107,7 +114,7 @@ Status parseGraph(IImporterContext* ctx, const ::ONNX_NAMESPACE::GraphProto& gra
         LOG_VERBOSE("Parsing node: " << node.name() << " [" << node.op_type() << "]");
 
         // Assemble node inputs. These may come from outside the subgraph.
-        std::vector<TensorOrWeights> nodeInputs;
+        nodeInputs.clear();
         std::stringstream ssInputs{};
         ssInputs << node.name() << " [" << node.op_type() << "] inputs: ";
         for (const auto& inputName : node.input())
@@ -121,26 +128,25 @@ Status parseGraph(IImporterContext* ctx, const ::ONNX_NAMESPACE::GraphProto& gra
             else
             {
                 LOG_VERBOSE("Searching for input: " << inputName);
-                ASSERT(ctx->tensors().count(inputName), ErrorCode::kINVALID_GRAPH);
-                nodeInputs.push_back(ctx->tensors().at(inputName));
+                const auto input = ctx->tensors().find(inputName);
+                ASSERT(input != ctx->tensors().end(), ErrorCode::kINVALID_GRAPH);
+                nodeInputs.push_back(input->second);
                 ssInputs << "[" << inputName << " -> " << nodeInputs.back().shape() << "], ";
             }
         }
         LOG_VERBOSE(ssInputs.str());
 
         // Dispatch to appropriate converter.
-        const NodeImporter* importFunc{nullptr};
-        if (opImporters.count(node.op_type()))
+        const NodeImporter* importFunc{&fallbackImporter};
+        const auto importer = opImporters.find(node.op_type());
+        if (importer != opImporters.end())
         {
-            importFunc = &opImporters.at(node.op_type());
+            importFunc = &importer->second;
         }
         else
         {
             LOG_INFO("No importer registered for op: " << node.op_type() << ". Attempting to import as plugin.");
-            importFunc = &opImporters.at("FallbackPluginImporter");
         }
-        std::vector<TensorOrWeights> outputs;
-
         GET_VALUE((*importFunc)(ctx, node, nodeInputs), &outputs);
 
         if (deserializingINetwork)
@@ -181,6 +187,12 @@ Status parseGraph(IImporterContext* ctx, const ::ONNX_NAMESPACE::GraphProto& gra
             }
         }
         LOG_VERBOSE(ssOutputs.str());
+
+        // Subgraph nodes belong to the top-level node that contains them.
+        if (currentNode)
+        {
+            ctx->updateShapeTensors(nodeIndex);
+        }
     }
     return Status::success();
 }
@@ -296,8 +308,9 @@ bool ModelImporter::supportsModel(
     void const* serialized_onnx_model, size_t serialized_onnx_model_size, SubGraphCollection_t& sub_graph_collection,
     const char* model_path)
 {
-
-    ::ONNX_NAMESPACE::ModelProto model;
+    // Note: We store the model so that weight arrays will persist
+    _onnx_models.emplace_back();
+    ::ONNX_NAMESPACE::ModelProto& model = _onnx_models.back();
     bool is_serialized_as_text = false;
     Status status
         = deserialize_onnx_model(serialized_onnx_model, serialized_onnx_model_size, is_serialized_as_text, &model);
@@ -308,6 +321,12 @@ bool ModelImporter::supportsModel(
         return false;
     }
 
+    return supportsModelProto(model, sub_graph_collection, model_path);
+}
+
+bool ModelImporter::supportsModelProto(
+    ::ONNX_NAMESPACE::ModelProto const& model, SubGraphCollection_t& sub_graph_collection, const char* model_path)
+{
     if (model_path)
     {
         _importer_ctx.setOnnxFileLocation(model_path);
@@ -316,7 +335,7 @@ bool ModelImporter::supportsModel(
     bool allSupported{true};
 
     // Parse the graph and see if we hit any parsing errors
-    allSupported = parse(serialized_onnx_model, serialized_onnx_model_size);
+    allSupported = importAndRecordErrors(model, 0, nullptr);
 
     int error_node = -1;
     std::string input_node{};
@@ -343,16 +362,26 @@ bool ModelImporter::supportsModel(
         }
     }
     auto* ctx = &_importer_ctx;
-    auto checkForInput = [&input_node, &ctx](::ONNX_NAMESPACE::NodeProto const& node) {
-        for (auto input : node.input())
-        {
-            if (input_node == input || ctx->loopTensors()[input_node] == input)
-            {
-                return true;
-            }
-        }
-        return false;
-    };
+    // Whether the node consumes input_node, either directly or from within one of its subgraphs.
+    std::function<bool(::ONNX_NAMESPACE::NodeProto const&)> checkForInput
+        = [&input_node, &checkForInput](::ONNX_NAMESPACE::NodeProto const& node) {
+              for (auto const& input : node.input())
+              {
+                  if (input_node == input)
+                  {
+                      return true;
+                  }
+              }
+              for (auto const& attr : node.attribute())
+              {
+                  if (attr.has_g()
+                      && std::any_of(attr.g().node().begin(), attr.g().node().end(), checkForInput))
+                  {
+                      return true;
+                  }
+              }
+              return false;
+          };
 
     auto checkShapeTensorType = [&ctx](::ONNX_NAMESPACE::NodeProto const& node){
         for (int i = 0; i < ctx->network()->getNbInputs(); i++)
@@ -376,7 +405,6 @@ bool ModelImporter::supportsModel(
         return false;
     };
 
-    bool newSubGraph(true);
     // Sort and partition supported subgraphs
     std::vector<size_t> topological_order;
     if (!toposort(model.graph().node(), &topological_order))
@@ -385,10 +413,13 @@ bool ModelImporter::supportsModel(
         return false;
     }
 
+    ::ONNX_NAMESPACE::GraphProto const& graph = model.graph();
+    PartitionGraph partitionGraphDesc;
+    partitionGraphDesc.supported.resize(graph.node_size());
     for (int node_idx : topological_order)
     {
-        ::ONNX_NAMESPACE::NodeProto const& node = model.graph().node(node_idx);
-        // Add the node to the subgraph if:
+        ::ONNX_NAMESPACE::NodeProto const& node = graph.node(node_idx);
+        // Add the node to a subgraph if:
         //     1. There is an importer function registered for the operator type
         //     2. It is not directly connected to an unsupported input
         //     3. It is not directly connected to an unsupported shape tensor input
@@ -397,35 +428,102 @@ bool ModelImporter::supportsModel(
         bool registered = supportsOperator(node.op_type().c_str());
         bool unsupportedInput = (input_node.empty()) ? false : checkForInput(node);
         bool unsupportedShapeType = checkShapeTensorType(node);
-        bool unsupportedShapeTensor = ctx->unsupportedShapeTensors().count(node.name()) > 0 ? true : false;
+        bool unsupportedShapeTensor = ctx->unsupportedShapeTensorNodes().count(node_idx) > 0;
         bool unsuccessfulParse = node_idx == error_node;
-        if (registered && !unsupportedInput && !unsupportedShapeType && !unsupportedShapeTensor && !unsuccessfulParse)
+        const bool supported
+            = registered && !unsupportedInput && !unsupportedShapeType && !unsupportedShapeTensor && !unsuccessfulParse;
+        partitionGraphDesc.supported[node_idx] = supported;
+        allSupported = allSupported && supported;
+    }
+
+    if (allSupported)
+    {
+        // Only mark the subgraph as supported if there is one supported subgraph.
+        sub_graph_collection.emplace_back(std::vector<size_t>(topological_order.begin(), topological_order.end()), true);
+        return true;
+    }
+
+    // Sizes of the tensors crossing partition boundaries, taken from the network when the importer got that far and
+    // from the model's shape annotations otherwise. Dynamic dimensions count as 1.
+    std::unordered_map<std::string, ::ONNX_NAMESPACE::ValueInfoProto const*> valueInfos;
+    for (auto const& info : graph.value_info())
+    {
+        valueInfos[info.name()] = &info;
+    }
+    for (auto const& info : graph.output())
+    {
+        valueInfos[info.name()] = &info;
+    }
+    auto estimateBytes = [&](std::string const& name) -> int64_t {
+        const auto tensorIt = ctx->tensors().find(name);
+        if (tensorIt != ctx->tensors().end() && tensorIt->second.is_tensor() && !tensorIt->second.isNullTensor())
         {
-            if (newSubGraph)
+            nvinfer1::ITensor& tensor = tensorIt->second.tensor();
+            nvinfer1::Dims dims = tensor.getDimensions();
+            for (int i = 0; i < dims.nbDims; ++i)
             {
-                // If it is the beginning of a new subGraph, we start a new vector
-                sub_graph_collection.emplace_back();
-                // Mark all new graphs as "unknown"
-                sub_graph_collection.back().second = false;
-                newSubGraph = false;
+                dims.d[i] = std::max(dims.d[i], 1);
             }
-            // We add the new node to the last graph
-            sub_graph_collection.back().first.emplace_back(node_idx);
+            return tensorBytes(dims, tensor.getType());
         }
-        else
+        const auto infoIt = valueInfos.find(name);
+        if (infoIt != valueInfos.end() && infoIt->second->type().has_tensor_type())
+        {
+            auto const& tensorType = infoIt->second->type().tensor_type();
+            int64_t bytes = std::max(getDtypeSize(tensorType.elem_type()), 1);
+            for (auto const& dim : tensorType.shape().dim())
+            {
+                bytes *= std::max<int64_t>(dim.dim_value(), 1);
+            }
+            return bytes;
+        }
+        return sizeof(float);
+    };
+
+    std::unordered_map<std::string, size_t> tensorIndices;
+    for (int node_idx = 0; node_idx < graph.node_size(); ++node_idx)
+    {
+        for (auto const& output : graph.node(node_idx).output())
         {
-            // This is not a supported node, reset newSubGraph
-            newSubGraph = true;
-            allSupported = false;
+            if (output.empty())
+            {
+                continue;
+            }
+            tensorIndices[output] = partitionGraphDesc.tensors.size();
+            PartitionTensor tensor;
+            tensor.producer = node_idx;
+            tensor.bytes = estimateBytes(output);
+            partitionGraphDesc.tensors.push_back(tensor);
         }
     }
+    for (int node_idx = 0; node_idx < graph.node_size(); ++node_idx)
+    {
+        // A tensor read several times by the same node has it as a consumer once.
+        auto addConsumer = [&](std::string const& input) {
+            const auto it = tensorIndices.find(input);
+            if (it != tensorIndices.end())
+            {
+                std::vector<size_t>& consumers = partitionGraphDesc.tensors[it->second].consumers;
+                if (consumers.empty() || consumers.back() != static_cast<size_t>(node_idx))
+                {
+                    consumers.push_back(node_idx);
+                }
+            }
+        };
+        for (auto const& input : graph.node(node_idx).input())
+        {
+            addConsumer(input);
+        }
+        // Values read by subgraphs of the node count as inputs, so that they are edges of the partition graph too.
+        for_each_outer_scope_input(graph.node(node_idx), addConsumer);
+    }
 
-    // Only mark the subgraph as supported if there is one supported subgraph.
-    if (allSupported)
+    for (auto& partition : partitionGraph(partitionGraphDesc, topological_order))
     {
-        sub_graph_collection.back().second = true;
+        // Mark all new graphs as "unknown"
+        sub_graph_collection.emplace_back(std::move(partition), false);
     }
-    return allSupported;
+    return false;
 }
 
 bool ModelImporter::supportsOperator(const char* op_name) const
@@ -450,7 +548,19 @@ bool ModelImporter::parseWithWeightDescriptors(void const* serialized_onnx_model
         _errors.push_back(status);
         return false;
     }
-    status = this->importModel(model, weight_count, weight_descriptors);
+    if (!_optimization_passes.empty())
+    {
+        ::ONNX_NAMESPACE::ModelProto optimized = optimizeModel(model);
+        model.Swap(&optimized);
+    }
+    return importAndRecordErrors(model, weight_count, weight_descriptors);
+}
+
+bool ModelImporter::importAndRecordErrors(
+    ::ONNX_NAMESPACE::ModelProto const& model, uint32_t weight_count, onnxTensorDescriptorV1 const* weight_descriptors)
+{
+    _current_node = -1;
+    Status status = this->importModel(model, weight_count, weight_descriptors);
     if (status.is_error())
     {
         status.setNode(_current_node);
@@ -460,47 +570,77 @@ bool ModelImporter::parseWithWeightDescriptors(void const* serialized_onnx_model
     return true;
 }
 
-bool ModelImporter::parse(void const* serialized_onnx_model, size_t serialized_onnx_model_size, const char* model_path)
+bool ModelImporter::parseModelProto(::ONNX_NAMESPACE::ModelProto const& model, const char* model_path)
 {
     if (model_path)
     {
         _importer_ctx.setOnnxFileLocation(model_path);
     }
-    return this->parseWithWeightDescriptors(serialized_onnx_model, serialized_onnx_model_size, 0, nullptr);
+    if (!_optimization_passes.empty())
+    {
+        // Note: We store the optimized model so that weight arrays will persist
+        _onnx_models.push_back(optimizeModel(model));
+        return importAndRecordErrors(_onnx_models.back(), 0, nullptr);
+    }
+    return importAndRecordErrors(model, 0, nullptr);
 }
 
-void removeShapeTensorCasts(IImporterContext* ctx)
+::ONNX_NAMESPACE::ModelProto ModelImporter::optimizeModel(::ONNX_NAMESPACE::ModelProto const& model) const
 {
-    // Removes any casts on shape tensors, as TensorRT does not support them.
-    for (int i = 0, e = ctx->network()->getNbLayers(); i < e; ++i)
-    {
-        nvinfer1::ILayer* layer = ctx->network()->getLayer(i);
-        if (layer->getNbOutputs() > 0 && layer->getOutput(0)->isShapeTensor())
-        {
-            layer->resetOutputType(0);
-            nvinfer1::ITensor& t = *layer->getOutput(0);
-            // Assume that boolean tensors were not cast, and thus have their type correctly set.
-            const nvinfer1::DataType shapeTensorType = t.getType() == nvinfer1::DataType::kBOOL ? nvinfer1::DataType::kBOOL : nvinfer1::DataType::kINT32;
-            layer->setOutputType(0, shapeTensorType);
-            // Set type only if necessary, to avoid TensorRT warnings
-            // about setting type of non-input/output tensors.
-            if (t.getType() != shapeTensorType)
-            {
-                t.setType(shapeTensorType);
-            }
-            // Some layers do not support shape tensor outputs. Keep track of these tensor names
-            // for supportsModel().
-            auto type = layer->getType();
-            auto elementwiseOp = type == nvinfer1::LayerType::kELEMENTWISE ? (static_cast<nvinfer1::IElementWiseLayer*>(layer))->getOperation() : nvinfer1::ElementWiseOperation::kSUM;
-            auto reduceOp = type == nvinfer1::LayerType::kREDUCE ? (static_cast<nvinfer1::IReduceLayer*>(layer))->getOperation() : nvinfer1::ReduceOperation::kSUM;
-            if (!supportsShapeTensor(type, elementwiseOp, reduceOp))
-            {
-                auto name = layer->getName();
-                ctx->unsupportedShapeTensors().insert(name);
-                LOG_ERROR("Found unsupported shape tensor producing layer: " << name);
-            }
+    return _optimize_fixed_point ? ::ONNX_NAMESPACE::optimization::OptimizeFixed(model, _optimization_passes)
+                                 : ::ONNX_NAMESPACE::optimization::Optimize(model, _optimization_passes);
+}
+
+bool ModelImporter::setOptimizationPasses(const char* passes, bool fixedPoint)
+{
+    auto* ctx = &_importer_ctx;
+    const std::vector<std::string> available = ::ONNX_NAMESPACE::optimization::GetAvailablePasses();
+    std::vector<std::string> selected;
+    std::stringstream passStream(passes ? passes : "");
+    for (std::string pass; std::getline(passStream, pass, ';');)
+    {
+        if (pass.empty())
+        {
+            continue;
+        }
+        if (std::find(available.begin(), available.end(), pass) == available.end())
+        {
+            LOG_ERROR("Unknown ONNX optimization pass: " << pass);
+            return false;
+        }
+        selected.push_back(pass);
+    }
+    _optimization_passes = std::move(selected);
+    _optimize_fixed_point = fixedPoint;
+    return true;
+}
+
+int64_t ModelImporter::estimateActivationMemory(
+    nvinfer1::IOptimizationProfile const* profile, const char** peakTensorNames, int* nbPeakTensors)
+{
+    _activation_memory_plan = planActivationMemory(*_importer_ctx.network(), profile);
+    const auto& plan = _activation_memory_plan;
+    if (nbPeakTensors != nullptr)
+    {
+        *nbPeakTensors = static_cast<int>(plan.peakTensors.size());
+    }
+    if (peakTensorNames != nullptr)
+    {
+        for (size_t i = 0; i < plan.peakTensors.size(); ++i)
+        {
+            peakTensorNames[i] = plan.tensors[plan.peakTensors[i]].name.c_str();
         }
     }
+    return plan.peakBytes;
+}
+
+bool ModelImporter::parse(void const* serialized_onnx_model, size_t serialized_onnx_model_size, const char* model_path)
+{
+    if (model_path)
+    {
+        _importer_ctx.setOnnxFileLocation(model_path);
+    }
+    return this->parseWithWeightDescriptors(serialized_onnx_model, serialized_onnx_model_size, 0, nullptr);
 }
 
 Status ModelImporter::importModel(
@@ -524,6 +664,13 @@ Status ModelImporter::importModel(
         _importer_ctx.addOpset(domain, version);
     }
     ::ONNX_NAMESPACE::GraphProto const& graph = model.graph();
+    size_t nbTensors = graph.input_size() + graph.initializer_size();
+    for (const auto& node : graph.node())
+    {
+        nbTensors += node.output_size();
+    }
+    // Most nodes become a single layer, and every initializer may become a constant layer.
+    _importer_ctx.reserveNames(nbTensors, graph.node_size() + graph.initializer_size());
     // Create a dummy tensors so that we can reserve output names. If the output names are encountered elsewhere
     // in the graph, the ctx will know to make the names unique.
     for (const ::ONNX_NAMESPACE::ValueInfoProto& output : graph.output())
@@ -649,14 +796,16 @@ Status ModelImporter::importModel(
         }
     }
 
-    removeShapeTensorCasts(ctx);
+    _importer_ctx.finalizeShapeTensors();
     return Status::success();
 }
 
 bool ModelImporter::parseFromFile(const char* onnxModelFile, int32_t verbosity)
 {
     GOOGLE_PROTOBUF_VERIFY_VERSION;
-    ::ONNX_NAMESPACE::ModelProto onnx_model;
+    // Note: We store the model so that weight arrays will persist
+    _onnx_models.emplace_back();
+    ::ONNX_NAMESPACE::ModelProto& onnx_model = _onnx_models.back();
     auto* ctx = &_importer_ctx;
 
     const bool is_binary = ParseFromFile_WAR(&onnx_model, onnxModelFile);
@@ -666,9 +815,6 @@ bool ModelImporter::parseFromFile(const char* onnxModelFile, int32_t verbosity)
         return false;
     }
 
-    // Keep track of the absolute path to the ONNX file.
-    _importer_ctx.setOnnxFileLocation(onnxModelFile);
-
     const int64_t opset_version = (onnx_model.opset_import().size() ? onnx_model.opset_import(0).version() : 0);
     LOG_INFO("----------------------------------------------------------------");
     LOG_INFO("Input filename:   " << onnxModelFile);
@@ -681,36 +827,34 @@ bool ModelImporter::parseFromFile(const char* onnxModelFile, int32_t verbosity)
     LOG_INFO("Doc string:       " << onnx_model.doc_string());
     LOG_INFO("----------------------------------------------------------------");
 
-    { //...Read input file, parse it
-        std::ifstream onnx_file(onnxModelFile, std::ios::binary | std::ios::ate);
-        const std::streamsize file_size = onnx_file.tellg();
-        onnx_file.seekg(0, std::ios::beg);
-        std::vector<char> onnx_buf(file_size);
-        if (!onnx_file.read(onnx_buf.data(), onnx_buf.size()))
-        {
-            LOG_ERROR("Failed to read from file: " << onnxModelFile);
-            return false;
-        }
-        if (!parse(onnx_buf.data(), onnx_buf.size()))
+    if (!_optimization_passes.empty())
+    {
+        ::ONNX_NAMESPACE::ModelProto optimized = optimizeModel(onnx_model);
+        onnx_model.Swap(&optimized);
+    }
+
+    // Import the model that was just deserialized instead of reading and parsing the file a second time.
+    // The file location is kept track of for external weights.
+    _importer_ctx.setOnnxFileLocation(onnxModelFile);
+    if (!importAndRecordErrors(onnx_model, 0, nullptr))
+    {
+        const int32_t nerror = getNbErrors();
+        for (int32_t i = 0; i < nerror; ++i)
         {
-            const int32_t nerror = getNbErrors();
-            for (int32_t i = 0; i < nerror; ++i)
+            nvonnxparser::IParserError const* error = getError(i);
+            if (error->node() != -1)
             {
-                nvonnxparser::IParserError const* error = getError(i);
-                if (error->node() != -1)
-                {
-                    ::ONNX_NAMESPACE::NodeProto const& node = onnx_model.graph().node(error->node());
-                    LOG_ERROR("While parsing node number " << error->node() << " [" << node.op_type() << " -> \"" << node.output(0) << "\"" << "]:");
-                    LOG_ERROR("--- Begin node ---");
-                    LOG_ERROR(pretty_print_onnx_to_string(node));
-                    LOG_ERROR("--- End node ---");
-                }
-                LOG_ERROR("ERROR: " << error->file() << ":" << error->line() << " In function " << error->func() << ":\n"
-                     << "[" << static_cast<int>(error->code()) << "] " << error->desc());
+                ::ONNX_NAMESPACE::NodeProto const& node = onnx_model.graph().node(error->node());
+                LOG_ERROR("While parsing node number " << error->node() << " [" << node.op_type() << " -> \"" << node.output(0) << "\"" << "]:");
+                LOG_ERROR("--- Begin node ---");
+                LOG_ERROR(pretty_print_onnx_to_string(node));
+                LOG_ERROR("--- End node ---");
             }
-            return false;
+            LOG_ERROR("ERROR: " << error->file() << ":" << error->line() << " In function " << error->func() << ":\n"
+                 << "[" << static_cast<int>(error->code()) << "] " << error->desc());
         }
-    } //...End Reading input file, parsing it
+        return false;
+    }
     return true;
 }
 
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "ImporterContext.hpp"
+#include "NetworkAnalysis.hpp"
 #include "NvInferPlugin.h"
 #include "NvOnnxParser.h"
 #include "builtin_op_importers.hpp"
@@ -47,6 +48,14 @@ private:
     std::list<::ONNX_NAMESPACE::ModelProto> _onnx_models; // Needed for ownership of weights
     int _current_node;
     std::vector<Status> _errors;
+    std::vector<std::string> _optimization_passes;
+    bool _optimize_fixed_point{false};
+    ActivationMemoryPlan _activation_memory_plan; // Owns the names returned by estimateActivationMemory
+
+    ::ONNX_NAMESPACE::ModelProto optimizeModel(::ONNX_NAMESPACE::ModelProto const& model) const;
+
+    bool importAndRecordErrors(::ONNX_NAMESPACE::ModelProto const& model, uint32_t weight_count,
+        onnxTensorDescriptorV1 const* weight_descriptors);
 
 public:
     ModelImporter(nvinfer1::INetworkDefinition* network, nvinfer1::ILogger* logger)
@@ -60,6 +69,12 @@ public:
     bool supportsModel(void const* serialized_onnx_model, size_t serialized_onnx_model_size,
         SubGraphCollection_t& sub_graph_collection, const char* model_path = nullptr) override;
 
+    // Variants of parse() and supportsModel() for callers that already hold a deserialized model, e.g. to
+    // print it as well. The model is not copied, so it must outlive the network definition.
+    bool parseModelProto(::ONNX_NAMESPACE::ModelProto const& model, const char* model_path = nullptr);
+    bool supportsModelProto(::ONNX_NAMESPACE::ModelProto const& model, SubGraphCollection_t& sub_graph_collection,
+        const char* model_path = nullptr);
+
     bool supportsOperator(const char* op_name) const override;
     void destroy() override
     {
@@ -109,6 +124,17 @@ public:
     }
     //...LG: Move the implementation to .cpp
     bool parseFromFile(const char* onnxModelFile, int verbosity) override;
+    bool setOptimizationPasses(const char* passes, bool fixedPoint = false) override;
+    void setLoopUnrollLimit(int maxTripCount) override
+    {
+        _importer_ctx.setLoopUnrollLimit(maxTripCount);
+    }
+    void setMaxScanOutputLength(int length, const char* nodeNamePattern = nullptr) override
+    {
+        _importer_ctx.setMaxScanOutputLength(length, nodeNamePattern);
+    }
+    int64_t estimateActivationMemory(
+        nvinfer1::IOptimizationProfile const* profile, const char** peakTensorNames, int* nbPeakTensors) override;
 };
 
 } // namespace onnx2trt
@@ -0,0 +1,858 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "NetworkAnalysis.hpp"
+#include "trt_utils.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <queue>
+#include <set>
+#include <sstream>
+
+namespace onnx2trt
+{
+
+namespace
+{
+
+int64_t dimsVolume(nvinfer1::Dims const& dims)
+{
+    int64_t v = 1;
+    for (int i = 0; i < dims.nbDims; ++i)
+    {
+        v *= std::max(dims.d[i], 0);
+    }
+    return v;
+}
+
+int64_t weightsBytes(nvinfer1::Weights const& weights)
+{
+    return weights.count * std::max(getDtypeSize(weights.type), 0);
+}
+
+std::string dimsString(nvinfer1::Dims const& dims)
+{
+    std::ostringstream ss;
+    ss << "(";
+    for (int i = 0; i < dims.nbDims; ++i)
+    {
+        ss << (i ? ", " : "");
+        if (dims.d[i] < 0)
+        {
+            ss << "?";
+        }
+        else
+        {
+            ss << dims.d[i];
+        }
+    }
+    ss << ")";
+    return ss.str();
+}
+
+// Human-readable count with a metric suffix, e.g. 1.23G.
+std::string metric(int64_t value)
+{
+    const char* suffixes[] = {"", "K", "M", "G", "T", "P"};
+    double v = static_cast<double>(value);
+    int i = 0;
+    while (v >= 1000. && i < 5)
+    {
+        v /= 1000.;
+        ++i;
+    }
+    std::ostringstream ss;
+    ss << std::setprecision(3) << v << suffixes[i];
+    return ss.str();
+}
+
+void estimateLayerCost(nvinfer1::ILayer* layer, LayerCost& cost)
+{
+    const int64_t outVolume = cost.outputShapes.empty() ? 0 : dimsVolume(cost.outputShapes[0]);
+    const int64_t inVolume = cost.inputShapes.empty() ? 0 : dimsVolume(cost.inputShapes[0]);
+
+    switch (layer->getType())
+    {
+    case nvinfer1::LayerType::kCONVOLUTION:
+    {
+        auto* conv = static_cast<nvinfer1::IConvolutionLayer*>(layer);
+        const nvinfer1::Dims kernel = conv->getKernelSizeNd();
+        const nvinfer1::Dims& input = cost.inputShapes[0];
+        const int64_t cin = input.nbDims > 1 ? std::max(input.d[1], 1) : 1;
+        cost.macs = outVolume * (cin / std::max(conv->getNbGroups(), 1)) * dimsVolume(kernel);
+        cost.flops = 2 * cost.macs + (conv->getBiasWeights().count ? outVolume : 0);
+        cost.weightBytes = weightsBytes(conv->getKernelWeights()) + weightsBytes(conv->getBiasWeights());
+        break;
+    }
+    case nvinfer1::LayerType::kDECONVOLUTION:
+    {
+        auto* deconv = static_cast<nvinfer1::IDeconvolutionLayer*>(layer);
+        const int64_t groups = std::max(deconv->getNbGroups(), 1);
+        cost.macs = inVolume * (deconv->getNbOutputMaps() / groups) * dimsVolume(deconv->getKernelSizeNd());
+        cost.flops = 2 * cost.macs + (deconv->getBiasWeights().count ? outVolume : 0);
+        cost.weightBytes = weightsBytes(deconv->getKernelWeights()) + weightsBytes(deconv->getBiasWeights());
+        break;
+    }
+    case nvinfer1::LayerType::kFULLY_CONNECTED:
+    {
+        auto* fc = static_cast<nvinfer1::IFullyConnectedLayer*>(layer);
+        const int64_t k = fc->getKernelWeights().count / std::max(fc->getNbOutputChannels(), 1);
+        cost.macs = outVolume * k;
+        cost.flops = 2 * cost.macs + (fc->getBiasWeights().count ? outVolume : 0);
+        cost.weightBytes = weightsBytes(fc->getKernelWeights()) + weightsBytes(fc->getBiasWeights());
+        break;
+    }
+    case nvinfer1::LayerType::kMATRIX_MULTIPLY:
+    {
+        auto* mm = static_cast<nvinfer1::IMatrixMultiplyLayer*>(layer);
+        const nvinfer1::Dims& a = cost.inputShapes[0];
+        int64_t k = 1;
+        if (a.nbDims >= 1)
+        {
+            const auto op = mm->getOperation(0);
+            const bool transposed = op == nvinfer1::MatrixOperation::kTRANSPOSE && a.nbDims >= 2;
+            k = a.d[transposed ? a.nbDims - 2 : a.nbDims - 1];
+        }
+        cost.macs = outVolume * k;
+        cost.flops = 2 * cost.macs;
+        break;
+    }
+    case nvinfer1::LayerType::kSCALE:
+    {
+        auto* scale = static_cast<nvinfer1::IScaleLayer*>(layer);
+        const nvinfer1::Weights shift = scale->getShift();
+        const nvinfer1::Weights s = scale->getScale();
+        const nvinfer1::Weights power = scale->getPower();
+        cost.flops = outVolume * ((shift.count ? 1 : 0) + (s.count ? 1 : 0) + (power.count ? 1 : 0));
+        cost.macs = shift.count && s.count ? outVolume : 0;
+        cost.weightBytes = weightsBytes(shift) + weightsBytes(s) + weightsBytes(power);
+        break;
+    }
+    case nvinfer1::LayerType::kPOOLING:
+    {
+        auto* pool = static_cast<nvinfer1::IPoolingLayer*>(layer);
+        cost.flops = outVolume * dimsVolume(pool->getWindowSizeNd());
+        break;
+    }
+    case nvinfer1::LayerType::kREDUCE:
+    case nvinfer1::LayerType::kTOPK: cost.flops = inVolume; break;
+    case nvinfer1::LayerType::kSOFTMAX:
+    case nvinfer1::LayerType::kRAGGED_SOFTMAX:
+        // max, subtract, exp, sum and divide
+        cost.flops = 5 * inVolume;
+        break;
+    case nvinfer1::LayerType::kLRN:
+    {
+        auto* lrn = static_cast<nvinfer1::ILRNLayer*>(layer);
+        cost.flops = outVolume * (2 * lrn->getWindowSize() + 3);
+        break;
+    }
+    case nvinfer1::LayerType::kELEMENTWISE:
+    case nvinfer1::LayerType::kACTIVATION:
+    case nvinfer1::LayerType::kUNARY:
+    case nvinfer1::LayerType::kPARAMETRIC_RELU:
+    case nvinfer1::LayerType::kSELECT: cost.flops = outVolume; break;
+    case nvinfer1::LayerType::kRESIZE:
+        // Roughly one multiply-add per interpolated spatial axis for each output.
+        cost.flops = outVolume * 2 * std::max(cost.outputShapes[0].nbDims - 2, 1);
+        break;
+    case nvinfer1::LayerType::kCONSTANT:
+        cost.weightBytes = weightsBytes(static_cast<nvinfer1::IConstantLayer*>(layer)->getWeights());
+        break;
+    default:
+        // Data movement (shuffle, concat, slice, gather, ...), control flow and plugins: no arithmetic is counted.
+        break;
+    }
+}
+
+bool isResolved(nvinfer1::Dims const& dims)
+{
+    return std::all_of(dims.d, dims.d + std::max(dims.nbDims, 0), [](int d) { return d >= 0; });
+}
+
+// Broadcasts the same-rank dimensions of inputs[first, last). A known dimension other than 1 determines the result;
+// otherwise the result is 1 if all dimensions are known, and unknown if one of them may be broadcast.
+nvinfer1::Dims broadcastDims(std::vector<nvinfer1::Dims> const& inputs, size_t first, size_t last)
+{
+    nvinfer1::Dims out = inputs[first];
+    for (int k = 0; k < out.nbDims; ++k)
+    {
+        bool allKnown = true;
+        int value = 1;
+        for (size_t i = first; i < last; ++i)
+        {
+            const int d = inputs[i].nbDims == out.nbDims ? inputs[i].d[k] : -1;
+            allKnown = allKnown && d >= 0;
+            value = d > 1 ? d : value;
+        }
+        out.d[k] = value > 1 || allKnown ? value : -1;
+    }
+    return out;
+}
+
+// Output length of a convolution or pooling window sliding over an axis of length size, or -1 if size is unknown.
+int windowOutputSize(int size, int kernel, int stride, int dilation, int prePadding, int postPadding,
+    nvinfer1::PaddingMode mode)
+{
+    if (size < 0)
+    {
+        return -1;
+    }
+    stride = std::max(stride, 1);
+    switch (mode)
+    {
+    case nvinfer1::PaddingMode::kSAME_UPPER:
+    case nvinfer1::PaddingMode::kSAME_LOWER: return (size + stride - 1) / stride;
+    case nvinfer1::PaddingMode::kEXPLICIT_ROUND_UP:
+    case nvinfer1::PaddingMode::kCAFFE_ROUND_UP:
+        return (size + prePadding + postPadding - dilation * (kernel - 1) - 1 + stride - 1) / stride + 1;
+    default: return (size + prePadding + postPadding - dilation * (kernel - 1) - 1) / stride + 1;
+    }
+}
+
+// Infers the dimensions of a layer output from the resolved dimensions of its inputs, for the layer types whose
+// output shape is a function of their input shapes and parameters. Returns false for all other layers.
+bool inferOutputDims(nvinfer1::ILayer* layer, std::vector<nvinfer1::Dims> const& inputs, nvinfer1::Dims& out)
+{
+    if (inputs.empty() || inputs[0].nbDims < 0)
+    {
+        return false;
+    }
+    nvinfer1::Dims const& in = inputs[0];
+    switch (layer->getType())
+    {
+    case nvinfer1::LayerType::kACTIVATION:
+    case nvinfer1::LayerType::kUNARY:
+    case nvinfer1::LayerType::kSCALE:
+    case nvinfer1::LayerType::kSOFTMAX:
+    case nvinfer1::LayerType::kRAGGED_SOFTMAX:
+    case nvinfer1::LayerType::kLRN:
+    case nvinfer1::LayerType::kIDENTITY:
+    case nvinfer1::LayerType::kPARAMETRIC_RELU: out = in; return true;
+    case nvinfer1::LayerType::kELEMENTWISE:
+    case nvinfer1::LayerType::kSELECT: out = broadcastDims(inputs, 0, inputs.size()); return true;
+    case nvinfer1::LayerType::kSHUFFLE:
+    {
+        auto* shuffle = static_cast<nvinfer1::IShuffleLayer*>(layer);
+        // Reshape dimensions given as a tensor are only known at runtime.
+        if (inputs.size() > 1)
+        {
+            return false;
+        }
+        nvinfer1::Dims transposed = in;
+        const nvinfer1::Permutation first = shuffle->getFirstTranspose();
+        for (int k = 0; k < in.nbDims; ++k)
+        {
+            transposed.d[k] = in.d[first.order[k]];
+        }
+        // Reshape dimensions are unset (nbDims == -1) for a pure transpose. Otherwise 0 copies the input dimension
+        // and -1 takes the remaining volume.
+        const nvinfer1::Dims spec = shuffle->getReshapeDimensions();
+        nvinfer1::Dims reshaped = spec.nbDims < 0 ? transposed : spec;
+        int inferred = -1;
+        for (int k = 0; k < spec.nbDims; ++k)
+        {
+            if (spec.d[k] == 0)
+            {
+                reshaped.d[k] = k < transposed.nbDims ? transposed.d[k] : -1;
+            }
+            else if (spec.d[k] == -1)
+            {
+                inferred = k;
+            }
+        }
+        if (inferred >= 0)
+        {
+            bool allKnown = true;
+            int64_t volume = 1;
+            int64_t known = 1;
+            for (int k = 0; k < transposed.nbDims; ++k)
+            {
+                allKnown = allKnown && transposed.d[k] >= 0;
+                volume *= transposed.d[k];
+            }
+            for (int k = 0; k < reshaped.nbDims; ++k)
+            {
+                if (k != inferred)
+                {
+                    allKnown = allKnown && reshaped.d[k] >= 0;
+                    known *= reshaped.d[k];
+                }
+            }
+            reshaped.d[inferred] = allKnown && known > 0 ? static_cast<int>(volume / known) : -1;
+        }
+        out = reshaped;
+        const nvinfer1::Permutation second = shuffle->getSecondTranspose();
+        for (int k = 0; k < reshaped.nbDims; ++k)
+        {
+            out.d[k] = reshaped.d[second.order[k]];
+        }
+        return true;
+    }
+    case nvinfer1::LayerType::kMATRIX_MULTIPLY:
+    {
+        auto* mm = static_cast<nvinfer1::IMatrixMultiplyLayer*>(layer);
+        const nvinfer1::MatrixOperation opA = mm->getOperation(0);
+        const nvinfer1::MatrixOperation opB = mm->getOperation(1);
+        if (inputs.size() < 2 || opA == nvinfer1::MatrixOperation::kVECTOR
+            || opB == nvinfer1::MatrixOperation::kVECTOR || in.nbDims < 2 || inputs[1].nbDims != in.nbDims)
+        {
+            return false;
+        }
+        nvinfer1::Dims const& b = inputs[1];
+        const int rank = in.nbDims;
+        out = broadcastDims(inputs, 0, 2);
+        out.d[rank - 2] = in.d[opA == nvinfer1::MatrixOperation::kTRANSPOSE ? rank - 1 : rank - 2];
+        out.d[rank - 1] = b.d[opB == nvinfer1::MatrixOperation::kTRANSPOSE ? rank - 2 : rank - 1];
+        return true;
+    }
+    case nvinfer1::LayerType::kCONCATENATION:
+    {
+        const int axis = static_cast<nvinfer1::IConcatenationLayer*>(layer)->getAxis();
+        out = in;
+        if (axis < 0 || axis >= out.nbDims)
+        {
+            return false;
+        }
+        for (size_t i = 1; i < inputs.size(); ++i)
+        {
+            const int d = inputs[i].nbDims == out.nbDims ? inputs[i].d[axis] : -1;
+            out.d[axis] = out.d[axis] >= 0 && d >= 0 ? out.d[axis] + d : -1;
+        }
+        return true;
+    }
+    case nvinfer1::LayerType::kCONVOLUTION:
+    {
+        auto* conv = static_cast<nvinfer1::IConvolutionLayer*>(layer);
+        const nvinfer1::Dims kernel = conv->getKernelSizeNd();
+        const nvinfer1::Dims stride = conv->getStrideNd();
+        const nvinfer1::Dims dilation = conv->getDilationNd();
+        const nvinfer1::Dims pre = conv->getPrePadding();
+        const nvinfer1::Dims post = conv->getPostPadding();
+        out = in;
+        out.d[1] = conv->getNbOutputMaps();
+        for (int k = 0; k < kernel.nbDims && k + 2 < out.nbDims; ++k)
+        {
+            out.d[k + 2] = windowOutputSize(in.d[k + 2], kernel.d[k], stride.d[k], dilation.d[k], pre.d[k], post.d[k],
+                conv->getPaddingMode());
+        }
+        return true;
+    }
+    case nvinfer1::LayerType::kPOOLING:
+    {
+        auto* pool = static_cast<nvinfer1::IPoolingLayer*>(layer);
+        const nvinfer1::Dims window = pool->getWindowSizeNd();
+        const nvinfer1::Dims stride = pool->getStrideNd();
+        const nvinfer1::Dims pre = pool->getPrePadding();
+        const nvinfer1::Dims post = pool->getPostPadding();
+        out = in;
+        for (int k = 0; k < window.nbDims && k + 2 < out.nbDims; ++k)
+        {
+            out.d[k + 2] = windowOutputSize(
+                in.d[k + 2], window.d[k], stride.d[k], 1, pre.d[k], post.d[k], pool->getPaddingMode());
+        }
+        return true;
+    }
+    case nvinfer1::LayerType::kREDUCE:
+    {
+        auto* reduce = static_cast<nvinfer1::IReduceLayer*>(layer);
+        const uint32_t axes = reduce->getReduceAxes();
+        out.nbDims = 0;
+        for (int k = 0; k < in.nbDims; ++k)
+        {
+            if (!(axes & (1U << k)))
+            {
+                out.d[out.nbDims++] = in.d[k];
+            }
+            else if (reduce->getKeepDimensions())
+            {
+                out.d[out.nbDims++] = 1;
+            }
+        }
+        return true;
+    }
+    case nvinfer1::LayerType::kTOPK:
+    {
+        auto* topk = static_cast<nvinfer1::ITopKLayer*>(layer);
+        out = in;
+        for (int k = 0; k < out.nbDims; ++k)
+        {
+            if (topk->getReduceAxes() & (1U << k))
+            {
+                out.d[k] = topk->getK();
+            }
+        }
+        return true;
+    }
+    case nvinfer1::LayerType::kGATHER:
+    {
+        auto* gather = static_cast<nvinfer1::IGatherLayer*>(layer);
+        const int axis = gather->getGatherAxis();
+        if (inputs.size() < 2 || gather->getNbElementWiseDims() != 0 || axis < 0 || axis >= in.nbDims)
+        {
+            return false;
+        }
+        nvinfer1::Dims const& indices = inputs[1];
+        if (in.nbDims - 1 + indices.nbDims > nvinfer1::Dims::MAX_DIMS)
+        {
+            return false;
+        }
+        out.nbDims = 0;
+        for (int k = 0; k < axis; ++k)
+        {
+            out.d[out.nbDims++] = in.d[k];
+        }
+        for (int k = 0; k < indices.nbDims; ++k)
+        {
+            out.d[out.nbDims++] = indices.d[k];
+        }
+        for (int k = axis + 1; k < in.nbDims; ++k)
+        {
+            out.d[out.nbDims++] = in.d[k];
+        }
+        return true;
+    }
+    default: return false;
+    }
+}
+
+} // anonymous namespace
+
+ShapeResolver::ShapeResolver(nvinfer1::INetworkDefinition& network, nvinfer1::IOptimizationProfile const* profile)
+    : mProfile(profile)
+{
+    for (int i = 0; i < network.getNbInputs(); ++i)
+    {
+        nvinfer1::ITensor* input = network.getInput(i);
+        nvinfer1::Dims dims = input->getDimensions();
+        nvinfer1::Dims opt{-1, {}};
+        if (mProfile && !input->isShapeTensor())
+        {
+            opt = mProfile->getDimensions(input->getName(), nvinfer1::OptProfileSelector::kOPT);
+        }
+        for (int j = 0; j < dims.nbDims; ++j)
+        {
+            if (dims.d[j] < 0 && opt.nbDims == dims.nbDims)
+            {
+                dims.d[j] = opt.d[j];
+            }
+        }
+        mResolved[input] = dims;
+    }
+    // Layers are visited in network order, which is the order the importer created them in, so their inputs have
+    // normally been resolved already.
+    std::vector<nvinfer1::Dims> inputs;
+    for (int i = 0; i < network.getNbLayers(); ++i)
+    {
+        nvinfer1::ILayer* layer = network.getLayer(i);
+        inputs.clear();
+        for (int j = 0; j < layer->getNbInputs(); ++j)
+        {
+            // Optional inputs may be unset.
+            if (nvinfer1::ITensor* input = layer->getInput(j))
+            {
+                inputs.push_back(getDimensions(input));
+            }
+        }
+        for (int j = 0; j < layer->getNbOutputs(); ++j)
+        {
+            nvinfer1::ITensor* output = layer->getOutput(j);
+            nvinfer1::Dims dims = output->getDimensions();
+            nvinfer1::Dims inferred{-1, {}};
+            if (!isResolved(dims) && inferOutputDims(layer, inputs, inferred) && inferred.nbDims == dims.nbDims)
+            {
+                for (int k = 0; k < dims.nbDims; ++k)
+                {
+                    dims.d[k] = dims.d[k] < 0 ? inferred.d[k] : dims.d[k];
+                }
+            }
+            mResolved[output] = dims;
+        }
+    }
+}
+
+nvinfer1::Dims ShapeResolver::getDimensions(nvinfer1::ITensor* tensor)
+{
+    const auto it = mResolved.find(tensor);
+    return it != mResolved.end() ? it->second : tensor->getDimensions();
+}
+
+const char* layerTypeName(nvinfer1::LayerType type)
+{
+    switch (type)
+    {
+    case nvinfer1::LayerType::kCONVOLUTION: return "Convolution";
+    case nvinfer1::LayerType::kFULLY_CONNECTED: return "FullyConnected";
+    case nvinfer1::LayerType::kACTIVATION: return "Activation";
+    case nvinfer1::LayerType::kPOOLING: return "Pooling";
+    case nvinfer1::LayerType::kLRN: return "LRN";
+    case nvinfer1::LayerType::kSCALE: return "Scale";
+    case nvinfer1::LayerType::kSOFTMAX: return "SoftMax";
+    case nvinfer1::LayerType::kDECONVOLUTION: return "Deconvolution";
+    case nvinfer1::LayerType::kCONCATENATION: return "Concatenation";
+    case nvinfer1::LayerType::kELEMENTWISE: return "ElementWise";
+    case nvinfer1::LayerType::kPLUGIN: return "Plugin";
+    case nvinfer1::LayerType::kRNN: return "RNN";
+    case nvinfer1::LayerType::kUNARY: return "Unary";
+    case nvinfer1::LayerType::kPADDING: return "Padding";
+    case nvinfer1::LayerType::kSHUFFLE: return "Shuffle";
+    case nvinfer1::LayerType::kREDUCE: return "Reduce";
+    case nvinfer1::LayerType::kTOPK: return "TopK";
+    case nvinfer1::LayerType::kGATHER: return "Gather";
+    case nvinfer1::LayerType::kMATRIX_MULTIPLY: return "MatrixMultiply";
+    case nvinfer1::LayerType::kRAGGED_SOFTMAX: return "RaggedSoftMax";
+    case nvinfer1::LayerType::kCONSTANT: return "Constant";
+    case nvinfer1::LayerType::kRNN_V2: return "RNNv2";
+    case nvinfer1::LayerType::kIDENTITY: return "Identity";
+    case nvinfer1::LayerType::kPLUGIN_V2: return "PluginV2";
+    case nvinfer1::LayerType::kSLICE: return "Slice";
+    case nvinfer1::LayerType::kSHAPE: return "Shape";
+    case nvinfer1::LayerType::kPARAMETRIC_RELU: return "ParametricReLU";
+    case nvinfer1::LayerType::kRESIZE: return "Resize";
+    case nvinfer1::LayerType::kTRIP_LIMIT: return "TripLimit";
+    case nvinfer1::LayerType::kRECURRENCE: return "Recurrence";
+    case nvinfer1::LayerType::kITERATOR: return "Iterator";
+    case nvinfer1::LayerType::kLOOP_OUTPUT: return "LoopOutput";
+    case nvinfer1::LayerType::kSELECT: return "Select";
+    case nvinfer1::LayerType::kFILL: return "Fill";
+    }
+    return "Unknown";
+}
+
+int64_t tensorBytes(nvinfer1::Dims const& dims, nvinfer1::DataType type)
+{
+    return dimsVolume(dims) * std::max(getDtypeSize(type), 0);
+}
+
+NetworkCost estimateNetworkCost(nvinfer1::INetworkDefinition& network, nvinfer1::IOptimizationProfile const* profile)
+{
+    ShapeResolver shapes(network, profile);
+    NetworkCost total;
+    total.layers.reserve(network.getNbLayers());
+    for (int i = 0; i < network.getNbLayers(); ++i)
+    {
+        nvinfer1::ILayer* layer = network.getLayer(i);
+        LayerCost cost;
+        cost.name = layer->getName();
+        cost.type = layer->getType();
+        for (int j = 0; j < layer->getNbInputs(); ++j)
+        {
+            // Optional inputs may be unset.
+            if (nvinfer1::ITensor* input = layer->getInput(j))
+            {
+                cost.inputShapes.push_back(shapes.getDimensions(input));
+                cost.resolved = cost.resolved && isResolved(cost.inputShapes.back());
+            }
+        }
+        for (int j = 0; j < layer->getNbOutputs(); ++j)
+        {
+            nvinfer1::ITensor* output = layer->getOutput(j);
+            cost.outputShapes.push_back(shapes.getDimensions(output));
+            cost.resolved = cost.resolved && isResolved(cost.outputShapes.back());
+            cost.activationBytes += tensorBytes(cost.outputShapes.back(), output->getType());
+        }
+        if (!cost.inputShapes.empty() || layer->getType() == nvinfer1::LayerType::kCONSTANT)
+        {
+            estimateLayerCost(layer, cost);
+        }
+
+        // Costs computed from unknown dimensions would be meaningless, so they are left out rather than guessed.
+        if (!cost.resolved)
+        {
+            cost.flops = 0;
+            cost.macs = 0;
+            cost.activationBytes = 0;
+            ++total.unresolvedLayers;
+        }
+        total.weightBytes += cost.weightBytes;
+        total.flops += cost.flops;
+        total.macs += cost.macs;
+        total.activationBytes += cost.activationBytes;
+        total.layers.push_back(std::move(cost));
+    }
+    return total;
+}
+
+void printNetworkCost(std::ostream& stream, NetworkCost const& cost, int topN)
+{
+    auto shapesString = [](std::vector<nvinfer1::Dims> const& shapes) {
+        std::string s;
+        for (size_t i = 0; i < shapes.size(); ++i)
+        {
+            s += (i ? " " : "") + dimsString(shapes[i]);
+        }
+        return s;
+    };
+
+    stream << std::left << std::setw(6) << "#" << std::setw(16) << "Type" << std::setw(10) << "FLOPs"
+           << std::setw(10) << "MACs" << std::setw(10) << "Weights" << std::setw(11) << "Activation"
+           << "Name: inputs -> outputs" << std::endl;
+    for (size_t i = 0; i < cost.layers.size(); ++i)
+    {
+        LayerCost const& layer = cost.layers[i];
+        const std::string unknown = "?";
+        stream << std::left << std::setw(6) << i << std::setw(16) << layerTypeName(layer.type) << std::setw(10)
+               << (layer.resolved ? metric(layer.flops) : unknown) << std::setw(10)
+               << (layer.resolved ? metric(layer.macs) : unknown) << std::setw(10) << (metric(layer.weightBytes) + "B")
+               << std::setw(11) << (layer.resolved ? metric(layer.activationBytes) + "B" : unknown)
+               << layer.name << ": " << shapesString(layer.inputShapes) << " -> " << shapesString(layer.outputShapes)
+               << std::endl;
+    }
+
+    stream << "----------------------------------------------------------------" << std::endl;
+    stream << "Layers:           " << cost.layers.size() << std::endl;
+    stream << "Total FLOPs:      " << metric(cost.flops) << std::endl;
+    stream << "Total MACs:       " << metric(cost.macs) << std::endl;
+    stream << "Weights:          " << metric(cost.weightBytes) << "B" << std::endl;
+    stream << "Activations:      " << metric(cost.activationBytes) << "B" << std::endl;
+    if (cost.unresolvedLayers)
+    {
+        stream << "Unresolved:       " << cost.unresolvedLayers
+               << " layers with dynamic dimensions are not counted in the FLOPs, MACs and activations above" << std::endl;
+    }
+
+    std::vector<size_t> order(cost.layers.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+    const size_t n = std::min(order.size(), static_cast<size_t>(std::max(topN, 0)));
+    const std::streamsize precision = stream.precision();
+    std::partial_sort(order.begin(), order.begin() + n, order.end(),
+        [&cost](size_t a, size_t b) { return cost.layers[a].flops > cost.layers[b].flops; });
+    stream << "Top " << n << " layers by FLOPs:" << std::endl;
+    for (size_t i = 0; i < n; ++i)
+    {
+        LayerCost const& layer = cost.layers[order[i]];
+        const double share = cost.flops ? 100. * layer.flops / cost.flops : 0.;
+        stream << "  " << std::left << std::setw(6) << order[i] << std::setw(16) << layerTypeName(layer.type)
+               << std::setw(10) << metric(layer.flops) << std::fixed << std::setprecision(1) << share << "%  "
+               << layer.name << std::endl;
+        stream.unsetf(std::ios::fixed);
+        stream.precision(precision);
+    }
+    stream << "----------------------------------------------------------------" << std::endl;
+}
+
+ActivationMemoryPlan planActivationMemory(nvinfer1::INetworkDefinition& network, nvinfer1::IOptimizationProfile const* profile)
+{
+    // Device allocations are aligned, so small tensors still occupy a full alignment unit.
+    const int64_t kALIGNMENT = 256;
+    ShapeResolver shapes(network, profile);
+    ActivationMemoryPlan plan;
+    std::unordered_map<nvinfer1::ITensor*, size_t> tensorIndices;
+    const int nbLayers = network.getNbLayers();
+
+    auto addTensor = [&](nvinfer1::ITensor* tensor, int firstLayer) {
+        TensorLifetime lifetime;
+        lifetime.name = tensor->getName();
+        const nvinfer1::Dims dims = shapes.getDimensions(tensor);
+        // Tensors with unknown dimensions take no space in the plan, and are only counted.
+        const int64_t bytes = isResolved(dims) ? tensorBytes(dims, tensor->getType()) : 0;
+        plan.unresolvedTensors += isResolved(dims) ? 0 : 1;
+        lifetime.bytes = (bytes + kALIGNMENT - 1) / kALIGNMENT * kALIGNMENT;
+        lifetime.firstLayer = firstLayer;
+        lifetime.lastLayer = firstLayer;
+        tensorIndices[tensor] = plan.tensors.size();
+        plan.tensors.push_back(lifetime);
+    };
+
+    for (int i = 0; i < network.getNbInputs(); ++i)
+    {
+        addTensor(network.getInput(i), 0);
+    }
+    for (int i = 0; i < nbLayers; ++i)
+    {
+        nvinfer1::ILayer* layer = network.getLayer(i);
+        for (int j = 0; j < layer->getNbInputs(); ++j)
+        {
+            nvinfer1::ITensor* input = layer->getInput(j);
+            const auto it = input ? tensorIndices.find(input) : tensorIndices.end();
+            if (it != tensorIndices.end())
+            {
+                TensorLifetime& lifetime = plan.tensors[it->second];
+                lifetime.lastLayer = std::max(lifetime.lastLayer, i);
+            }
+        }
+        if (layer->getType() == nvinfer1::LayerType::kCONSTANT)
+        {
+            continue;
+        }
+        for (int j = 0; j < layer->getNbOutputs(); ++j)
+        {
+            addTensor(layer->getOutput(j), i);
+        }
+    }
+    for (int i = 0; i < network.getNbOutputs(); ++i)
+    {
+        const auto it = tensorIndices.find(network.getOutput(i));
+        if (it != tensorIndices.end())
+        {
+            plan.tensors[it->second].lastLayer = std::max(nbLayers - 1, 0);
+        }
+    }
+
+    // Sweep over layers to find the largest live set. Each tensor adds its bytes at its first layer and removes them
+    // after its last one, so a prefix sum over layers gives the live bytes of every layer.
+    std::vector<int64_t> liveBytes(std::max(nbLayers, 1) + 1, 0);
+    for (auto const& t : plan.tensors)
+    {
+        liveBytes[t.firstLayer] += t.bytes;
+        liveBytes[t.lastLayer + 1] -= t.bytes;
+    }
+    std::partial_sum(liveBytes.begin(), liveBytes.end(), liveBytes.begin());
+    const auto maxIt = std::max_element(liveBytes.begin(), liveBytes.end() - 1);
+    plan.maxLiveBytes = *maxIt;
+    plan.peakLayer = static_cast<int>(maxIt - liveBytes.begin());
+
+    // Linear scan packing: tensors are placed in order of their first layer, largest first among those starting
+    // together. Blocks of tensors whose lifetime has ended are coalesced into a free list, from which each tensor
+    // takes the smallest block that fits. If none does, the arena grows.
+    std::vector<size_t> order(plan.tensors.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&plan](size_t a, size_t b) {
+        TensorLifetime const& x = plan.tensors[a];
+        TensorLifetime const& y = plan.tensors[b];
+        return x.firstLayer != y.firstLayer ? x.firstLayer < y.firstLayer : x.bytes > y.bytes;
+    });
+    // Placed tensors by last layer, so that the first to expire is on top.
+    using ActiveTensor = std::pair<int, size_t>;
+    std::priority_queue<ActiveTensor, std::vector<ActiveTensor>, std::greater<ActiveTensor>> active;
+    std::map<int64_t, int64_t> freeByOffset;          // Offset to size of each free block
+    std::set<std::pair<int64_t, int64_t>> freeBySize; // The same blocks as (size, offset)
+
+    auto eraseFree = [&](std::map<int64_t, int64_t>::iterator block) {
+        freeBySize.erase({block->second, block->first});
+        return freeByOffset.erase(block);
+    };
+    auto insertFree = [&](int64_t offset, int64_t size) {
+        freeByOffset.emplace(offset, size);
+        freeBySize.emplace(size, offset);
+    };
+    auto release = [&](int64_t offset, int64_t size) {
+        auto next = freeByOffset.lower_bound(offset);
+        if (next != freeByOffset.end() && next->first == offset + size)
+        {
+            size += next->second;
+            next = eraseFree(next);
+        }
+        if (next != freeByOffset.begin())
+        {
+            const auto prev = std::prev(next);
+            if (prev->first + prev->second == offset)
+            {
+                offset = prev->first;
+                size += prev->second;
+                eraseFree(prev);
+            }
+        }
+        insertFree(offset, size);
+    };
+
+    for (size_t idx : order)
+    {
+        TensorLifetime& t = plan.tensors[idx];
+        while (!active.empty() && active.top().first < t.firstLayer)
+        {
+            TensorLifetime const& expired = plan.tensors[active.top().second];
+            release(expired.offset, expired.bytes);
+            active.pop();
+        }
+        if (t.bytes == 0)
+        {
+            continue;
+        }
+
+        const auto fit = freeBySize.lower_bound({t.bytes, std::numeric_limits<int64_t>::min()});
+        if (fit != freeBySize.end())
+        {
+            const int64_t offset = fit->second;
+            const int64_t remaining = fit->first - t.bytes;
+            eraseFree(freeByOffset.find(offset));
+            if (remaining > 0)
+            {
+                insertFree(offset + t.bytes, remaining);
+            }
+            t.offset = offset;
+        }
+        else
+        {
+            // Grow the arena, starting in the free block at its end if there is one.
+            t.offset = plan.peakBytes;
+            if (!freeByOffset.empty())
+            {
+                const auto last = std::prev(freeByOffset.end());
+                if (last->first + last->second == plan.peakBytes)
+                {
+                    t.offset = last->first;
+                    eraseFree(last);
+                }
+            }
+            plan.peakBytes = t.offset + t.bytes;
+            plan.packedPeakLayer = t.firstLayer;
+        }
+        active.emplace(t.lastLayer, idx);
+    }
+
+    // The tensors live when the arena last grew are those that set peakBytes.
+    for (size_t i = 0; i < plan.tensors.size(); ++i)
+    {
+        TensorLifetime const& t = plan.tensors[i];
+        if (t.bytes > 0 && t.firstLayer <= plan.packedPeakLayer && plan.packedPeakLayer <= t.lastLayer)
+        {
+            plan.peakTensors.push_back(i);
+        }
+    }
+    std::stable_sort(plan.peakTensors.begin(), plan.peakTensors.end(),
+        [&plan](size_t a, size_t b) { return plan.tensors[a].bytes > plan.tensors[b].bytes; });
+    return plan;
+}
+
+void printActivationMemoryPlan(std::ostream& stream, ActivationMemoryPlan const& plan, int topN)
+{
+    stream << "----------------------------------------------------------------" << std::endl;
+    stream << "Activation tensors:        " << plan.tensors.size() << std::endl;
+    stream << "Estimated peak (packed):   " << metric(plan.peakBytes) << "B (" << plan.peakBytes
+           << " bytes) at layer " << plan.packedPeakLayer << std::endl;
+    stream << "Largest live set:          " << metric(plan.maxLiveBytes) << "B at layer " << plan.peakLayer << std::endl;
+    if (plan.unresolvedTensors)
+    {
+        stream << "Unresolved tensors:        " << plan.unresolvedTensors
+               << " (dynamic dimensions, not counted above)" << std::endl;
+    }
+    const size_t n = std::min(plan.peakTensors.size(), static_cast<size_t>(std::max(topN, 0)));
+    stream << "Largest tensors live at the packed peak:" << std::endl;
+    for (size_t i = 0; i < n; ++i)
+    {
+        TensorLifetime const& t = plan.tensors[plan.peakTensors[i]];
+        stream << "  " << std::left << std::setw(10) << (metric(t.bytes) + "B") << "layers " << t.firstLayer << "-"
+               << t.lastLayer << "  " << t.name << std::endl;
+    }
+    stream << "----------------------------------------------------------------" << std::endl;
+}
+
+} // namespace onnx2trt
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <NvInfer.h>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Static, CPU-only analyses of an imported INetworkDefinition. Nothing here requires building an engine.
+namespace onnx2trt
+{
+
+// Concrete shapes for the tensors of a network. Dynamic dimensions of network inputs are taken from the kOPT
+// shapes of an optimization profile. Dynamic dimensions of layer outputs are inferred from the resolved input
+// shapes for layers whose output shape follows from them (elementwise, transpose and static reshape, matrix
+// multiply, concatenation, convolution, pooling, reduce, ...). Dimensions that cannot be resolved stay -1.
+class ShapeResolver
+{
+public:
+    ShapeResolver(nvinfer1::INetworkDefinition& network, nvinfer1::IOptimizationProfile const* profile = nullptr);
+    nvinfer1::Dims getDimensions(nvinfer1::ITensor* tensor);
+
+private:
+    nvinfer1::IOptimizationProfile const* mProfile;
+    std::unordered_map<nvinfer1::ITensor*, nvinfer1::Dims> mResolved;
+};
+
+struct LayerCost
+{
+    std::string name;
+    nvinfer1::LayerType type;
+    std::vector<nvinfer1::Dims> inputShapes;
+    std::vector<nvinfer1::Dims> outputShapes;
+    int64_t weightBytes{0};
+    int64_t flops{0};
+    int64_t macs{0};
+    int64_t activationBytes{0}; // Bytes of all output tensors
+    bool resolved{true}; // False if a dimension of an input or output is unknown; costs are then left at 0
+};
+
+struct NetworkCost
+{
+    std::vector<LayerCost> layers; // In network order
+    int64_t weightBytes{0};
+    int64_t flops{0};
+    int64_t macs{0};
+    int64_t activationBytes{0};
+    int unresolvedLayers{0}; // Layers left out of the totals above
+};
+
+const char* layerTypeName(nvinfer1::LayerType type);
+
+int64_t tensorBytes(nvinfer1::Dims const& dims, nvinfer1::DataType type);
+
+// Estimates weights, FLOPs, MACs and activation bytes of every layer. Costs of layers inside loops are per iteration.
+NetworkCost estimateNetworkCost(nvinfer1::INetworkDefinition& network, nvinfer1::IOptimizationProfile const* profile = nullptr);
+
+// Prints a per-layer table, the whole-network totals and the topN layers with the most FLOPs.
+void printNetworkCost(std::ostream& stream, NetworkCost const& cost, int topN = 10);
+
+struct TensorLifetime
+{
+    std::string name;
+    int64_t bytes{0};  // Rounded up to the allocation alignment
+    int firstLayer{0}; // Index of the producing layer, or 0 for network inputs
+    int lastLayer{0};  // Index of the last consuming layer, or the last layer for network outputs
+    int64_t offset{0}; // Offset assigned by the packing simulation
+};
+
+struct ActivationMemoryPlan
+{
+    std::vector<TensorLifetime> tensors;
+    int64_t peakBytes{0};     // Arena size after greedy packing
+    int packedPeakLayer{-1};  // Layer at which the arena grows to peakBytes
+    int64_t maxLiveBytes{0};  // Lower bound: largest total size of simultaneously live tensors
+    int peakLayer{-1};        // Layer at which maxLiveBytes is reached
+    std::vector<size_t> peakTensors; // Indices into tensors of those live at packedPeakLayer, largest first
+    int unresolvedTensors{0}; // Tensors with unknown dimensions, planned with 0 bytes
+};
+
+// Computes activation tensor lifetimes over the network's layer order and packs them into a single arena,
+// placing tensors in order of their first layer into the smallest free block left by tensors whose lifetime has
+// ended. Constant layer outputs are excluded, since they are stored with the engine's weights.
+ActivationMemoryPlan planActivationMemory(
+    nvinfer1::INetworkDefinition& network, nvinfer1::IOptimizationProfile const* profile = nullptr);
+
+void printActivationMemoryPlan(std::ostream& stream, ActivationMemoryPlan const& plan, int topN = 10);
+
+} // namespace onnx2trt
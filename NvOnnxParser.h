@@ -162,6 +162,9 @@ public:
      * \param sub_graph_collection Container to hold supported subgraphs
      * \param model_path Absolute path to the model file for loading external weights if required
      * \return true if the model is supported
+     *
+     * Each subgraph is connected and convex (no path between two of its nodes leaves it). Subgraphs are
+     * listed in an order in which they can be executed, with their nodes in topological order.
      */
     virtual bool supportsModel(void const* serialized_onnx_model,
                                size_t serialized_onnx_model_size,
@@ -232,6 +235,65 @@ public:
      */
     virtual int getRefitMap(const char** weightNames, const char** layerNames, nvinfer1::WeightsRole* roles) = 0;
 
+    /** \brief Select ONNX optimizer passes to run on models before they are imported.
+     *
+     * The passes are applied in memory by parse(), parseFromFile() and parseWithWeightDescriptors().
+     * supportsModel() always works on the model as given. Node indices reported by getError() refer
+     * to the optimized model.
+     *
+     * \param passes Semicolon-separated list of pass names, e.g. "eliminate_identity;fuse_consecutive_transposes".
+     *        An empty string or nullptr disables optimization.
+     * \param fixedPoint Whether to repeat the passes until the model no longer changes
+     *
+     * \return false if any of the passes is not available, in which case the selection is left unchanged
+     */
+    virtual bool setOptimizationPasses(const char* passes, bool fixedPoint = false) = 0;
+
+    /** \brief Estimate the peak activation memory of the network populated by the last parse.
+     *
+     * Each tensor is assumed to live from the layer producing it to its last consumer, in network
+     * order, and all tensors are packed greedily into a single arena. Dynamic dimensions of network
+     * inputs are taken from the kOPT shapes of profile, or are 1 if profile is nullptr.
+     *
+     * \param profile Optimization profile used to resolve dynamic shapes, may be nullptr
+     * \param peakTensorNames Where to write the names of the tensors live at the peak, largest first
+     * \param nbPeakTensors Where to write the number of tensors live at the peak, may be nullptr
+     *
+     * \return The estimated peak activation memory in bytes
+     *
+     * If peakTensorNames != nullptr, it must have room for *nbPeakTensors entries, as returned by a
+     * previous call with the same profile. Each written pointer points to a string owned by the
+     * parser, and becomes invalid on the next call or when the parser is destroyed.
+     */
+    virtual int64_t estimateActivationMemory(
+        nvinfer1::IOptimizationProfile const* profile, const char** peakTensorNames, int* nbPeakTensors)
+        = 0;
+
+    /** \brief Unroll Loop and Scan nodes with a small constant trip count.
+     *
+     * Such loops are imported by instantiating their body once per iteration instead of as an ILoop, which lets
+     * TensorRT fuse layers across iterations. Loop nodes qualify when their trip count is a constant and their
+     * condition is absent or constant true; Scan nodes when the length of their scan inputs is static.
+     *
+     * \param maxTripCount The largest trip count to unroll. 0 (the default) disables unrolling.
+     */
+    virtual void setLoopUnrollLimit(int maxTripCount) = 0;
+
+    /** \brief Set the length of the scan outputs of Loop nodes that have no trip count.
+     *
+     * TensorRT needs the length of a scan output before the loop runs. If the Loop node has a trip count, it is
+     * used. Otherwise, if the loop condition is the iteration number compared against a loop-invariant value
+     * (e.g. a dimension of an input, but not a network input itself), the length is derived from that value; if
+     * that comparison is combined with others, the length is only an upper bound. Otherwise, the length set here
+     * is used. In both of the latter cases, the scan output is only valid up to the number of iterations run.
+     *
+     * \param length The scan output length. The default is 1024.
+     * \param nodeNamePattern If not nullptr, the length only applies to Loop nodes whose name matches this
+     *        pattern, in which '*' matches any sequence of characters and '?' any single character. Such
+     *        per-node lengths take precedence over a derived length, and the first matching pattern wins.
+     */
+    virtual void setMaxScanOutputLength(int length, const char* nodeNamePattern = nullptr) = 0;
+
 protected:
     virtual ~IParser() {}
 };
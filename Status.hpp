@@ -25,7 +25,9 @@
 #include "NvOnnxParser.h"
 
 #include <cassert>
+#include <memory>
 #include <string>
+#include <utility>
 
 // Used to strip out Eris build path information from debug prints
 #if defined(SOURCE_LENGTH)
@@ -65,17 +67,18 @@
         }                                                                                                              \
     } while (0)
 
+// Moves the value out of value_or_error_, which must be a temporary, or returns its error.
 #define GET_VALUE(value_or_error_, result_ptr)                                                                         \
     do                                                                                                                 \
     {                                                                                                                  \
-        auto const& value_or_error = value_or_error_;                                                                  \
+        auto&& value_or_error = value_or_error_;                                                                       \
         if (value_or_error.is_error())                                                                                 \
         {                                                                                                              \
             return value_or_error.error();                                                                             \
         }                                                                                                              \
         else                                                                                                           \
         {                                                                                                              \
-            *result_ptr = value_or_error.value();                                                                      \
+            *result_ptr = std::move(value_or_error.value());                                                           \
         }                                                                                                              \
     } while (0)
 
@@ -96,12 +99,18 @@ using nvonnxparser::ErrorCode;
 
 class Status : public nvonnxparser::IParserError
 {
-    ErrorCode _code;
-    std::string _desc;
-    std::string _file;
-    int _line;
-    std::string _func;
-    int _node;
+    // The strings are only allocated for errors, so that constructing and copying a success status, which every
+    // importer returns, is just a few scalar stores.
+    struct Details
+    {
+        std::string desc;
+        std::string file;
+        std::string func;
+    };
+    ErrorCode _code{ErrorCode::kSUCCESS};
+    int _line{0};
+    int _node{-1};
+    std::shared_ptr<const Details> _details;
 
 public:
     static Status success()
@@ -111,14 +120,16 @@ public:
     Status()
     {
     }
-    explicit Status(ErrorCode code, std::string desc = "", std::string file = "", int line = 0, std::string func = "",
+    explicit Status(ErrorCode code)
+        : _code(code)
+    {
+    }
+    Status(ErrorCode code, std::string desc, std::string file = "", int line = 0, std::string func = "",
         int node = -1)
         : _code(code)
-        , _desc(desc)
-        , _file(file)
         , _line(line)
-        , _func(func)
         , _node(node)
+        , _details(std::make_shared<Details>(Details{std::move(desc), std::move(file), std::move(func)}))
     {
     }
     ErrorCode code() const override
@@ -127,11 +138,11 @@ public:
     }
     const char* desc() const override
     {
-        return _desc.c_str();
+        return _details ? _details->desc.c_str() : "";
     }
     const char* file() const override
     {
-        return _file.c_str();
+        return _details ? _details->file.c_str() : "";
     }
     int line() const override
     {
@@ -139,7 +150,7 @@ public:
     }
     const char* func() const override
     {
-        return _func.c_str();
+        return _details ? _details->func.c_str() : "";
     }
     int node() const override
     {
@@ -170,13 +181,11 @@ public:
     ValueOrStatus(T const& value)
         : _is_error(false)
         , _value(value)
-        , _error(Status::success())
     {
     }
     ValueOrStatus(T&& value)
         : _is_error(false)
-        , _value(value)
-        , _error(Status::success())
+        , _value(std::move(value))
     {
     }
     ValueOrStatus(Status const& error)
@@ -186,7 +195,7 @@ public:
     }
     ValueOrStatus(Status&& error)
         : _is_error(true)
-        , _error(error)
+        , _error(std::move(error))
     {
     }
     bool is_error() const
@@ -33,7 +33,9 @@
 #include <array>
 #include <cmath>
 #include <cstring> // For std::memcpy, std::memset
+#include <functional>
 #include <iterator>
+#include <memory>
 #include <numeric> // For std::iota
 #include <tuple>
 #include <unordered_set>
@@ -278,9 +280,9 @@ DEFINE_BUILTIN_OP_IMPORTER(BatchNormalization)
         combined_bias_ref = bias - mean * combined_scale_ref;
     }
 
+    // The combined weights do not exist in the model, so they are not registered for refit.
     return scaleHelper(ctx, node, *tensorPtr, nvinfer1::ScaleMode::kCHANNEL, combined_bias_weights,
-        combined_scale_weights, ShapedWeights::empty(scale_weights.type), bias_weights.getName(),
-        scale_weights.getName());
+        combined_scale_weights, ShapedWeights::empty(scale_weights.type), nullptr, nullptr);
 }
 
 DEFINE_BUILTIN_OP_IMPORTER(Cast)
@@ -341,10 +343,9 @@ DEFINE_BUILTIN_OP_IMPORTER(Celu)
 
     for (auto input : newInputs)
     {
+        // Broadcast all inputs to size of maxNbDims
+        TRT_CHECK(broadcastTensor(ctx, input, maxNbDims));
         auto* tensor_ptr = &convertToTensor(input, ctx);
-
-        // Broadcast all input tensors to size of maxNbDims
-        broadcastTensor(ctx, tensor_ptr, maxNbDims);
         ASSERT(tensor_ptr->getDimensions().nbDims == maxNbDims && "Failed to broadcast tensors elementwise!",
             ErrorCode::kUNSUPPORTED_NODE);
         inputTensors.push_back(tensor_ptr);
@@ -838,6 +839,113 @@ DEFINE_BUILTIN_OP_IMPORTER(Cosh)
     return unaryHelper(ctx, node, inputs.at(0), nvinfer1::UnaryOperation::kCOSH);
 }
 
+// Cumulative sums of FP16 tensors along an axis of static length up to this limit are lowered to a matrix
+// multiplication with a constant triangular matrix, which has length * length elements. FP32 tensors are not, since
+// the builder may run FP32 matrix multiplications in TF32, which would round every input to 10 mantissa bits. Other
+// static axes use a parallel prefix sum, dynamic ones an ILoop.
+constexpr int32_t MAX_CUMSUM_MATMUL_LENGTH = 256;
+
+// Slices [start, start + size) of tensor along axis.
+nvinfer1::ITensor* sliceAlongAxis(
+    IImporterContext* ctx, nvinfer1::ITensor& tensor, int32_t axis, const ShapeTensor& start, const ShapeTensor& size)
+{
+    const ShapeTensor shape = shapeOf(tensor);
+    const ShapeTensor subscripts{axesToInterlaceSubscripts(shapeVector(axis), shape.size())};
+    const ShapeTensor starts = interlace(ctx, similar(ctx, shape, 0), start, subscripts);
+    const ShapeTensor sizes = interlace(ctx, shape, size, subscripts);
+    return addSlice(ctx, tensor, starts, sizes, similar(ctx, shape, 1))->getOutput(0);
+}
+
+nvinfer1::ITensor* concatAlongAxis(
+    IImporterContext* ctx, nvinfer1::ITensor* first, nvinfer1::ITensor* second, int32_t axis)
+{
+    std::array<nvinfer1::ITensor*, 2> tensors{first, second};
+    nvinfer1::IConcatenationLayer* concat = ctx->network()->addConcatenation(tensors.data(), tensors.size());
+    concat->setAxis(axis);
+    return concat->getOutput(0);
+}
+
+// Shifts tensor by one along axis, towards its end or, if reverse, towards its start, and fills in a zero. This
+// turns an inclusive cumulative sum of the result into an exclusive one of tensor.
+nvinfer1::ITensor* shiftInZero(IImporterContext* ctx, nvinfer1::ITensor& tensor, int32_t axis, bool reverse)
+{
+    const int32_t rank = tensor.getDimensions().nbDims;
+    const ShapeTensor shape = shapeOf(tensor);
+    const ShapeTensor length = gather(ctx, shape, shapeVector(axis));
+    const ShapeTensor subscripts{axesToInterlaceSubscripts(shapeVector(axis), rank)};
+    const ShapeTensor zerosShape = interlace(ctx, shape, shapeVector(1), subscripts);
+
+    // Broadcast a single zero of the right type to the shape of one slice along axis.
+    const nvinfer1::DataType type = tensor.getType();
+    nvinfer1::ITensor* zero = type == nvinfer1::DataType::kINT32
+        ? addConstantScalar(ctx, 0, ::ONNX_NAMESPACE::TensorProto::INT32, makeDims(rank, 1))->getOutput(0)
+        : addConstantScalar(ctx, 0.F, ::ONNX_NAMESPACE::TensorProto::FLOAT, makeDims(rank, 1))->getOutput(0);
+    if (type == nvinfer1::DataType::kHALF)
+    {
+        zero = castHelper(ctx, zero, type);
+    }
+    nvinfer1::ITensor* zeros
+        = addSlice(ctx, *zero, similar(ctx, zerosShape, 0), zerosShape, similar(ctx, zerosShape, 0))->getOutput(0);
+    if (length.allValuesKnown() && length[0] == 1)
+    {
+        return zeros;
+    }
+
+    const ShapeTensor kept = sub(ctx, length, shapeVector(1));
+    return reverse ? concatAlongAxis(ctx, sliceAlongAxis(ctx, tensor, axis, shapeVector(1), kept), zeros, axis)
+                   : concatAlongAxis(ctx, zeros, sliceAlongAxis(ctx, tensor, axis, shapeVector(0), kept), axis);
+}
+
+// Cumulative sum as a product with a constant matrix whose entry (j, i) is 1 if input i contributes to output j.
+// The tensor is viewed as [outer, length, inner], so that the matrix broadcasts over outer and applies to each column.
+nvinfer1::ITensor* cumSumMatMul(
+    IImporterContext* ctx, nvinfer1::ITensor& input, int32_t axis, int32_t length, bool exclusive, bool reverse)
+{
+    const int32_t rank = input.getDimensions().nbDims;
+    const ShapeTensor shape = shapeOf(input);
+    std::vector<float> contributions(static_cast<size_t>(length) * length);
+    for (int32_t j = 0; j < length; ++j)
+    {
+        for (int32_t i = 0; i < length; ++i)
+        {
+            const bool contributes = reverse ? (exclusive ? i > j : i >= j) : (exclusive ? i < j : i <= j);
+            contributions[j * length + i] = contributes ? 1.F : 0.F;
+        }
+    }
+    nvinfer1::ITensor* matrix = addConstant(ctx, contributions, ::ONNX_NAMESPACE::TensorProto::FLOAT,
+        nvinfer1::Dims3{1, length, length})->getOutput(0);
+    matrix = castHelper(ctx, matrix, input.getType());
+
+    const ShapeTensor columnsShape = concat(ctx,
+        concat(ctx, product(ctx, shape, 0, axis, 1), shapeVector(length)), product(ctx, shape, axis + 1, rank, 1));
+    nvinfer1::ITensor* sums = ctx->network()
+                                  ->addMatrixMultiply(*matrix, nvinfer1::MatrixOperation::kNONE,
+                                      reshape(ctx, input, columnsShape), nvinfer1::MatrixOperation::kNONE)
+                                  ->getOutput(0);
+    return &reshape(ctx, *sums, shape);
+}
+
+// Inclusive Hillis-Steele scan: after the step with offset s, every element holds the sum of the up to 2s elements
+// ending at it, so ceil(log2(length)) steps of two slices, an add and a concatenation suffice.
+nvinfer1::ITensor* cumSumPrefixScan(
+    IImporterContext* ctx, nvinfer1::ITensor& input, int32_t axis, int32_t length, bool reverse)
+{
+    nvinfer1::ITensor* sums = &input;
+    for (int32_t offset = 1; offset < length; offset *= 2)
+    {
+        const ShapeTensor rest = shapeVector(length - offset);
+        // Elements within offset of the start (or end, if reverse) have no partner at this step.
+        const ShapeTensor unchangedStart = shapeVector(reverse ? length - offset : 0);
+        nvinfer1::ITensor* unchanged = sliceAlongAxis(ctx, *sums, axis, unchangedStart, shapeVector(offset));
+        nvinfer1::ITensor* head = sliceAlongAxis(ctx, *sums, axis, shapeVector(0), rest);
+        nvinfer1::ITensor* tail = sliceAlongAxis(ctx, *sums, axis, shapeVector(offset), rest);
+        nvinfer1::ITensor* partial
+            = ctx->network()->addElementWise(*head, *tail, nvinfer1::ElementWiseOperation::kSUM)->getOutput(0);
+        sums = reverse ? concatAlongAxis(ctx, partial, unchanged, axis) : concatAlongAxis(ctx, unchanged, partial, axis);
+    }
+    return sums;
+}
+
 DEFINE_BUILTIN_OP_IMPORTER(CumSum)
 {
     OnnxAttrs attrs(node, ctx);
@@ -847,48 +955,34 @@ DEFINE_BUILTIN_OP_IMPORTER(CumSum)
     nvinfer1::ITensor* input = &convertToTensor(inputs.at(0), ctx);
     auto dims = input->getDimensions();
 
-    ASSERT(inputs.at(1).is_weights() && "Axis input for CumSum must be an initializer!", ErrorCode::kUNSUPPORTED_NODE);
-    ShapedWeights axisWeights = inputs.at(1).weights();
-    int32_t axis = static_cast<int32_t*>(axisWeights.values)[0];
-    TRT_CHECK(convertAxis(axis, dims.nbDims));
-
-    /* For exclusive CumSums, it is equivalent as a non-exclusive CumSum on a modified input tensor
-
-        Forward summations:
-            concat(0, data[0:length-1:1])
+    // The only valid axis of a 1D input is 0, so its value does not need to be known.
+    int32_t axis = 0;
+    if (dims.nbDims != 1)
+    {
+        ASSERT(inputs.at(1).is_weights() && "Axis input for CumSum must be an initializer!",
+            ErrorCode::kUNSUPPORTED_NODE);
+        ShapedWeights axisWeights = inputs.at(1).weights();
+        axis = static_cast<int32_t*>(axisWeights.values)[0];
+        TRT_CHECK(convertAxis(axis, dims.nbDims));
+    }
 
-        Reverse summations:
-            concat(data[1:length:1], 0)
+    const int32_t length = dims.d[axis];
+    if (length > 0 && length <= MAX_CUMSUM_MATMUL_LENGTH && input->getType() == nvinfer1::DataType::kHALF)
+    {
+        LOG_VERBOSE("Lowering CumSum " << getNodeName(node) << " to a triangular matrix multiplication");
+        return {{cumSumMatMul(ctx, *input, axis, length, exclusive, reverse)}};
+    }
 
-    */
+    // For exclusive CumSums, it is equivalent as a non-exclusive CumSum on the input shifted by one along axis.
     if (exclusive)
     {
-        auto tempDims = dims;
-        tempDims.d[axis] = 1;
-        auto zero = addConstant(ctx, std::vector<float>{0.f}, ::ONNX_NAMESPACE::TensorProto::FLOAT, tempDims)->getOutput(0);
-
-        std::vector<nvinfer1::ITensor*> concatTensors = reverse == 1 ? std::vector<nvinfer1::ITensor*>{input, zero} : std::vector<nvinfer1::ITensor*>{zero, input};
-
-        auto concat = ctx->network()->addConcatenation(concatTensors.data(), concatTensors.size());
-        concat->setAxis(axis);
-        input = concat->getOutput(0);
+        input = shiftInZero(ctx, *input, axis, reverse);
+    }
 
-        if (reverse == 0)
-        {
-            const ShapeTensor subscripts{axesToInterlaceSubscripts(shapeVector(axis), dims.nbDims)};
-            ShapeTensor starts = fillShapeVector(ctx, 0, shapeVector(dims.nbDims));
-            ShapeTensor sizes = interlace(ctx, shapeOf(*input), sub(ctx, gather(ctx, shapeOf(*input), shapeVector(axis)), shapeVector(1)), subscripts);
-            ShapeTensor strides = fillShapeVector(ctx, 1, shapeVector(dims.nbDims));
-            input = addSlice(ctx, *input, starts, sizes, strides)->getOutput(0);
-        }
-        else
-        {
-            const ShapeTensor subscripts{axesToInterlaceSubscripts(shapeVector(axis), dims.nbDims)};
-            ShapeTensor starts = interlace(ctx, fillShapeVector(ctx, 0, shapeVector(dims.nbDims)), shapeVector(1), subscripts);
-            ShapeTensor sizes = interlace(ctx, shapeOf(*input), sub(ctx, gather(ctx, shapeOf(*input), shapeVector(axis)), shapeVector(1)), subscripts);
-            ShapeTensor strides = fillShapeVector(ctx, 1, shapeVector(dims.nbDims));
-            input = addSlice(ctx, *input, starts, sizes, strides)->getOutput(0);
-        }
+    if (length > 0)
+    {
+        LOG_VERBOSE("Lowering CumSum " << getNodeName(node) << " to a parallel prefix sum");
+        return {{cumSumPrefixScan(ctx, *input, axis, length, reverse)}};
     }
 
     // Scan through each slice across summation axis and add it to the running sum
@@ -1209,86 +1303,88 @@ DEFINE_BUILTIN_OP_IMPORTER(GatherElements)
     nvinfer1::ITensor& data = convertToTensor(inputs.at(0), ctx);
     nvinfer1::ITensor& index = convertToTensor(inputs.at(1), ctx);
 
-    const nvinfer1::Dims& idxDims = index.getDimensions();
-    const nvinfer1::Dims& dataDims = data.getDimensions();
+    const int32_t dataNbDims = data.getDimensions().nbDims;
+    ASSERT(index.getDimensions().nbDims == dataNbDims && "GatherElements data and indices must have the same rank!",
+        ErrorCode::kINVALID_NODE);
 
     OnnxAttrs attrs(node, ctx);
     int32_t axis = attrs.get<int32_t>("axis", 0);
-    int32_t dataNbDims = dataDims.nbDims;
-
     TRT_CHECK(convertAxis(axis, dataNbDims));
     LOG_VERBOSE("Using Gather axis: " << axis);
 
-    // Calculate how many indices
-    int64_t nIndx = volume(idxDims);
-
-    // Calculate pitches of input tensor
-    int32_t nDataElements = volume(dataDims), pitch = 1;
-    int32_t pitches[nvinfer1::Dims::MAX_DIMS] = {0};
-    pitches[dataDims.nbDims-1] = pitch;
-    for (int32_t i = dataDims.nbDims-2; i >= 0 ; i--)
-    {
-        pitch *= dataDims.d[i];
-        pitches[i] = pitch;
-    }
-
-    // Generate constants based on axis
-    std::vector<int32_t> sCoeff(nIndx, pitches[axis]);
-    std::vector<int32_t> aCoeff;
-
-    // Transform a 1-d index back to the nDims
-    for (int32_t i = 0; i < nIndx; i++)
-    {
-        std::vector<int32_t> nDimsIdx; //this can be an array
-        int32_t currI = i;
-
-        for (int32_t j = 0; j < dataDims.nbDims; j++)
+    // Output position p reads the flattened data at sum_j p[j] * stride[j], with p[axis] replaced by index[p].
+    // The sum over the other axes is a linspace fill over the index shape, whose per-axis deltas are the data strides
+    // with the stride of axis zeroed.
+    const ShapeTensor dataShape = shapeOf(data);
+    ShapeTensor stride = shapeVector(1);
+    ShapeTensor axisStride = stride;
+    ShapeTensor deltas = shapeVector(axis == dataNbDims - 1 ? 0 : 1);
+    for (int32_t j = dataNbDims - 2; j >= 0; --j)
+    {
+        stride = mul(ctx, stride, gather(ctx, dataShape, shapeVector(j + 1)));
+        if (j == axis)
         {
-            int32_t currIdxVal = currI / pitches[j];
-            nDimsIdx.push_back(currIdxVal);
-            currI = currI % pitches[j];
+            axisStride = stride;
         }
+        deltas = concat(ctx, j == axis ? shapeVector(0) : stride, deltas);
+    }
+    nvinfer1::IFillLayer* fill = addFill(ctx, shapeOf(index), nvinfer1::FillOperation::kLINSPACE);
+    fill->setInput(1, shapeScalar(0).tensor(ctx));
+    fill->setInput(2, deltas.tensor(ctx));
+    nvinfer1::ITensor* offsets = fill->getOutput(0);
+
+    // index - floor(index / size) * size maps [-size, size) onto [0, size).
+    const ShapeTensor ones = similar(ctx, deltas, 1);
+    nvinfer1::ITensor* axisSize = &reshape(ctx, gather(ctx, dataShape, shapeVector(axis)).tensor(ctx), ones);
+    nvinfer1::ITensor* wraps
+        = ctx->network()->addElementWise(index, *axisSize, nvinfer1::ElementWiseOperation::kFLOOR_DIV)->getOutput(0);
+    wraps = ctx->network()->addElementWise(*wraps, *axisSize, nvinfer1::ElementWiseOperation::kPROD)->getOutput(0);
+    nvinfer1::ITensor* axisOffsets
+        = ctx->network()->addElementWise(index, *wraps, nvinfer1::ElementWiseOperation::kSUB)->getOutput(0);
+    axisOffsets = ctx->network()
+                      ->addElementWise(*axisOffsets, reshape(ctx, axisStride.tensor(ctx), ones),
+                          nvinfer1::ElementWiseOperation::kPROD)
+                      ->getOutput(0);
+    offsets = ctx->network()->addElementWise(*offsets, *axisOffsets, nvinfer1::ElementWiseOperation::kSUM)->getOutput(0);
 
-        int32_t bias = 0;
-        //calculate the aCoeff
-        for (size_t j = 0; j < nDimsIdx.size(); j++)
-        {
-
-            if (j == (size_t)axis)
-            {
-                continue;
-            }
-            bias += nDimsIdx[j] * pitches[j];
-        }
-        aCoeff.push_back(bias);
-    }
-
-    auto* sCoeffLayer = addConstant(ctx, sCoeff, ::ONNX_NAMESPACE::TensorProto::INT32, idxDims);
-    auto* aCoeffLayer = addConstant(ctx, aCoeff, ::ONNX_NAMESPACE::TensorProto::INT32, idxDims);
-
-    nvinfer1::ITensor* sCoeffTensor = sCoeffLayer->getOutput(0);
-    nvinfer1::ITensor* aCoeffTensor = aCoeffLayer->getOutput(0);
-    auto* mul = ctx->network()->addElementWise(index, *sCoeffTensor, nvinfer1::ElementWiseOperation::kPROD);
-
-    nvinfer1::ITensor* mulTensor = mul->getOutput(0);
-    auto* add = ctx->network()->addElementWise(*mulTensor, *aCoeffTensor, nvinfer1::ElementWiseOperation::kSUM);
-
-    nvinfer1::ITensor* addTensor = add->getOutput(0);
-
-    nvinfer1::Dims flattenDataDims{1};
-
-    flattenDataDims.nbDims = 1;
-    flattenDataDims.d[0] = nDataElements;
-    auto* reshape = ctx->network()->addShuffle(data);
-    reshape->setReshapeDimensions(flattenDataDims);
-    reshape->setZeroIsPlaceholder(false);
-
-    nvinfer1::ITensor* flattenData = reshape->getOutput(0);
-    auto* layer = ctx->network()->addGather(*flattenData, *addTensor, 0);
+    nvinfer1::ITensor& flattenData = reshape(ctx, data, product(ctx, dataShape, 0, dataNbDims, 1));
+    auto* layer = ctx->network()->addGather(flattenData, *offsets, 0);
     ctx->registerLayer(layer, getNodeName(node));
     RETURN_FIRST_OUTPUT(layer);
 }
 
+DEFINE_BUILTIN_OP_IMPORTER(GatherND)
+{
+    nvinfer1::ITensor& data = convertToTensor(inputs.at(0), ctx);
+    nvinfer1::ITensor& indices = convertToTensor(inputs.at(1), ctx);
+    // TRT does not support BOOL input types for this node
+    ASSERT(data.getType() != nvinfer1::DataType::kBOOL, ErrorCode::kUNSUPPORTED_NODE);
+    OnnxAttrs attrs(node, ctx);
+    ASSERT(attrs.get<int>("batch_dims", 0) == 0 && "TensorRT only supports GatherND with batch_dims = 0!",
+        ErrorCode::kUNSUPPORTED_NODE);
+
+    const int dataRank = data.getDimensions().nbDims;
+    const int indicesRank = indices.getDimensions().nbDims;
+    ASSERT(indicesRank >= 1, ErrorCode::kINVALID_NODE);
+    const int k = indices.getDimensions().d[indicesRank - 1];
+    ASSERT(k > 0 && "The last dimension of GatherND indices must be static!", ErrorCode::kUNSUPPORTED_NODE);
+    ASSERT(k <= dataRank, ErrorCode::kINVALID_NODE);
+
+    // Flatten the first k axes of data and gather from them with linear indices:
+    // output shape = indices.shape[:-1] + data.shape[k:].
+    const auto dataShape = shapeOf(data);
+    std::vector<int64_t> trailingAxes(dataRank - k);
+    std::iota(trailingAxes.begin(), trailingAxes.end(), k);
+    const ShapeTensor flatShape = concat(ctx, product(ctx, dataShape, 0, k, 1),
+        gather(ctx, dataShape, ShapeTensor(1, std::move(trailingAxes))));
+    nvinfer1::ITensor& flatData = reshape(ctx, data, flatShape);
+    nvinfer1::ITensor* linear = linearizeIndices(ctx, data, indices);
+    linear = &reshape(ctx, *linear, gather(ctx, shapeOf(indices), iotaShapeVector(indicesRank - 1)));
+
+    auto* layer = ctx->network()->addGather(flatData, *linear, 0);
+    ctx->registerLayer(layer, node.name());
+    RETURN_FIRST_OUTPUT(layer);
+}
 
 DEFINE_BUILTIN_OP_IMPORTER(Gemm)
 {
@@ -1410,10 +1506,12 @@ DEFINE_BUILTIN_OP_IMPORTER(Gemm)
     // Scale A*B if needed.
     if (alpha != 1.f)
     {
+        // Create the scalar with the rank of A*B directly rather than reshaping it.
+        nvinfer1::Dims scalarDims{matmulTensor->getDimensions().nbDims, {}};
+        std::fill(scalarDims.d, scalarDims.d + scalarDims.nbDims, 1);
         nvinfer1::IConstantLayer* alphaConstant
-            = addConstantScalar(ctx, alpha, ::ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+            = addConstantScalar(ctx, alpha, ::ONNX_NAMESPACE::TensorProto_DataType_FLOAT, scalarDims);
         nvinfer1::ITensor* alphaConstantTensor = alphaConstant->getOutput(0);
-        TRT_CHECK(broadcastTensors(ctx, alphaConstantTensor, matmulTensor));
         nvinfer1::IElementWiseLayer* scaledMatmul = ctx->network()->addElementWise(
             *alphaConstantTensor, *matmulTensor, nvinfer1::ElementWiseOperation::kPROD);
         matmulTensor = scaledMatmul->getOutput(0);
@@ -1422,15 +1520,23 @@ DEFINE_BUILTIN_OP_IMPORTER(Gemm)
     // In opset 11, the bias tensor is an optional input
     if (inputs.size() == 3)
     {
-        nvinfer1::ITensor* biasTensor = &convertToTensor(inputs.at(2), ctx);
+        TensorOrWeights bias = inputs.at(2);
+        const int matmulNbDims = matmulTensor->getDimensions().nbDims;
+        // Legacy (pre-opset 7) broadcasting is not supported by broadcastTensor, so only prepend ones from opset 7.
+        if (bias.is_weights() && bias.shape().nbDims < matmulNbDims && ctx->getOpsetVersion() >= 7)
+        {
+            TRT_CHECK(broadcastTensor(ctx, bias, matmulNbDims));
+        }
+        nvinfer1::ITensor* biasTensor = &convertToTensor(bias, ctx);
 
         // Scale C if needed
         if (beta != 1.f)
         {
+            nvinfer1::Dims scalarDims{biasTensor->getDimensions().nbDims, {}};
+            std::fill(scalarDims.d, scalarDims.d + scalarDims.nbDims, 1);
             nvinfer1::IConstantLayer* betaConstant
-                = addConstantScalar(ctx, beta, ::ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+                = addConstantScalar(ctx, beta, ::ONNX_NAMESPACE::TensorProto_DataType_FLOAT, scalarDims);
             nvinfer1::ITensor* betaConstantTensor = betaConstant->getOutput(0);
-            TRT_CHECK(broadcastTensors(ctx, betaConstantTensor, biasTensor));
             nvinfer1::IElementWiseLayer* scaledBias = ctx->network()->addElementWise(
                 *betaConstantTensor, *biasTensor, nvinfer1::ElementWiseOperation::kPROD);
             biasTensor = scaledBias->getOutput(0);
@@ -1893,16 +1999,218 @@ DEFINE_BUILTIN_OP_IMPORTER(Identity)
     RETURN_FIRST_OUTPUT(layer);
 }
 
-DEFINE_BUILTIN_OP_IMPORTER(If)
+// Upper bound on the combined FLOPs of both branches of an If whose condition is only known at runtime. Both
+// branches are always executed when it is lowered to a select, so anything above this is left unsupported and
+// falls back to the caller (e.g. a graph partition boundary) instead. No optimization profile is known while
+// importing, so dynamic dimensions count as 1 and the estimate is a lower bound for dynamic shapes: only branches
+// that are too expensive even then are rejected.
+constexpr int64_t MAX_SELECT_IF_FLOPS = int64_t(1) << 26;
+
+// Estimates the FLOPs of a graph from its ONNX description, before any of it is added to the network, so that a
+// rejected If leaves no dead layers behind. Shapes are taken from the outer scope, the initializers and the
+// declared value infos of the graph. Other tensors take the shape of the largest input of their producer, except
+// for MatMul, Gemm and Conv outputs which are derived from their inputs. Dynamic dimensions count as 1.
+int64_t estimateGraphFlops(IImporterContext* ctx, const ::ONNX_NAMESPACE::GraphProto& graph)
 {
-    OnnxAttrs attrs(node, ctx);
-    auto cond = inputs.at(0);
-    ASSERT(cond.is_weights() && cond.weights().count() == 1 && "If condition must be a initializer!",
-        ErrorCode::kUNSUPPORTED_NODE);
-    auto value = *(static_cast<int*>(cond.weights().values));
-    std::vector<TensorOrWeights> graphOutputs;
-    const ::ONNX_NAMESPACE::GraphProto& body = value == 1 ? attrs.get<const ::ONNX_NAMESPACE::GraphProto&>("then_branch") : attrs.get<const ::ONNX_NAMESPACE::GraphProto&>("else_branch");
+    using Shape = std::vector<int64_t>;
+    std::unordered_map<std::string, Shape> shapes;
+    auto declare = [&shapes](const ::ONNX_NAMESPACE::ValueInfoProto& info) {
+        if (!info.type().tensor_type().has_shape())
+        {
+            return;
+        }
+        Shape shape;
+        for (const auto& dim : info.type().tensor_type().shape().dim())
+        {
+            shape.push_back(dim.has_dim_value() ? std::max<int64_t>(dim.dim_value(), 1) : 1);
+        }
+        shapes[info.name()] = shape;
+    };
+    for (const auto& initializer : graph.initializer())
+    {
+        shapes[initializer.name()] = Shape(initializer.dims().begin(), initializer.dims().end());
+    }
+    for (const auto& input : graph.input())
+    {
+        declare(input);
+    }
+    for (const auto& info : graph.value_info())
+    {
+        declare(info);
+    }
+    for (const auto& output : graph.output())
+    {
+        declare(output);
+    }
+    auto lookupShape = [&shapes, ctx](const std::string& name, Shape* shape) {
+        const auto known = shapes.find(name);
+        if (known != shapes.end())
+        {
+            *shape = known->second;
+            return true;
+        }
+        const auto outer = ctx->tensors().find(name);
+        if (name.empty() || outer == ctx->tensors().end() || !outer->second)
+        {
+            return false;
+        }
+        const nvinfer1::Dims dims = outer->second.shape();
+        shape->clear();
+        for (int i = 0; i < dims.nbDims; ++i)
+        {
+            shape->push_back(std::max(dims.d[i], 1));
+        }
+        shapes[name] = *shape;
+        return true;
+    };
+    auto volumeOf = [](const Shape& shape) {
+        return std::accumulate(shape.begin(), shape.end(), int64_t(1), std::multiplies<int64_t>());
+    };
+
+    int64_t flops = 0;
+    for (const auto& node : graph.node())
+    {
+        std::vector<Shape> inputShapes(node.input_size());
+        std::vector<bool> known(node.input_size(), false);
+        Shape outputShape;
+        for (int i = 0; i < node.input_size(); ++i)
+        {
+            known[i] = lookupShape(node.input(i), &inputShapes[i]);
+            if (known[i] && volumeOf(inputShapes[i]) > volumeOf(outputShape))
+            {
+                outputShape = inputShapes[i];
+            }
+        }
+        const bool binaryKnown = node.input_size() >= 2 && known[0] && known[1];
+        const std::string& op = node.op_type();
+        if (op == "MatMul" && binaryKnown && !inputShapes[0].empty() && inputShapes[1].size() >= 2)
+        {
+            const Shape& a = inputShapes[0];
+            const Shape& b = inputShapes[1];
+            outputShape = a;
+            outputShape.back() = b.back();
+            flops += 2 * volumeOf(outputShape) * a.back();
+        }
+        else if (op == "Gemm" && binaryKnown && inputShapes[0].size() == 2 && inputShapes[1].size() == 2)
+        {
+            OnnxAttrs attrs(node, ctx);
+            const int64_t m = inputShapes[0][attrs.get("transA", 0) ? 1 : 0];
+            const int64_t k = inputShapes[0][attrs.get("transA", 0) ? 0 : 1];
+            const int64_t n = inputShapes[1][attrs.get("transB", 0) ? 0 : 1];
+            outputShape = {m, n};
+            flops += 2 * m * n * k + m * n;
+        }
+        else if ((op == "Conv" || op == "ConvTranspose") && binaryKnown && inputShapes[0].size() >= 2
+            && inputShapes[1].size() >= 2)
+        {
+            const Shape& weights = inputShapes[1];
+            const int64_t group = OnnxAttrs(node, ctx).get("group", 1);
+            // Spatial dimensions are assumed to be preserved, which overestimates strided convolutions.
+            outputShape = inputShapes[0];
+            if (op == "Conv")
+            {
+                outputShape[1] = weights[0];
+                flops += 2 * volumeOf(outputShape) * (volumeOf(weights) / weights[0]);
+            }
+            else
+            {
+                outputShape[1] = weights[1] * group;
+                flops += 2 * volumeOf(inputShapes[0]) * (volumeOf(weights) / weights[0]);
+            }
+        }
+        else
+        {
+            flops += volumeOf(outputShape);
+        }
+        for (const auto& attr : node.attribute())
+        {
+            if (attr.has_g())
+            {
+                flops += estimateGraphFlops(ctx, attr.g());
+            }
+            for (const auto& subgraph : attr.graphs())
+            {
+                flops += estimateGraphFlops(ctx, subgraph);
+            }
+        }
+        for (const auto& output : node.output())
+        {
+            // Keep declared shapes, which are more accurate than the propagated ones.
+            shapes.emplace(output, outputShape);
+        }
+    }
+    return flops;
+}
+
+// Checks that the branches of an If with a runtime condition declare outputs that can be selected between.
+// Shapes are only compared where both branches declare them; the imported outputs are checked again afterwards.
+Status checkIfBranchOutputs(const ::ONNX_NAMESPACE::GraphProto& thenGraph, const ::ONNX_NAMESPACE::GraphProto& elseGraph)
+{
+    ASSERT(thenGraph.output_size() == elseGraph.output_size(), ErrorCode::kINVALID_NODE);
+    for (int i = 0; i < thenGraph.output_size(); ++i)
+    {
+        const auto& thenType = thenGraph.output(i).type().tensor_type();
+        const auto& elseType = elseGraph.output(i).type().tensor_type();
+        ASSERT(thenType.elem_type() == elseType.elem_type()
+                && thenType.elem_type() != ::ONNX_NAMESPACE::TensorProto::BOOL
+                && "If branch outputs must have the same non-boolean type when the condition is not an initializer!",
+            ErrorCode::kUNSUPPORTED_NODE);
+        if (!thenType.has_shape() || !elseType.has_shape())
+        {
+            continue;
+        }
+        ASSERT(thenType.shape().dim_size() == elseType.shape().dim_size()
+                && "If branch outputs must have matching shapes when the condition is not an initializer!",
+            ErrorCode::kUNSUPPORTED_NODE);
+        for (int j = 0; j < thenType.shape().dim_size(); ++j)
+        {
+            const auto& thenDim = thenType.shape().dim(j);
+            const auto& elseDim = elseType.shape().dim(j);
+            ASSERT((!thenDim.has_dim_value() || !elseDim.has_dim_value()
+                       || thenDim.dim_value() == elseDim.dim_value())
+                    && "If branch outputs must have matching shapes when the condition is not an initializer!",
+                ErrorCode::kUNSUPPORTED_NODE);
+        }
+    }
+    return Status::success();
+}
+
+// Returns true if running the graph may have an observable effect beyond its outputs, or may produce different
+// outputs on every run. Such a branch cannot be executed speculatively.
+bool hasSideEffects(const ::ONNX_NAMESPACE::GraphProto& graph)
+{
+    static const std::unordered_set<std::string> nonDeterministicOps{"RandomNormal", "RandomNormalLike",
+        "RandomUniform", "RandomUniformLike", "Multinomial", "Bernoulli"};
+    for (const auto& node : graph.node())
+    {
+        if (nonDeterministicOps.count(node.op_type()))
+        {
+            return true;
+        }
+        for (const auto& attr : node.attribute())
+        {
+            if (attr.has_g() && hasSideEffects(attr.g()))
+            {
+                return true;
+            }
+            for (const auto& subgraph : attr.graphs())
+            {
+                if (hasSideEffects(subgraph))
+                {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// Imports one branch of an If in its own scope and returns its outputs.
+NodeImportResult importIfBranch(IImporterContext* ctx, const ::ONNX_NAMESPACE::GraphProto& body)
+{
+    SubgraphScope scope(ctx);
     TRT_CHECK(onnx2trt::parseGraph(ctx, body));
+    std::vector<TensorOrWeights> graphOutputs;
     const int nbOutputs = body.output_size();
     for (int i = 0; i < nbOutputs; i++)
     {
@@ -1911,6 +2219,66 @@ DEFINE_BUILTIN_OP_IMPORTER(If)
     return {graphOutputs};
 }
 
+DEFINE_BUILTIN_OP_IMPORTER(If)
+{
+    OnnxAttrs attrs(node, ctx);
+    auto cond = inputs.at(0);
+    const ::ONNX_NAMESPACE::GraphProto& thenGraph = attrs.get<const ::ONNX_NAMESPACE::GraphProto&>("then_branch");
+    const ::ONNX_NAMESPACE::GraphProto& elseGraph = attrs.get<const ::ONNX_NAMESPACE::GraphProto&>("else_branch");
+    if (cond.is_weights())
+    {
+        ASSERT(cond.weights().count() == 1 && "If condition must be a single value!", ErrorCode::kINVALID_NODE);
+        auto value = *(static_cast<int*>(cond.weights().values));
+        return importIfBranch(ctx, value == 1 ? thenGraph : elseGraph);
+    }
+
+    // The condition is only known at runtime: import both branches and select between their outputs.
+    ASSERT(cond.tensor().getType() == nvinfer1::DataType::kBOOL && volume(cond.shape()) == 1
+            && "If condition must be a single boolean value!",
+        ErrorCode::kINVALID_NODE);
+    ASSERT(!hasSideEffects(thenGraph) && !hasSideEffects(elseGraph)
+            && "If branches with a runtime condition must not contain random operators!",
+        ErrorCode::kUNSUPPORTED_NODE);
+    TRT_CHECK(checkIfBranchOutputs(thenGraph, elseGraph));
+
+    // Reject the node before importing anything, so that no dead branch layers are left in the network.
+    const int64_t thenFlops = estimateGraphFlops(ctx, thenGraph);
+    const int64_t elseFlops = estimateGraphFlops(ctx, elseGraph);
+    LOG_VERBOSE("Lowering If node " << node.name() << " to select, estimated branch FLOPs: then = " << thenFlops
+                                    << ", else = " << elseFlops);
+    ASSERT(thenFlops + elseFlops <= MAX_SELECT_IF_FLOPS
+            && "If branches with a runtime condition are too expensive to execute both!",
+        ErrorCode::kUNSUPPORTED_NODE);
+
+    std::vector<TensorOrWeights> thenOutputs;
+    GET_VALUE(importIfBranch(ctx, thenGraph), &thenOutputs);
+    std::vector<TensorOrWeights> elseOutputs;
+    GET_VALUE(importIfBranch(ctx, elseGraph), &elseOutputs);
+
+    std::vector<TensorOrWeights> outputs;
+    for (size_t i = 0; i < thenOutputs.size(); ++i)
+    {
+        nvinfer1::ITensor* thenTensor = &convertToTensor(thenOutputs.at(i), ctx);
+        nvinfer1::ITensor* elseTensor = &convertToTensor(elseOutputs.at(i), ctx);
+        const nvinfer1::Dims thenDims = thenTensor->getDimensions();
+        const nvinfer1::Dims elseDims = elseTensor->getDimensions();
+        ASSERT(thenDims.nbDims == elseDims.nbDims
+                && std::equal(thenDims.d, thenDims.d + thenDims.nbDims, elseDims.d)
+                && "If branch outputs must have matching shapes when the condition is not an initializer!",
+            ErrorCode::kUNSUPPORTED_NODE);
+        ASSERT(thenTensor->getType() == elseTensor->getType() && thenTensor->getType() != nvinfer1::DataType::kBOOL,
+            ErrorCode::kUNSUPPORTED_NODE);
+
+        nvinfer1::Dims condDims{thenDims.nbDims, {}};
+        std::fill(condDims.d, condDims.d + condDims.nbDims, 1);
+        nvinfer1::ITensor* condition = reshapeTensor(ctx, cond.tensor(), condDims);
+        auto* layer = ctx->network()->addSelect(*condition, *thenTensor, *elseTensor);
+        ctx->registerLayer(layer, node.name());
+        outputs.emplace_back(layer->getOutput(0));
+    }
+    return {outputs};
+}
+
 DEFINE_BUILTIN_OP_IMPORTER(ImageScaler)
 {
     nvinfer1::ITensor& tensor = convertToTensor(inputs.at(0), ctx);
@@ -1955,7 +2323,7 @@ DEFINE_BUILTIN_OP_IMPORTER(InstanceNormalization)
     f.emplace_back("bias", bias_weights.values, nvinfer1::PluginFieldType::kFLOAT32, bias_weights.count());
 
     // Create plugin from registry
-    nvinfer1::IPluginV2* plugin = createPlugin(node.name(), importPluginCreator(pluginName, pluginVersion), f);
+    nvinfer1::IPluginV2* plugin = createPlugin(node.name(), importPluginCreator(ctx, pluginName, pluginVersion), f);
 
     ASSERT(plugin != nullptr && "InstanceNormalization plugin was not found in the plugin registry!",
         ErrorCode::kUNSUPPORTED_NODE);
@@ -2007,9 +2375,17 @@ DEFINE_BUILTIN_OP_IMPORTER(Loop)
 {
     constexpr int NB_NON_STATE_INPUTS = 2; // First 2 inputs are trip count and condition respectively.
     constexpr int NB_DISCARDED_OUTPUTS
-        = 1; // First output is the updated value of the condition, and is ignored by the outer loop node.
-    constexpr int MAX_SCAN_OUTPUT_LENGTH = 1024; // Maximum length for scan outputs if trip count is not set.
+        = 1; // First output is the updated value of the condition, which is not an output of the outer loop node.
     ASSERT(inputs.size() >= 2, ErrorCode::kINVALID_NODE);
+    if (ctx->getLoopUnrollLimit() > 0)
+    {
+        bool unrolled = false;
+        NodeImportResult result = unrollLoop(ctx, node, inputs, &unrolled);
+        if (unrolled)
+        {
+            return result;
+        }
+    }
     OnnxAttrs attrs(node, ctx);
     const int nbInputs = node.input().size();
     // The number of state variables on the input and output is the same.
@@ -2017,6 +2393,7 @@ DEFINE_BUILTIN_OP_IMPORTER(Loop)
 
     const ::ONNX_NAMESPACE::GraphProto& body = attrs.get<const ::ONNX_NAMESPACE::GraphProto&>("body");
 
+    SubgraphScope scope(ctx);
     auto loop = ctx->network()->addLoop();
     loop->setName(getNodeName(node).c_str());
     // Trip count and condition are optional inputs.
@@ -2025,37 +2402,50 @@ DEFINE_BUILTIN_OP_IMPORTER(Loop)
     {
         tripLimit = convertToScalar(ctx, &convertToTensor(inputs[0], ctx));
         ASSERT(tripLimit, ErrorCode::kINVALID_NODE);
-        ctx->loopTensors()[body.input(0).name()] = node.input(0);
         loop->addTripLimit(*tripLimit, nvinfer1::TripLimit::kCOUNT);
         // First graph input is iteration_num, so create a loop counter
         auto counter = addLoopCounter(ctx, loop, 0);
         ctx->registerTensor(counter, body.input(0).name());
     }
+    else
+    {
+        // The body may still use the iteration number, e.g. to compute the condition.
+        ctx->registerTensor(addLoopCounter(ctx, loop, 0), body.input(0).name());
+    }
+    // The condition of each iteration is computed by the previous one, starting from the condition input.
+    nvinfer1::IRecurrenceLayer* condRecurrence{nullptr};
     if (inputs[1])
     {
         nvinfer1::ITensor* cond = convertToScalar(ctx, &convertToTensor(inputs[1], ctx));
         ASSERT(cond, ErrorCode::kINVALID_NODE);
-        ctx->loopTensors()[body.input(1).name()] = node.input(1);
-        loop->addTripLimit(*cond, nvinfer1::TripLimit::kWHILE);
-        ctx->registerTensor(cond, body.input(1).name());
+        condRecurrence = loop->addRecurrence(*cond);
+        loop->addTripLimit(*condRecurrence->getOutput(0), nvinfer1::TripLimit::kWHILE);
+        ctx->registerTensor(condRecurrence->getOutput(0), body.input(1).name());
     }
     // Add initial state inputs using recurrent layers.
     std::vector<nvinfer1::IRecurrenceLayer*> stateVars{};
     for (size_t i = 2; i < inputs.size(); ++i)
     {
         stateVars.emplace_back(loop->addRecurrence(convertToTensor(inputs[i], ctx)));
-        ctx->loopTensors()[body.input(i).name()] = node.input(i);
         ctx->registerTensor(TensorOrWeights{stateVars.back()->getOutput(0)}, body.input(i).name());
     }
 
     // Loop body
     TRT_CHECK(onnx2trt::parseGraph(ctx, body));
 
+    if (condRecurrence)
+    {
+        nvinfer1::ITensor* nextCond
+            = convertToScalar(ctx, &convertToTensor(ctx->tensors().at(body.output(0).name()), ctx));
+        ASSERT(nextCond, ErrorCode::kINVALID_NODE);
+        condRecurrence->setInput(1, *nextCond);
+    }
+
     // Set final values of state variables.
     std::vector<TensorOrWeights> nodeOutputs{};
     for (int i = 0; i < nbStateVars; ++i)
     {
-        // The first output of the body graph is the updated condition, which is ignored by the Loop node.
+        // The first output of the body graph is the updated condition, which only feeds the trip limit.
         const int index = i + NB_DISCARDED_OUTPUTS;
         const auto& bodyOutputName = body.output(index).name();
         auto& stateOutput = convertToTensor(ctx->tensors().at(bodyOutputName), ctx);
@@ -2068,6 +2458,35 @@ DEFINE_BUILTIN_OP_IMPORTER(Loop)
             loop->addLoopOutput(*stateVars.at(i)->getOutput(0), nvinfer1::LoopOutput::kLAST_VALUE)->getOutput(0));
     }
     const int nbOutputs = body.output_size();
+    // Scan outputs need their length up front. Without a trip count, use the length configured for this node, or
+    // else the bound implied by the condition, or else the configured default.
+    nvinfer1::ITensor* scanOutputLength = tripLimit;
+    if (!scanOutputLength && nbOutputs > nbStateVars + NB_DISCARDED_OUTPUTS)
+    {
+        bool nodeSpecific = false;
+        const int maxLength = ctx->getMaxScanOutputLength(getNodeName(node), &nodeSpecific);
+        if (!nodeSpecific)
+        {
+            bool exact = false;
+            scanOutputLength = inferLoopIterationBound(ctx, body, &exact);
+            if (!scanOutputLength)
+            {
+                LOG_WARNING("Loop " << getNodeName(node) << " has no trip count and its scan outputs are given length "
+                                    << maxLength << ". They are only valid up to the number of iterations run.");
+            }
+            else if (!exact)
+            {
+                LOG_WARNING("Loop " << getNodeName(node) << " has no trip count and its scan outputs are given the "
+                                    << "length implied by its condition, which may end the loop earlier. They are "
+                                    << "only valid up to the number of iterations run.");
+            }
+        }
+        if (!scanOutputLength)
+        {
+            scanOutputLength
+                = addConstantScalar(ctx, maxLength, ::ONNX_NAMESPACE::TensorProto_DataType_INT32)->getOutput(0);
+        }
+    }
     // Finally, set up scan outputs if there are any
     for (int i = nbStateVars + NB_DISCARDED_OUTPUTS; i < nbOutputs; ++i)
     {
@@ -2076,19 +2495,7 @@ DEFINE_BUILTIN_OP_IMPORTER(Loop)
         LOG_VERBOSE("For scan output: " << bodyOutputName << ", found matching tensor: " << scanOutput.getName()
                                         << ", with shape: " << scanOutput.getDimensions());
         nvinfer1::ILoopOutputLayer* trtScanOut = loop->addLoopOutput(scanOutput, nvinfer1::LoopOutput::kCONCATENATE, 0);
-        // If trip limit is set, we can set the loop output to the tripLimit, otherwise, set to some dummy constant
-        // value.
-        // In the latter case, the scan outputs must not be used in the rest of the model.
-        if (tripLimit)
-        {
-            trtScanOut->setInput(1, *tripLimit);
-        }
-        else
-        {
-            trtScanOut->setInput(
-                1, *addConstantScalar(ctx, MAX_SCAN_OUTPUT_LENGTH, ::ONNX_NAMESPACE::TensorProto_DataType_INT32)
-                        ->getOutput(0));
-        }
+        trtScanOut->setInput(1, *scanOutputLength);
         nodeOutputs.emplace_back(trtScanOut->getOutput(0));
     }
 
@@ -2638,6 +3045,292 @@ DEFINE_BUILTIN_OP_IMPORTER(Neg)
     return unaryHelper(ctx, node, inputs.at(0), nvinfer1::UnaryOperation::kNEG);
 }
 
+// Upper bound on the number of elements of the all-pairs tensors built by the native NonMaxSuppression ([B, C, N, N]
+// IoU masks) and ScatterND ([N, U] hit matrix) lowerings. Their memory grows quadratically with the input, so larger
+// nodes are left unsupported and fall back to the caller instead of failing to build. Dynamic dimensions count as 1,
+// as for MAX_SELECT_IF_FLOPS.
+constexpr int64_t MAX_PAIRWISE_ELEMENTS = int64_t(1) << 26;
+
+// Product of the static dimensions of a shape, counting dynamic dimensions as 1.
+int64_t staticVolume(const nvinfer1::Dims& dims, int begin, int end)
+{
+    int64_t count = 1;
+    for (int i = begin; i < end; ++i)
+    {
+        count *= std::max(dims.d[i], 1);
+    }
+    return count;
+}
+
+DEFINE_BUILTIN_OP_IMPORTER(NonMaxSuppression)
+{
+    // The number of selected boxes depends on the data, which TensorRT cannot express, so selected_indices is padded
+    // to a fixed number of rows. Padding rows are filled with -1.
+    nvinfer1::ITensor* boxes = &convertToTensor(inputs.at(0), ctx);
+    nvinfer1::ITensor& scores = convertToTensor(inputs.at(1), ctx);
+    ASSERT(boxes->getDimensions().nbDims == 3 && scores.getDimensions().nbDims == 3, ErrorCode::kINVALID_NODE);
+    const int nbBoxes = boxes->getDimensions().d[1];
+    const int nbClasses = scores.getDimensions().d[1];
+    ASSERT(nbBoxes > 0 && nbClasses > 0 && "NonMaxSuppression requires a static number of boxes and classes!",
+        ErrorCode::kUNSUPPORTED_NODE);
+
+    int64_t maxOutputBoxesPerClass = 0;
+    float iouThreshold = 0.f;
+    float scoreThreshold = std::numeric_limits<float>::lowest();
+    if (inputs.size() > 2 && inputs.at(2))
+    {
+        std::vector<int64_t> values;
+        TRT_CHECK(weightsToVector(inputs.at(2), &values));
+        ASSERT(values.size() == 1, ErrorCode::kINVALID_NODE);
+        maxOutputBoxesPerClass = values[0];
+    }
+    if (inputs.size() > 3 && inputs.at(3))
+    {
+        ASSERT(inputs.at(3).is_weights() && "NonMaxSuppression iou_threshold must be an initializer!",
+            ErrorCode::kUNSUPPORTED_NODE);
+        ASSERT(inputs.at(3).weights().type == ::ONNX_NAMESPACE::TensorProto::FLOAT
+                && inputs.at(3).weights().count() == 1,
+            ErrorCode::kINVALID_NODE);
+        iouThreshold = static_cast<float*>(inputs.at(3).weights().values)[0];
+    }
+    if (inputs.size() > 4 && inputs.at(4))
+    {
+        ASSERT(inputs.at(4).is_weights() && "NonMaxSuppression score_threshold must be an initializer!",
+            ErrorCode::kUNSUPPORTED_NODE);
+        ASSERT(inputs.at(4).weights().type == ::ONNX_NAMESPACE::TensorProto::FLOAT
+                && inputs.at(4).weights().count() == 1,
+            ErrorCode::kINVALID_NODE);
+        scoreThreshold = static_cast<float*>(inputs.at(4).weights().values)[0];
+    }
+    ASSERT(maxOutputBoxesPerClass > 0 && "NonMaxSuppression must select at least one box per class!",
+        ErrorCode::kUNSUPPORTED_NODE);
+
+    OnnxAttrs attrs(node, ctx);
+    int centerPointBox = attrs.get<int>("center_point_box", 0);
+    int keepTopK = static_cast<int>(std::min<int64_t>(maxOutputBoxesPerClass, nbBoxes));
+
+    // Prefer the EfficientNMS_ONNX_TRT plugin when the loaded plugin library registers it. It takes the ONNX inputs
+    // unchanged and returns the selected box indices themselves, with its own row layout and -1 padding.
+    if (nvinfer1::IPluginCreator* creator = importPluginCreator(ctx, "EfficientNMS_ONNX_TRT", "1"))
+    {
+        std::vector<nvinfer1::PluginField> f;
+        f.emplace_back("score_threshold", &scoreThreshold, nvinfer1::PluginFieldType::kFLOAT32, 1);
+        f.emplace_back("iou_threshold", &iouThreshold, nvinfer1::PluginFieldType::kFLOAT32, 1);
+        f.emplace_back("max_output_boxes_per_class", &keepTopK, nvinfer1::PluginFieldType::kINT32, 1);
+        f.emplace_back("center_point_box", &centerPointBox, nvinfer1::PluginFieldType::kINT32, 1);
+        nvinfer1::IPluginV2* plugin = createPlugin(getNodeName(node), creator, f);
+        ASSERT(plugin && "Failed to create the EfficientNMS_ONNX_TRT plugin!", ErrorCode::kUNSUPPORTED_NODE);
+        std::array<nvinfer1::ITensor*, 2> pluginInputs{boxes, &scores};
+        auto* layer = ctx->network()->addPluginV2(pluginInputs.data(), pluginInputs.size(), *plugin);
+        ctx->registerLayer(layer, getNodeName(node));
+        RETURN_FIRST_OUTPUT(layer);
+    }
+
+    // The native lowering keeps rows per (image, class) pair and compares all pairs of boxes of each pair.
+    ASSERT(nbBoxes <= 3840 && "NonMaxSuppression supports at most 3840 boxes per image!",
+        ErrorCode::kUNSUPPORTED_NODE);
+    const int64_t pairwiseElements
+        = staticVolume(boxes->getDimensions(), 0, 1) * nbClasses * static_cast<int64_t>(nbBoxes) * nbBoxes;
+    LOG_VERBOSE("NonMaxSuppression node " << getNodeName(node) << " needs " << pairwiseElements
+                                          << " elements per pairwise IoU tensor");
+    ASSERT(pairwiseElements <= MAX_PAIRWISE_ELEMENTS
+            && "NonMaxSuppression has too many boxes and classes for the pairwise IoU tensors "
+               "(batch * classes * boxes^2 is limited to 2^26)!",
+        ErrorCode::kUNSUPPORTED_NODE);
+
+    const auto boxesShape = shapeOf(*boxes);
+    const ShapeTensor batch = gather(ctx, boxesShape, shapeVector(0));
+    if (centerPointBox == 1)
+    {
+        // [x_center, y_center, width, height] -> [x1, y1, x2, y2]
+        const ShapeTensor halfSizes = concat(ctx, gather(ctx, boxesShape, iotaShapeVector(2)), shapeVector(2));
+        const ShapeTensor ones = similar(ctx, halfSizes, 1);
+        nvinfer1::ITensor* centers
+            = addSlice(ctx, *boxes, ShapeTensor(1, std::vector<int64_t>{0, 0, 0}), halfSizes, ones)->getOutput(0);
+        nvinfer1::ITensor* sizes
+            = addSlice(ctx, *boxes, ShapeTensor(1, std::vector<int64_t>{0, 0, 2}), halfSizes, ones)->getOutput(0);
+        nvinfer1::ITensor* half
+            = addConstantScalar(ctx, 0.5f, ::ONNX_NAMESPACE::TensorProto::FLOAT, makeDims(3, 1))->getOutput(0);
+        sizes = ctx->network()->addElementWise(*sizes, *half, nvinfer1::ElementWiseOperation::kPROD)->getOutput(0);
+        std::array<nvinfer1::ITensor*, 2> corners{
+            ctx->network()->addElementWise(*centers, *sizes, nvinfer1::ElementWiseOperation::kSUB)->getOutput(0),
+            ctx->network()->addElementWise(*centers, *sizes, nvinfer1::ElementWiseOperation::kSUM)->getOutput(0)};
+        auto* concat = ctx->network()->addConcatenation(corners.data(), corners.size());
+        concat->setAxis(2);
+        boxes = concat->getOutput(0);
+    }
+
+    // Every (image, class) pair is processed independently. Its boxes are sorted by descending score with TopK,
+    // whose indices carry the original box index through the selection. A box suppresses every lower-scoring box
+    // that it overlaps with an IoU above the threshold, unless it is itself suppressed.
+    auto elementwise = [ctx](nvinfer1::ITensor& a, nvinfer1::ITensor& b, nvinfer1::ElementWiseOperation op) {
+        return ctx->network()->addElementWise(a, b, op)->getOutput(0);
+    };
+    auto floatScalar = [ctx](float value, int nbDims) {
+        return addConstantScalar(ctx, value, ::ONNX_NAMESPACE::TensorProto::FLOAT, makeDims(nbDims, 1))->getOutput(0);
+    };
+    auto dims = [ctx, &batch](std::vector<int64_t> trailing) {
+        return concat(ctx, batch, ShapeTensor(1, std::move(trailing)));
+    };
+    auto linspace = [ctx](const ShapeTensor& length, float step) {
+        nvinfer1::IFillLayer* fill = addFill(ctx, length, nvinfer1::FillOperation::kLINSPACE);
+        fill->setAlpha(0);
+        fill->setBeta(step);
+        fill->setOutputType(0, nvinfer1::DataType::kINT32);
+        return fill->getOutput(0);
+    };
+
+    auto* sorted = ctx->network()->addTopK(scores, nvinfer1::TopKOperation::kMAX, nbBoxes, /*axes=*/1 << 2);
+    nvinfer1::ITensor* sortedScores = sorted->getOutput(0);
+    nvinfer1::ITensor* order = sorted->getOutput(1);
+
+    // Gather the [B, C, N, 4] sorted boxes from the [B * N, 4] flattened boxes.
+    nvinfer1::ITensor& imageOffsets = reshape(ctx, *linspace(batch, nbBoxes), dims({1, 1}));
+    nvinfer1::ITensor& flatBoxes
+        = reshape(ctx, *boxes, concat(ctx, mul(ctx, batch, shapeVector(nbBoxes)), shapeVector(4)));
+    nvinfer1::ITensor* sortedBoxes
+        = ctx->network()
+              ->addGather(flatBoxes, *elementwise(*order, imageOffsets, nvinfer1::ElementWiseOperation::kSUM), 0)
+              ->getOutput(0);
+
+    // Boxes may be given as any diagonal pair of corners.
+    const ShapeTensor ones4 = ShapeTensor(1, std::vector<int64_t>{1, 1, 1, 1});
+    const ShapeTensor corner = dims({nbClasses, nbBoxes, 2});
+    nvinfer1::ITensor* first
+        = addSlice(ctx, *sortedBoxes, ShapeTensor(1, std::vector<int64_t>{0, 0, 0, 0}), corner, ones4)->getOutput(0);
+    nvinfer1::ITensor* second
+        = addSlice(ctx, *sortedBoxes, ShapeTensor(1, std::vector<int64_t>{0, 0, 0, 2}), corner, ones4)->getOutput(0);
+    nvinfer1::ITensor* lo = elementwise(*first, *second, nvinfer1::ElementWiseOperation::kMIN);
+    nvinfer1::ITensor* hi = elementwise(*first, *second, nvinfer1::ElementWiseOperation::kMAX);
+
+    // Product of the two coordinates of the last axis, [..., 2] -> [...].
+    auto area = [&](nvinfer1::ITensor& extent, const ShapeTensor& shape) {
+        const int nbDims = extent.getDimensions().nbDims;
+        const ShapeTensor sizes
+            = concat(ctx, gather(ctx, shapeOf(extent), iotaShapeVector(nbDims - 1)), shapeVector(1));
+        const ShapeTensor strides = similar(ctx, sizes, 1);
+        std::vector<int64_t> start(nbDims, 0);
+        nvinfer1::ITensor* width = addSlice(ctx, extent, ShapeTensor(1, start), sizes, strides)->getOutput(0);
+        start.back() = 1;
+        nvinfer1::ITensor* height
+            = addSlice(ctx, extent, ShapeTensor(1, std::move(start)), sizes, strides)->getOutput(0);
+        return &reshape(ctx, *elementwise(*width, *height, nvinfer1::ElementWiseOperation::kPROD), shape);
+    };
+    const ShapeTensor rowsPair = dims({nbClasses, nbBoxes, 1, 2});
+    const ShapeTensor columnsPair = dims({nbClasses, 1, nbBoxes, 2});
+    nvinfer1::ITensor* interLo = elementwise(
+        reshape(ctx, *lo, rowsPair), reshape(ctx, *lo, columnsPair), nvinfer1::ElementWiseOperation::kMAX);
+    nvinfer1::ITensor* interHi = elementwise(
+        reshape(ctx, *hi, rowsPair), reshape(ctx, *hi, columnsPair), nvinfer1::ElementWiseOperation::kMIN);
+    nvinfer1::ITensor* interExtent = elementwise(
+        *elementwise(*interHi, *interLo, nvinfer1::ElementWiseOperation::kSUB), *floatScalar(0.f, 5),
+        nvinfer1::ElementWiseOperation::kMAX);
+    nvinfer1::ITensor* intersection = area(*interExtent, dims({nbClasses, nbBoxes, nbBoxes}));
+    nvinfer1::ITensor* boxAreas
+        = area(*elementwise(*hi, *lo, nvinfer1::ElementWiseOperation::kSUB), dims({nbClasses, nbBoxes}));
+    nvinfer1::ITensor* unionArea = elementwise(reshape(ctx, *boxAreas, dims({nbClasses, nbBoxes, 1})),
+        reshape(ctx, *boxAreas, dims({nbClasses, 1, nbBoxes})), nvinfer1::ElementWiseOperation::kSUM);
+    unionArea = elementwise(*unionArea, *intersection, nvinfer1::ElementWiseOperation::kSUB);
+    // IoU > threshold, without dividing by a union that may be 0.
+    nvinfer1::ITensor* overlaps = elementwise(*intersection,
+        *elementwise(*unionArea, *floatScalar(iouThreshold, 4), nvinfer1::ElementWiseOperation::kPROD),
+        nvinfer1::ElementWiseOperation::kGREATER);
+    // Only a higher-scoring box, i.e. an earlier one in sorted order, suppresses another.
+    nvinfer1::ITensor* positions = linspace(shapeVector(nbBoxes), 1);
+    nvinfer1::ITensor* earlier
+        = elementwise(reshape(ctx, *positions, ShapeTensor(1, std::vector<int64_t>{1, 1, 1, nbBoxes})),
+            reshape(ctx, *positions, ShapeTensor(1, std::vector<int64_t>{1, 1, nbBoxes, 1})),
+            nvinfer1::ElementWiseOperation::kLESS);
+    nvinfer1::ITensor* one = floatScalar(1.f, 4);
+    nvinfer1::ITensor* zero = floatScalar(0.f, 4);
+    nvinfer1::ITensor* suppresses
+        = ctx->network()
+              ->addSelect(*elementwise(*overlaps, *earlier, nvinfer1::ElementWiseOperation::kAND), *one, *zero)
+              ->getOutput(0);
+    nvinfer1::ITensor* candidates
+        = ctx->network()
+              ->addSelect(reshape(ctx,
+                              *elementwise(*sortedScores, *floatScalar(scoreThreshold, 3),
+                                  nvinfer1::ElementWiseOperation::kGREATER),
+                              dims({nbClasses, nbBoxes, 1})),
+                  *one, *zero)
+              ->getOutput(0);
+
+    // keep[i] = candidate[i] && no kept j < i suppresses i. Since a box only depends on the boxes before it, iterating
+    // from keep = candidates reaches the greedy selection after at most N steps, and stops as soon as keep no longer
+    // changes, which for typical detections is after a few steps.
+    nvinfer1::ILoop* loop = ctx->network()->addLoop();
+    nvinfer1::IRecurrenceLayer* keep = loop->addRecurrence(*candidates);
+    nvinfer1::IRecurrenceLayer* changes = loop->addRecurrence(*floatScalar(1.f, 0));
+    loop->addTripLimit(
+        *elementwise(*changes->getOutput(0), *floatScalar(0.f, 0), nvinfer1::ElementWiseOperation::kGREATER),
+        nvinfer1::TripLimit::kWHILE);
+    nvinfer1::ITensor* suppressors
+        = ctx->network()
+              ->addMatrixMultiply(*suppresses, nvinfer1::MatrixOperation::kNONE, *keep->getOutput(0),
+                  nvinfer1::MatrixOperation::kNONE)
+              ->getOutput(0);
+    nvinfer1::ITensor* nextKeep
+        = ctx->network()
+              ->addSelect(
+                  *elementwise(*suppressors, *zero, nvinfer1::ElementWiseOperation::kGREATER), *zero, *candidates)
+              ->getOutput(0);
+    nvinfer1::ITensor* delta = elementwise(*nextKeep, *keep->getOutput(0), nvinfer1::ElementWiseOperation::kSUB);
+    delta = elementwise(*delta, *delta, nvinfer1::ElementWiseOperation::kPROD);
+    keep->setInput(1, *nextKeep);
+    changes->setInput(
+        1, *ctx->network()->addReduce(*delta, nvinfer1::ReduceOperation::kSUM, (1 << 4) - 1, false)->getOutput(0));
+    nvinfer1::ITensor* kept = loop->addLoopOutput(*keep->getOutput(0), nvinfer1::LoopOutput::kLAST_VALUE)->getOutput(0);
+
+    // The first keepTopK kept boxes in sorted order are the ones with the largest (N - position) among kept boxes.
+    std::vector<float> ranks(nbBoxes);
+    std::iota(ranks.rbegin(), ranks.rend(), 1.f);
+    nvinfer1::ITensor* rankKeys = elementwise(reshape(ctx, *kept, dims({nbClasses, nbBoxes})),
+        *addConstant(ctx, ranks, ::ONNX_NAMESPACE::TensorProto::FLOAT, nvinfer1::Dims3{1, 1, nbBoxes})->getOutput(0),
+        nvinfer1::ElementWiseOperation::kPROD);
+    auto* selected = ctx->network()->addTopK(*rankKeys, nvinfer1::TopKOperation::kMAX, keepTopK, /*axes=*/1 << 2);
+    nvinfer1::ITensor* isValid = elementwise(
+        *selected->getOutput(0), *floatScalar(0.f, 3), nvinfer1::ElementWiseOperation::kGREATER);
+    nvinfer1::ITensor* rowOffsets = &reshape(
+        ctx, *linspace(mul(ctx, batch, shapeVector(nbClasses)), nbBoxes), dims({nbClasses, 1}));
+    nvinfer1::ITensor* boxIndices
+        = ctx->network()
+              ->addGather(reshape(ctx, *order, mul(ctx, batch, shapeVector(nbClasses * nbBoxes))),
+                  *elementwise(*selected->getOutput(1), *rowOffsets, nvinfer1::ElementWiseOperation::kSUM), 0)
+              ->getOutput(0);
+
+    // Assemble [batch, class, box] rows as a [B, C, keepTopK, 3] tensor, so that rows are ordered by image, class
+    // and descending score.
+    const ShapeTensor columnShape
+        = concat(ctx, batch, ShapeTensor(1, std::vector<int64_t>{nbClasses, keepTopK, 1}));
+    nvinfer1::ITensor& boxColumn = reshape(ctx, *boxIndices, columnShape);
+    nvinfer1::ITensor* zeros
+        = addConstantScalar(ctx, 0, ::ONNX_NAMESPACE::TensorProto::INT32, makeDims(4, 1))->getOutput(0);
+    zeros = ctx->network()->addElementWise(boxColumn, *zeros, nvinfer1::ElementWiseOperation::kPROD)->getOutput(0);
+    nvinfer1::ITensor* batchColumn = elementwise(
+        reshape(ctx, *linspace(batch, 1), dims({1, 1, 1})), *zeros, nvinfer1::ElementWiseOperation::kSUM);
+    std::vector<int32_t> classValues(nbClasses);
+    std::iota(classValues.begin(), classValues.end(), 0);
+    nvinfer1::ITensor* classColumn
+        = ctx->network()
+              ->addElementWise(*addConstant(ctx, classValues, ::ONNX_NAMESPACE::TensorProto::INT32,
+                                   nvinfer1::Dims4{1, nbClasses, 1, 1})
+                                    ->getOutput(0),
+                  *zeros, nvinfer1::ElementWiseOperation::kSUM)
+              ->getOutput(0);
+    std::array<nvinfer1::ITensor*, 3> columns{batchColumn, classColumn, &boxColumn};
+    auto* indices = ctx->network()->addConcatenation(columns.data(), columns.size());
+    indices->setAxis(3);
+
+    // Rows past the number of boxes kept for their (image, class) pair are padding.
+    isValid = &reshape(ctx, *isValid, columnShape);
+    nvinfer1::ITensor* padding
+        = addConstantScalar(ctx, -1, ::ONNX_NAMESPACE::TensorProto::INT32, makeDims(4, 1))->getOutput(0);
+    auto* select = ctx->network()->addSelect(*isValid, *indices->getOutput(0), *padding);
+    return {{&reshape(ctx, *select->getOutput(0),
+        concat(ctx, mul(ctx, batch, shapeVector(nbClasses * keepTopK)), shapeVector(3)))}};
+}
+
 DEFINE_BUILTIN_OP_IMPORTER(Not)
 {
     return unaryHelper(ctx, node, inputs.at(0), nvinfer1::UnaryOperation::kNOT);
@@ -2726,11 +3419,13 @@ DEFINE_BUILTIN_OP_IMPORTER(Pow)
 DEFINE_BUILTIN_OP_IMPORTER(PRelu)
 {
     ASSERT(inputs.size() == 2, ErrorCode::kINVALID_NODE);
-    nvinfer1::ITensor* input = &convertToTensor(inputs.at(0), ctx);
-    nvinfer1::ITensor* slopes = &convertToTensor(inputs.at(1), ctx);
+    TensorOrWeights inputOrWeights = inputs.at(0);
+    TensorOrWeights slopesOrWeights = inputs.at(1);
+    TRT_CHECK(broadcastTensors(ctx, inputOrWeights, slopesOrWeights));
+    nvinfer1::ITensor* input = &convertToTensor(inputOrWeights, ctx);
+    nvinfer1::ITensor* slopes = &convertToTensor(slopesOrWeights, ctx);
     ASSERT(input->getType() != nvinfer1::DataType::kINT32, ErrorCode::kUNSUPPORTED_NODE);
     ASSERT(slopes->getType() != nvinfer1::DataType::kINT32, ErrorCode::kUNSUPPORTED_NODE);
-    TRT_CHECK(broadcastTensors(ctx, input, slopes));
     auto* layer = ctx->network()->addParametricReLU(*input, *slopes);
     ctx->registerLayer(layer, node.name());
     RETURN_FIRST_OUTPUT(layer);
@@ -2995,6 +3690,271 @@ DEFINE_BUILTIN_OP_IMPORTER(Relu)
     return activationHelper(ctx, node, inputs, nvinfer1::ActivationType::kRELU);
 }
 
+// Interpolation taps of one axis of a Resize that is lowered to gathers: output element o along the axis is
+// bias[o] + sum_k weights[k][o] * input[indices[k][o]].
+struct ResizeTaps
+{
+    std::vector<std::vector<int32_t>> indices;
+    std::vector<std::vector<float>> weights;
+    std::vector<float> bias;
+    // Nearest neighbor taps without extrapolated outputs just copy input[indices[0][o]].
+    bool needsWeights{false};
+};
+
+struct ResizeAttributes
+{
+    std::string mode;
+    std::string transformationMode;
+    std::string nearestMode;
+    double cubicCoeffA;
+    bool excludeOutside;
+    float extrapolationValue;
+};
+
+// Computes the taps of one axis, following the ONNX reference implementation of Resize. resizedLength is the
+// unrounded output length, scale * inputLength, which the coordinate transformations are defined with.
+ResizeTaps computeResizeTaps(const ResizeAttributes& attrs, int32_t inputLength, int32_t outputLength,
+    double resizedLength, double scale, double roiStart, double roiEnd)
+{
+    const int nbTaps = attrs.mode == "cubic" ? 4 : attrs.mode == "linear" ? 2 : 1;
+    ResizeTaps taps;
+    taps.indices.assign(nbTaps, std::vector<int32_t>(outputLength));
+    taps.weights.assign(nbTaps, std::vector<float>(outputLength));
+    taps.bias.assign(outputLength, 0.F);
+    taps.needsWeights = nbTaps > 1;
+    const int64_t lastIndex = inputLength - 1;
+    auto clampIndex = [lastIndex](int64_t index) {
+        return static_cast<int32_t>(std::min(std::max(index, int64_t(0)), lastIndex));
+    };
+
+    for (int32_t o = 0; o < outputLength; ++o)
+    {
+        const std::string& transform = attrs.transformationMode;
+        double x{0.0};
+        if (transform == "align_corners")
+        {
+            x = resizedLength == 1 ? 0.0 : o * (inputLength - 1.0) / (resizedLength - 1.0);
+        }
+        else if (transform == "asymmetric")
+        {
+            x = o / scale;
+        }
+        else if (transform == "tf_crop_and_resize")
+        {
+            x = resizedLength == 1 ? (roiEnd - roiStart) * (inputLength - 1.0) / 2.0
+                                   : o * (roiEnd - roiStart) * (inputLength - 1.0) / (resizedLength - 1.0);
+            x += roiStart * (inputLength - 1.0);
+            if (x < 0.0 || x > inputLength - 1.0)
+            {
+                // Taps keep index 0 and weight 0.
+                taps.bias[o] = attrs.extrapolationValue;
+                taps.needsWeights = true;
+                continue;
+            }
+        }
+        else if (transform == "tf_half_pixel_for_nearest")
+        {
+            x = (o + 0.5) / scale;
+        }
+        else if (transform == "pytorch_half_pixel")
+        {
+            x = resizedLength == 1 ? -0.5 : (o + 0.5) / scale - 0.5;
+        }
+        else // half_pixel
+        {
+            x = (o + 0.5) / scale - 0.5;
+        }
+
+        // The taps are the nbTaps input positions closest to x, where ties go to the lower position. For an integral
+        // x this makes the ratio 1 rather than 0.
+        const bool integral = x == std::floor(x);
+        const double ratio = integral ? 1.0 : x - std::floor(x);
+        const int64_t first = static_cast<int64_t>(std::ceil(x)) - std::max(nbTaps / 2, 1);
+        if (nbTaps == 1)
+        {
+            bool roundUp = true;
+            if (!integral)
+            {
+                const std::string& rounding = attrs.nearestMode;
+                roundUp = rounding == "ceil" || (rounding == "round_prefer_ceil" && ratio >= 0.5)
+                    || (rounding == "round_prefer_floor" && ratio > 0.5);
+            }
+            taps.indices[0][o] = clampIndex(first + (roundUp ? 1 : 0));
+            taps.weights[0][o] = 1.F;
+            continue;
+        }
+
+        std::array<double, 4> coeffs{};
+        if (nbTaps == 2)
+        {
+            coeffs = {1.0 - ratio, ratio};
+        }
+        else
+        {
+            const double a = attrs.cubicCoeffA;
+            const double r1 = ratio + 1.0;
+            const double q = 1.0 - ratio;
+            const double q1 = q + 1.0;
+            coeffs = {((a * r1 - 5.0 * a) * r1 + 8.0 * a) * r1 - 4.0 * a,
+                ((a + 2.0) * ratio - (a + 3.0)) * ratio * ratio + 1.0, ((a + 2.0) * q - (a + 3.0)) * q * q + 1.0,
+                ((a * q1 - 5.0 * a) * q1 + 8.0 * a) * q1 - 4.0 * a};
+        }
+        if (attrs.excludeOutside)
+        {
+            double sum{0.0};
+            for (int k = 0; k < nbTaps; ++k)
+            {
+                if (first + k < 0 || first + k > lastIndex)
+                {
+                    coeffs[k] = 0.0;
+                }
+                sum += coeffs[k];
+            }
+            for (int k = 0; k < nbTaps; ++k)
+            {
+                coeffs[k] /= sum;
+            }
+        }
+        // Positions outside of the input take the value at its edge.
+        for (int k = 0; k < nbTaps; ++k)
+        {
+            taps.indices[k][o] = clampIndex(first + k);
+            taps.weights[k][o] = static_cast<float>(coeffs[k]);
+        }
+    }
+    return taps;
+}
+
+// Applies the taps along one axis with a gather per tap, scaled by constant per-position weights.
+nvinfer1::ITensor* resizeAxisWithGathers(
+    IImporterContext* ctx, nvinfer1::ITensor& input, int32_t axis, const ResizeTaps& taps)
+{
+    const int32_t rank = input.getDimensions().nbDims;
+    const int32_t outputLength = static_cast<int32_t>(taps.bias.size());
+    const nvinfer1::Dims indexDims{1, {outputLength}};
+    nvinfer1::Dims weightDims = makeDims(rank, 1);
+    weightDims.d[axis] = outputLength;
+    auto addWeights = [&](const std::vector<float>& values) {
+        nvinfer1::ITensor* weights
+            = addConstant(ctx, values, ::ONNX_NAMESPACE::TensorProto::FLOAT, weightDims)->getOutput(0);
+        return input.getType() == nvinfer1::DataType::kHALF ? castHelper(ctx, weights, input.getType()) : weights;
+    };
+
+    nvinfer1::ITensor* result{nullptr};
+    if (std::any_of(taps.bias.begin(), taps.bias.end(), [](float b) { return b != 0.F; }))
+    {
+        result = addWeights(taps.bias);
+    }
+    for (size_t k = 0; k < taps.indices.size(); ++k)
+    {
+        const auto& weights = taps.weights[k];
+        // The first tap is always gathered, as it gives the result its shape.
+        if (k > 0 && std::all_of(weights.begin(), weights.end(), [](float w) { return w == 0.F; }))
+        {
+            continue;
+        }
+        nvinfer1::ITensor* indices
+            = addConstant(ctx, taps.indices[k], ::ONNX_NAMESPACE::TensorProto::INT32, indexDims)->getOutput(0);
+        nvinfer1::ITensor* term = ctx->network()->addGather(input, *indices, axis)->getOutput(0);
+        if (!taps.needsWeights)
+        {
+            return term;
+        }
+        term = ctx->network()
+                   ->addElementWise(*term, *addWeights(weights), nvinfer1::ElementWiseOperation::kPROD)
+                   ->getOutput(0);
+        result = result
+            ? ctx->network()->addElementWise(*result, *term, nvinfer1::ElementWiseOperation::kSUM)->getOutput(0)
+            : term;
+    }
+    return result;
+}
+
+// Lowers a Resize that IResizeLayer cannot express (cubic interpolation, rounding nearest modes, and the TensorFlow
+// coordinate transformations) to separable gathers along each resized axis, with indices and weights computed on
+// the host. The resized axes of the input, and the scales or sizes, must be static.
+NodeImportResult importResizeWithGathers(IImporterContext* ctx, const ::ONNX_NAMESPACE::NodeProto& node,
+    std::vector<TensorOrWeights>& inputs, const ResizeAttributes& resizeAttrs)
+{
+    nvinfer1::ITensor* output = &convertToTensor(inputs.at(0), ctx);
+    const nvinfer1::Dims inputDims = output->getDimensions();
+    const int32_t rank = inputDims.nbDims;
+    auto isGiven = [&inputs](size_t i) {
+        return inputs.size() > i && !inputs.at(i).isNullTensor()
+            && (inputs.at(i).is_tensor() || inputs.at(i).weights().count() > 0);
+    };
+
+    // Sizes take precedence over scales, which are then derived from them.
+    std::vector<double> scales(rank, 1.0);
+    std::vector<double> resizedLengths(rank);
+    std::vector<int32_t> outputLengths(rank);
+    if (isGiven(3))
+    {
+        ASSERT(inputs.at(3).is_weights() && "Resize sizes must be an initializer!", ErrorCode::kUNSUPPORTED_NODE);
+        std::vector<int64_t> sizes;
+        TRT_CHECK(weightsToVector(inputs.at(3), &sizes));
+        ASSERT(static_cast<int32_t>(sizes.size()) == rank, ErrorCode::kINVALID_NODE);
+        for (int32_t i = 0; i < rank; ++i)
+        {
+            outputLengths[i] = static_cast<int32_t>(sizes[i]);
+            resizedLengths[i] = static_cast<double>(sizes[i]);
+            // Whether a dynamic axis is resized is unknown, which is rejected below.
+            scales[i] = inputDims.d[i] > 0 ? resizedLengths[i] / inputDims.d[i]
+                                           : std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+    else
+    {
+        ASSERT(isGiven(2) && inputs.at(2).is_weights() && "Resize scales must be an initializer!",
+            ErrorCode::kUNSUPPORTED_NODE);
+        const ShapedWeights& scaleWeights = inputs.at(2).weights();
+        ASSERT(scaleWeights.type == ::ONNX_NAMESPACE::TensorProto::FLOAT
+                && static_cast<int32_t>(scaleWeights.count()) == rank,
+            ErrorCode::kINVALID_NODE);
+        const float* scaleValues = static_cast<const float*>(scaleWeights.values);
+        for (int32_t i = 0; i < rank; ++i)
+        {
+            scales[i] = scaleValues[i];
+            resizedLengths[i] = scales[i] * inputDims.d[i];
+            outputLengths[i] = static_cast<int32_t>(std::floor(resizedLengths[i]));
+        }
+    }
+
+    std::vector<float> roi;
+    const bool crop = resizeAttrs.transformationMode == "tf_crop_and_resize";
+    if (crop)
+    {
+        ASSERT(isGiven(1) && inputs.at(1).is_weights() && "Resize roi must be an initializer!",
+            ErrorCode::kUNSUPPORTED_NODE);
+        const ShapedWeights& roiWeights = inputs.at(1).weights();
+        ASSERT(roiWeights.type == ::ONNX_NAMESPACE::TensorProto::FLOAT
+                && static_cast<int32_t>(roiWeights.count()) == 2 * rank,
+            ErrorCode::kINVALID_NODE);
+        const float* roiValues = static_cast<const float*>(roiWeights.values);
+        roi.assign(roiValues, roiValues + 2 * rank);
+    }
+
+    for (int32_t axis = 0; axis < rank; ++axis)
+    {
+        // Axes that are neither scaled nor cropped are left alone, except where the coordinate transformation
+        // shifts them.
+        const bool shifted = crop || resizeAttrs.transformationMode == "tf_half_pixel_for_nearest";
+        if (scales[axis] == 1.0 && !shifted)
+        {
+            continue;
+        }
+        ASSERT(inputDims.d[axis] > 0 && "Resized axes must be static when resizing with gathers!",
+            ErrorCode::kUNSUPPORTED_NODE);
+        const ResizeTaps taps = computeResizeTaps(resizeAttrs, inputDims.d[axis], outputLengths[axis],
+            resizedLengths[axis], scales[axis], crop ? roi[axis] : 0.0, crop ? roi[rank + axis] : 0.0);
+        output = resizeAxisWithGathers(ctx, *output, axis, taps);
+    }
+    // A resize that changes nothing still needs a layer of its own for the node's output.
+    nvinfer1::ILayer* layer = ctx->network()->addIdentity(*output);
+    ctx->registerLayer(layer, getNodeName(node));
+    RETURN_FIRST_OUTPUT(layer);
+}
+
 DEFINE_BUILTIN_OP_IMPORTER(Resize)
 {
     nvinfer1::ITensor& input = convertToTensor(inputs.at(0), ctx);
@@ -3004,29 +3964,39 @@ DEFINE_BUILTIN_OP_IMPORTER(Resize)
                 && "This version of TensorRT does not support INT32 or BOOL input for the Resize operator.", ErrorCode::kUNSUPPORTED_NODE);
     int inputRank = input.getDimensions().nbDims;
     ASSERT( (inputRank > 0) && "The input tensor cannot be a scalar.", ErrorCode::kUNSUPPORTED_NODE);
-    // Add resize layer
-    nvinfer1::IResizeLayer* layer = ctx->network()->addResize(input);
-    ctx->registerLayer(layer, getNodeName(node));
     OnnxAttrs attrs(node, ctx);
 
     auto mode = attrs.get<std::string>("mode", "nearest");
     auto resizeMode = mode == "nearest" ? nvinfer1::ResizeMode::kNEAREST : nvinfer1::ResizeMode::kLINEAR;
 
     std::string transformationMode = "half_pixel";
+    if (ctx->getOpsetVersion() >= 11)
+    {
+        transformationMode = attrs.get<std::string>("coordinate_transformation_mode", "half_pixel");
+        auto nearest_mode = attrs.get<std::string>("nearest_mode", "round_prefer_floor");
+        // Cubic interpolation, nearest modes other than floor and the TensorFlow coordinate transformations cannot
+        // be expressed with IResizeLayer.
+        if (mode == "cubic" || (mode == "nearest" && nearest_mode != "floor")
+            || transformationMode == "tf_crop_and_resize" || transformationMode == "tf_half_pixel_for_nearest")
+        {
+            const ResizeAttributes resizeAttrs{mode, transformationMode, nearest_mode,
+                attrs.get<float>("cubic_coeff_a", -0.75f), attrs.get<int>("exclude_outside", 0) != 0,
+                attrs.get<float>("extrapolation_value", 0.f)};
+            LOG_VERBOSE("Lowering resize " << getNodeName(node) << " to gathers");
+            return importResizeWithGathers(ctx, node, inputs, resizeAttrs);
+        }
+    }
+
+    // Add resize layer
+    nvinfer1::IResizeLayer* layer = ctx->network()->addResize(input);
+    ctx->registerLayer(layer, getNodeName(node));
 
     if (ctx->getOpsetVersion() >= 11)
     {
         // Check for TRT-supported resize attributes
-        transformationMode = attrs.get<std::string>("coordinate_transformation_mode", "half_pixel");
         ASSERT((transformationMode == "asymmetric" || transformationMode == "align_corners" || transformationMode == "half_pixel" || transformationMode == "pytorch_half_pixel")
                 && "This version of TensorRT only supports asymmetric, align_corners, half_pixel, and pytorch_half_pixel resize!",
                 ErrorCode::kUNSUPPORTED_NODE);
-        ASSERT(mode != "cubic" && "This version of TensorRT does not support cubic interpolation!",
-            ErrorCode::kUNSUPPORTED_NODE);
-        auto nearest_mode = attrs.get<std::string>("nearest_mode", "round_prefer_floor");
-        ASSERT((mode != "nearest" || nearest_mode == "floor")
-                && "This version of TensorRT only supports floor nearest_mode!",
-            ErrorCode::kUNSUPPORTED_NODE);
 
         // The existence of a fourth input means a shape was passed as the resize parameter
         // For ONNX resize with the "sizes", TensorRT's resize maps to ONNX's in the following ways:
@@ -3165,104 +4135,67 @@ DEFINE_BUILTIN_OP_IMPORTER(Reshape)
 DEFINE_BUILTIN_OP_IMPORTER(ReverseSequence)
 {
     OnnxAttrs attrs{node, ctx};
-    const int batch_axis = attrs.get<int>("batch_axis", 1);
+    const int batchAxis = attrs.get<int>("batch_axis", 1);
+    const int timeAxis = attrs.get<int>("time_axis", 0);
+    ASSERT((batchAxis == 0 || batchAxis == 1) && batchAxis + timeAxis == 1
+            && "ReverseSequence batch_axis and time_axis must be 0 and 1 in either order!",
+        ErrorCode::kINVALID_NODE);
 
     nvinfer1::ITensor* input = &convertToTensor(inputs.at(0), ctx);
-    int rank = input->getDimensions().nbDims;
+    const int rank = input->getDimensions().nbDims;
+    ASSERT(rank >= 2 && "ReverseSequence input must have at least rank 2!", ErrorCode::kINVALID_NODE);
     // Sequence tensor: indices tensor of rank = 1 and shape = [batchsize]
-    nvinfer1::ITensor* sequences = &convertToTensor(inputs.at(1), ctx);
-    std::vector<nvinfer1::ITensor*> tensors;
-    int size = sequences->getDimensions().d[0];
-
-    for (int i = 0; i < size; i++)
-    {
-
-        /*  Slice across each element in batch_axis
-
-        For batch_axis = 1
-            Starts =  {0, i, 0, 0...}
-            Sizes =   {D0, 1, D2, D3...}
-            Strides = {1, 1, 1, ...}
-
-        For batch_axis = 0
-            Starts =  {i, 0, 0, 0...}
-            Sizes =   {1, D1, D2, D3...}
-            Strides = {1, 1, 1, ...}
-        */
-
-        ShapeTensor starts = batch_axis == 0 ? concat(ctx, shapeVector(i), shapeVector(0)) : concat(ctx, shapeVector(0), shapeVector(i));
-        ShapeTensor sizes = batch_axis == 0 ? concat(ctx, shapeVector(1), ShapeTensor(*getAxisLength(ctx, input, 1, {1, {1}}))) : concat(ctx, ShapeTensor(*getAxisLength(ctx, input, 0, {1, {1}})), shapeVector(1));
-        ShapeTensor strides = fillShapeVector(ctx, 1, shapeVector(rank));
-
-        for (int j = 2; j < rank; j++)
-        {
-            starts = concat(ctx, starts, shapeVector(0));
-            sizes = concat(ctx, sizes, ShapeTensor(*getAxisLength(ctx, input, j, {1, {1}})));
-        }
-
-        auto s1 = addSlice(ctx, *input, starts, sizes, strides);
-        nvinfer1::ITensor* data = s1->getOutput(0);
-        data = squeezeTensor(ctx, node, *data, {batch_axis});
-        // Get sequence length for the current slice
-        auto seqIndex = ctx->network()->addSlice(*sequences, {1, {i}}, {1, {1}}, {1, {1}})->getOutput(0);
-
-        // First slice = slices data[seqIndex - 1 : 0 : -1] on axis 0
-        /*
-            Starts =  {seqIndex - 1, 0, 0 ...}
-            Sizes =   {seqIndex, D1, D2, ...}
-            Strides = {-1, 1, 1, ...}
-        */
-
-        int sliceRank = data->getDimensions().nbDims;
-        starts = sub(ctx, ShapeTensor(*seqIndex), shapeVector(1));
-        ShapeTensor startsFill = fillShapeVector(ctx, 0, shapeVector(sliceRank - 1));
-        starts = concat(ctx, starts, startsFill);
-
-        sizes = ShapeTensor(*seqIndex);
-        for (int j = 1; j < sliceRank; j++)
-        {
-            sizes = concat(ctx, sizes, ShapeTensor(*getAxisLength(ctx, data, j, {1, {1}})));
-        }
-
-        strides = shapeVector(-1);
-        ShapeTensor stridesFill = fillShapeVector(ctx, 1, shapeVector(sliceRank - 1));
-        strides = concat(ctx, strides, stridesFill);
-
-        auto firstSlice = addSlice(ctx, *data, starts, sizes, strides);
-        auto slice1 = firstSlice->getOutput(0);
-
-        // Second slice = slices data[seqIndex:end:1] on axis 0
-
-        /*
-            Starts =  {seqIndex, 0, 0 ... 0}
-            Sizes =   {D0 - seqIndex, D1, D2 ...}
-            Strides = {1, 1, 1, 1 ...}
-        */
-
-        starts = ShapeTensor(*seqIndex);
-        startsFill = fillShapeVector(ctx, 0, shapeVector(sliceRank - 1));
-        starts = concat(ctx, starts, startsFill);
-
-        sizes = sub(ctx, ShapeTensor(*getAxisLength(ctx, data, 0, {1, {1}})), ShapeTensor(*seqIndex));
-        for (int j = 1; j < sliceRank; j++)
-        {
-           sizes = concat(ctx, sizes, ShapeTensor(*getAxisLength(ctx, data, j, {1, {1}})));
-        }
-
-        strides = fillShapeVector(ctx, 1, shapeVector(sliceRank));
-
-        auto secondSlice = addSlice(ctx, *data, starts, sizes, strides);
-        auto slice2 = secondSlice->getOutput(0);
-
-        // Concat the two slices together
-        std::vector<nvinfer1::ITensor*> slices {slice1, slice2};
-        auto fullSliceLayer = ctx->network()->addConcatenation(slices.data(), slices.size());
-        tensors.emplace_back(unsqueezeTensor(ctx, node, *fullSliceLayer->getOutput(0), {batch_axis}));
-    }
-
-    auto concatLayer = ctx->network()->addConcatenation(tensors.data(), tensors.size());
-    concatLayer->setAxis(batch_axis);
-    RETURN_FIRST_OUTPUT(concatLayer);
+    nvinfer1::ITensor* sequenceLens = &convertToTensor(inputs.at(1), ctx);
+
+    // Every (time, batch) pair of the grid formed by the first two axes reads from time index
+    // t < len[b] ? len[b] - 1 - t : t of the same batch, so the output is a single gather from the input, with the
+    // first two axes flattened.
+    const ShapeTensor inputShape = shapeOf(*input);
+    const ShapeTensor gridShape = gather(ctx, inputShape, iotaShapeVector(2));
+    auto addGrid = [&](const ShapeTensor& deltas) {
+        nvinfer1::IFillLayer* fill = addFill(ctx, gridShape, nvinfer1::FillOperation::kLINSPACE);
+        fill->setInput(1, shapeScalar(0).tensor(ctx));
+        fill->setInput(2, deltas.tensor(ctx));
+        return fill->getOutput(0);
+    };
+    const ShapeTensor dim1 = gather(ctx, inputShape, shapeVector(1));
+    nvinfer1::ITensor* positions = addGrid(concat(ctx, dim1, shapeVector(1)));
+    nvinfer1::ITensor* times = addGrid(ShapeTensor(1, std::vector<int64_t>{timeAxis == 0 ? 1 : 0, timeAxis}));
+
+    const ShapeTensor lensShape(1, batchAxis == 0 ? std::vector<int64_t>{-1, 1} : std::vector<int64_t>{1, -1});
+    nvinfer1::ITensor* lens = &reshape(ctx, *sequenceLens, lensShape);
+    nvinfer1::ITensor* one
+        = addConstantScalar(ctx, 1, ::ONNX_NAMESPACE::TensorProto::INT32, makeDims(2, 1))->getOutput(0);
+    nvinfer1::ITensor* reversed
+        = ctx->network()->addElementWise(*lens, *times, nvinfer1::ElementWiseOperation::kSUB)->getOutput(0);
+    reversed = ctx->network()->addElementWise(*reversed, *one, nvinfer1::ElementWiseOperation::kSUB)->getOutput(0);
+    nvinfer1::ITensor* isReversed
+        = ctx->network()->addElementWise(*times, *lens, nvinfer1::ElementWiseOperation::kLESS)->getOutput(0);
+    nvinfer1::ITensor* sourceTimes = ctx->network()->addSelect(*isReversed, *reversed, *times)->getOutput(0);
+
+    // Moving by one time step moves by dim1 positions if time is the outer axis of the grid, and by one otherwise.
+    nvinfer1::ITensor* timeShifts
+        = ctx->network()->addElementWise(*sourceTimes, *times, nvinfer1::ElementWiseOperation::kSUB)->getOutput(0);
+    if (timeAxis == 0)
+    {
+        nvinfer1::ITensor& timeStride = reshape(ctx, dim1.tensor(ctx), ShapeTensor(1, std::vector<int64_t>{1, 1}));
+        timeShifts = ctx->network()
+                         ->addElementWise(*timeShifts, timeStride, nvinfer1::ElementWiseOperation::kPROD)
+                         ->getOutput(0);
+    }
+    nvinfer1::ITensor* sources
+        = ctx->network()->addElementWise(*positions, *timeShifts, nvinfer1::ElementWiseOperation::kSUM)->getOutput(0);
+
+    ShapeTensor flattenedShape = product(ctx, inputShape, 0, 2, 1);
+    if (rank > 2)
+    {
+        std::vector<int64_t> trailingAxes(rank - 2);
+        std::iota(trailingAxes.begin(), trailingAxes.end(), 2);
+        flattenedShape = concat(ctx, flattenedShape, gather(ctx, inputShape, ShapeTensor(1, std::move(trailingAxes))));
+    }
+    auto* layer = ctx->network()->addGather(reshape(ctx, *input, flattenedShape), *sources, 0);
+    ctx->registerLayer(layer, getNodeName(node));
+    RETURN_FIRST_OUTPUT(layer);
 }
 
 DEFINE_BUILTIN_OP_IMPORTER(RNN)
@@ -3491,6 +4424,17 @@ DEFINE_BUILTIN_OP_IMPORTER(Scan)
         TRT_CHECK(convertAxis(axis, nvinfer1::Dims::MAX_DIMS));
     }
 
+    if (ctx->getLoopUnrollLimit() > 0)
+    {
+        bool unrolled = false;
+        NodeImportResult result = unrollScan(ctx, node, inputs, &unrolled);
+        if (unrolled)
+        {
+            return result;
+        }
+    }
+
+    SubgraphScope scope(ctx);
     auto loop = ctx->network()->addLoop();
     // When multiple scan inputs are present, scan behaves like zip, so it is sufficient
     // to use only one scan input to determine trip limit.
@@ -3552,6 +4496,72 @@ DEFINE_BUILTIN_OP_IMPORTER(Scan)
     return {nodeOutputs};
 }
 
+DEFINE_BUILTIN_OP_IMPORTER(ScatterND)
+{
+    nvinfer1::ITensor& data = convertToTensor(inputs.at(0), ctx);
+    nvinfer1::ITensor& indices = convertToTensor(inputs.at(1), ctx);
+    nvinfer1::ITensor& updates = convertToTensor(inputs.at(2), ctx);
+    ASSERT(data.getType() == nvinfer1::DataType::kFLOAT && updates.getType() == nvinfer1::DataType::kFLOAT
+            && "TensorRT only supports ScatterND on FLOAT tensors!",
+        ErrorCode::kUNSUPPORTED_NODE);
+    OnnxAttrs attrs(node, ctx);
+    ASSERT(attrs.get<std::string>("reduction", "none") == "none"
+            && "TensorRT only supports ScatterND without reduction!",
+        ErrorCode::kUNSUPPORTED_NODE);
+
+    const int dataRank = data.getDimensions().nbDims;
+    const int indicesRank = indices.getDimensions().nbDims;
+    ASSERT(indicesRank >= 1, ErrorCode::kINVALID_NODE);
+    const int k = indices.getDimensions().d[indicesRank - 1];
+    ASSERT(k > 0 && "The last dimension of ScatterND indices must be static!", ErrorCode::kUNSUPPORTED_NODE);
+    ASSERT(k <= dataRank, ErrorCode::kINVALID_NODE);
+
+    // With data flattened to [N, M] (N = product of the first k axes), updates flattened to [U, M] and the U linear
+    // indices L, compare every row against every index: H[n, u] = (L[u] == n). The argmax of H over u names the
+    // update row that lands on row n, which is gathered, and a row of data is replaced wherever a row of H has a hit.
+    // There is no scatter layer, so this costs O(N * U) memory and comparisons; the update values are only copied.
+    const int64_t hitElements
+        = staticVolume(data.getDimensions(), 0, k) * staticVolume(indices.getDimensions(), 0, indicesRank - 1);
+    ASSERT(hitElements <= MAX_PAIRWISE_ELEMENTS
+            && "ScatterND has too many data rows and updates for the one-hot hit matrix "
+               "(rows * updates is limited to 2^26)!",
+        ErrorCode::kUNSUPPORTED_NODE);
+    const auto dataShape = shapeOf(data);
+    const ShapeTensor n = product(ctx, dataShape, 0, k, 1);
+    const ShapeTensor m = product(ctx, dataShape, k, dataRank, 1);
+    const ShapeTensor u = product(ctx, shapeOf(indices), 0, indicesRank - 1, 1);
+    nvinfer1::ITensor& flatData = reshape(ctx, data, concat(ctx, n, m));
+    nvinfer1::ITensor& flatUpdates = reshape(ctx, updates, concat(ctx, u, m));
+    nvinfer1::ITensor& linear = reshape(ctx, *linearizeIndices(ctx, data, indices), concat(ctx, shapeVector(1), u));
+
+    nvinfer1::IFillLayer* rows = addFill(ctx, n, nvinfer1::FillOperation::kLINSPACE);
+    rows->setAlpha(0);
+    rows->setBeta(1);
+    rows->setOutputType(0, nvinfer1::DataType::kINT32);
+    nvinfer1::ITensor& rowIndices = reshape(ctx, *rows->getOutput(0), concat(ctx, n, shapeVector(1)));
+    nvinfer1::ITensor* isTarget
+        = ctx->network()->addElementWise(rowIndices, linear, nvinfer1::ElementWiseOperation::kEQUAL)->getOutput(0);
+
+    // TopK only takes floating-point input, so the hits are turned into 0/1 values first.
+    const nvinfer1::Dims scalarDims = makeDims(2, 1);
+    nvinfer1::ITensor* one
+        = addConstantScalar(ctx, 1.f, ::ONNX_NAMESPACE::TensorProto::FLOAT, scalarDims)->getOutput(0);
+    nvinfer1::ITensor* zero
+        = addConstantScalar(ctx, 0.f, ::ONNX_NAMESPACE::TensorProto::FLOAT, scalarDims)->getOutput(0);
+    nvinfer1::ITensor* oneHot = ctx->network()->addSelect(*isTarget, *one, *zero)->getOutput(0);
+    nvinfer1::ITopKLayer* firstHit = ctx->network()->addTopK(*oneHot, nvinfer1::TopKOperation::kMAX, 1, /*axes=*/0b10);
+    nvinfer1::ITensor* isUpdated = ctx->network()
+                                       ->addElementWise(*firstHit->getOutput(0), *zero,
+                                           nvinfer1::ElementWiseOperation::kGREATER)
+                                       ->getOutput(0);
+    // Gathering [U, M] with [N, 1] indices gives [N, 1, M].
+    nvinfer1::ITensor* gathered = ctx->network()->addGather(flatUpdates, *firstHit->getOutput(1), 0)->getOutput(0);
+    nvinfer1::ITensor& scattered = reshape(ctx, *gathered, concat(ctx, n, m));
+    auto* layer = ctx->network()->addSelect(*isUpdated, scattered, flatData);
+    ctx->registerLayer(layer, node.name());
+    return {{&reshape(ctx, *layer->getOutput(0), dataShape)}};
+}
+
 DEFINE_BUILTIN_OP_IMPORTER(Selu)
 {
     OnnxAttrs attrs(node, ctx);
@@ -4137,14 +5147,16 @@ DEFINE_BUILTIN_OP_IMPORTER(Upsample)
 
 DEFINE_BUILTIN_OP_IMPORTER(Where)
 {
-    nvinfer1::ITensor* condition = &convertToTensor(inputs.at(0), ctx);
-    nvinfer1::ITensor* x = &convertToTensor(inputs.at(1), ctx);
-    nvinfer1::ITensor* y = &convertToTensor(inputs.at(2), ctx);
+    TensorOrWeights conditionOrWeights = inputs.at(0);
+    TensorOrWeights xOrWeights = inputs.at(1);
+    TensorOrWeights yOrWeights = inputs.at(2);
+    TRT_CHECK(broadcastTensors(ctx, xOrWeights, yOrWeights, conditionOrWeights));
+    nvinfer1::ITensor* condition = &convertToTensor(conditionOrWeights, ctx);
+    nvinfer1::ITensor* x = &convertToTensor(xOrWeights, ctx);
+    nvinfer1::ITensor* y = &convertToTensor(yOrWeights, ctx);
     // TRT does not support BOOL input types for this node
     ASSERT(x->getType() == y->getType() && x->getType() != nvinfer1::DataType::kBOOL, ErrorCode::kUNSUPPORTED_NODE);
 
-    TRT_CHECK(broadcastTensors(ctx, x, y, condition));
-
     nvinfer1::Dims cDims = condition->getDimensions();
     nvinfer1::Dims xDims = x->getDimensions();
     nvinfer1::Dims yDims = y->getDimensions();
@@ -4158,91 +5170,150 @@ DEFINE_BUILTIN_OP_IMPORTER(Where)
     RETURN_FIRST_OUTPUT(layer);
 }
 
-// Copies the given field into the fieldData map, returns data and number of T elements in the vector in which the data was copied into.
-template <typename T>
-std::tuple<const void*, size_t> copyField(const T& field, const std::string& fieldName, string_map<std::vector<uint8_t>>& fieldData)
+// Bump allocator for the data of the plugin fields of one node. Its capacity is computed up front, so that field data
+// is copied into a single allocation and pointers to it stay valid until the plugin is created.
+class PluginFieldArena
 {
-    constexpr size_t nbBytes{sizeof(T)};
-    fieldData[fieldName].resize(nbBytes);
-    std::memcpy(fieldData[fieldName].data(), &field, nbBytes);
-    return std::make_tuple(fieldData[fieldName].data(), fieldData[fieldName].size() / nbBytes);
-}
+public:
+    // Fields are aligned for any of the plugin field types.
+    static constexpr size_t kALIGNMENT{alignof(double)};
 
-template <typename T>
-std::tuple<const void*, size_t> copyField(const std::vector<T>& repeatedField, const std::string& fieldName, string_map<std::vector<uint8_t>>& fieldData)
+    explicit PluginFieldArena(size_t capacity)
+        : mBuffer(new uint8_t[capacity])
+        , mCapacity(capacity)
+    {
+    }
+
+    template <typename T>
+    T* allocate(size_t count)
+    {
+        const size_t offset = (mSize + kALIGNMENT - 1) / kALIGNMENT * kALIGNMENT;
+        assert(offset + sizeof(T) * count <= mCapacity && "Plugin field arena is too small");
+        mSize = offset + sizeof(T) * count;
+        return reinterpret_cast<T*>(mBuffer.get() + offset);
+    }
+
+    // Upper bound of the bytes that plugin field data copied from attr takes up in an arena, padding included.
+    static size_t requiredBytes(const ::ONNX_NAMESPACE::AttributeProto& attr)
+    {
+        size_t nbBytes{0};
+        switch (attr.type())
+        {
+        case ::ONNX_NAMESPACE::AttributeProto::FLOAT: nbBytes = sizeof(float); break;
+        case ::ONNX_NAMESPACE::AttributeProto::INT: nbBytes = sizeof(int32_t); break;
+        case ::ONNX_NAMESPACE::AttributeProto::STRING: nbBytes = attr.s().size(); break;
+        case ::ONNX_NAMESPACE::AttributeProto::FLOATS: nbBytes = sizeof(float) * attr.floats_size(); break;
+        case ::ONNX_NAMESPACE::AttributeProto::INTS: nbBytes = sizeof(int32_t) * attr.ints_size(); break;
+        case ::ONNX_NAMESPACE::AttributeProto::STRINGS:
+            for (const auto& str : attr.strings())
+            {
+                nbBytes += str.size();
+            }
+            break;
+        default: break; // Tensors are not copied, other types are rejected.
+        }
+        return nbBytes + kALIGNMENT - 1;
+    }
+
+private:
+    std::unique_ptr<uint8_t[]> mBuffer;
+    size_t mCapacity;
+    size_t mSize{0};
+};
+
+// Copies the given values into the arena, converted to T. Returns the copy and the number of T elements in it.
+template <typename T, typename Iter>
+std::tuple<const void*, size_t> copyField(Iter first, Iter last, PluginFieldArena& arena)
 {
-    const size_t nbBytes{sizeof(T) * repeatedField.size()};
-    fieldData[fieldName].resize(nbBytes);
-    std::memcpy(fieldData[fieldName].data(), repeatedField.data(), nbBytes);
-    return std::make_tuple(fieldData[fieldName].data(), fieldData[fieldName].size() / sizeof(T));
+    const size_t count = std::distance(first, last);
+    T* data = arena.allocate<T>(count);
+    std::transform(first, last, data, [](decltype(*first) value) { return static_cast<T>(value); });
+    return std::make_tuple(data, count);
 }
 
-std::tuple<const void*, size_t> copyField(const std::string& field, const std::string& fieldName, string_map<std::vector<uint8_t>>& fieldData)
+template <typename T>
+std::tuple<const void*, size_t> copyField(const T& field, PluginFieldArena& arena)
 {
-    static_assert(sizeof(std::string::value_type) == sizeof(uint8_t), "String type does not have 1 byte elements");
-    std::copy(field.begin(), field.end(), std::back_inserter(fieldData[fieldName]));
-    return std::make_tuple(fieldData[fieldName].data(), fieldData[fieldName].size());
+    return copyField<T>(&field, &field + 1, arena);
 }
 
-std::tuple<const void*, size_t> copyField(const std::vector<std::string>& repeatedField, const std::string& fieldName, string_map<std::vector<uint8_t>>& fieldData)
+std::tuple<const void*, size_t> copyField(
+    const google::protobuf::RepeatedPtrField<std::string>& repeatedField, PluginFieldArena& arena)
 {
     static_assert(sizeof(std::string::value_type) == sizeof(uint8_t), "String type does not have 1 byte elements");
+    size_t nbBytes{0};
     for (const auto& field : repeatedField)
     {
-        std::copy(field.begin(), field.end(), std::back_inserter(fieldData[fieldName]));
+        nbBytes += field.size();
     }
-    return std::make_tuple(fieldData[fieldName].data(), fieldData[fieldName].size());
+    char* data = arena.allocate<char>(nbBytes);
+    for (const auto& field : repeatedField)
+    {
+        data = std::copy(field.begin(), field.end(), data);
+    }
+    return std::make_tuple(data - nbBytes, nbBytes);
 }
 
-std::tuple<const void*, size_t> copyField(
-    const ShapedWeights& field, const std::string& fieldName, string_map<std::vector<uint8_t>>& fieldData)
+std::tuple<const void*, size_t> copyField(const ShapedWeights& field, PluginFieldArena& /*arena*/)
 {
     // Weights do not require a copy
     return std::make_tuple(field.values, field.count());
 }
 
-// Load plugin fields from an ONNX node, using fieldData for temporary allocations.
-std::vector<nvinfer1::PluginField> loadFields(string_map<std::vector<uint8_t>>& fieldData, const OnnxAttrs& attrs,
-    const nvinfer1::PluginFieldCollection* fieldNames)
+// Upper bound of the arena capacity needed to load the given plugin fields from an ONNX node.
+size_t pluginFieldBytes(const OnnxAttrs& attrs, const nvinfer1::PluginFieldCollection* fieldNames)
+{
+    size_t nbBytes{0};
+    for (int i = 0; i < fieldNames->nbFields; ++i)
+    {
+        nbBytes += PluginFieldArena::requiredBytes(*attrs.at(fieldNames->fields[i].name));
+    }
+    return nbBytes;
+}
+
+// Load plugin fields from an ONNX node. Field data is copied into the arena, field names are owned by the creator.
+std::vector<nvinfer1::PluginField> loadFields(
+    PluginFieldArena& arena, const OnnxAttrs& attrs, const nvinfer1::PluginFieldCollection* fieldNames)
 {
     std::vector<nvinfer1::PluginField> fields{};
+    fields.reserve(fieldNames->nbFields);
     for (int i = 0; i < fieldNames->nbFields; ++i)
     {
-        // Name must be retrieved from the map so that it is alive for long enough.
-        const std::string& fieldName = fieldData.emplace(fieldNames->fields[i].name, std::vector<uint8_t>{}).first->first;
+        const char* fieldName = fieldNames->fields[i].name;
+        const ::ONNX_NAMESPACE::AttributeProto& attr = *attrs.at(fieldName);
         const void* data{nullptr};
         int32_t length{0};
         nvinfer1::PluginFieldType type{};
-        switch (attrs.type(fieldName))
+        switch (attr.type())
         {
             case ::ONNX_NAMESPACE::AttributeProto::FLOAT:
-                std::tie(data, length) = copyField(attrs.get<float>(fieldName), fieldName, fieldData);
+                std::tie(data, length) = copyField(attr.f(), arena);
                 type = nvinfer1::PluginFieldType::kFLOAT32;
                 break;
             case ::ONNX_NAMESPACE::AttributeProto::INT:
-                std::tie(data, length) = copyField(attrs.get<int>(fieldName), fieldName, fieldData);
+                std::tie(data, length) = copyField(static_cast<int32_t>(attr.i()), arena);
                 type = nvinfer1::PluginFieldType::kINT32;
                 break;
             case ::ONNX_NAMESPACE::AttributeProto::STRING:
-                std::tie(data, length) = copyField(attrs.get<std::string>(fieldName), fieldName, fieldData);
+                std::tie(data, length) = copyField<char>(attr.s().begin(), attr.s().end(), arena);
                 type = nvinfer1::PluginFieldType::kCHAR;
                 break;
             case ::ONNX_NAMESPACE::AttributeProto::FLOATS:
-                std::tie(data, length) = copyField(attrs.get<std::vector<float>>(fieldName), fieldName, fieldData);
+                std::tie(data, length) = copyField<float>(attr.floats().begin(), attr.floats().end(), arena);
                 type = nvinfer1::PluginFieldType::kFLOAT32;
                 break;
             case ::ONNX_NAMESPACE::AttributeProto::INTS:
-                std::tie(data, length) = copyField(attrs.get<std::vector<int>>(fieldName), fieldName, fieldData);
+                std::tie(data, length) = copyField<int32_t>(attr.ints().begin(), attr.ints().end(), arena);
                 type = nvinfer1::PluginFieldType::kINT32;
                 break;
             case ::ONNX_NAMESPACE::AttributeProto::STRINGS:
-                std::tie(data, length) = copyField(attrs.get<std::vector<std::string>>(fieldName), fieldName, fieldData);
+                std::tie(data, length) = copyField(attr.strings(), arena);
                 type = nvinfer1::PluginFieldType::kCHAR;
                 break;
             case ::ONNX_NAMESPACE::AttributeProto::TENSOR:
             {
                 ShapedWeights tensor{attrs.get<ShapedWeights>(fieldName)};
-                std::tie(data, length) = copyField(tensor, fieldName, fieldData);
+                std::tie(data, length) = copyField(tensor, arena);
                 switch (tensor.type)
                 {
                 case ::ONNX_NAMESPACE::TensorProto::FLOAT: type = nvinfer1::PluginFieldType::kFLOAT32; break;
@@ -4276,11 +5347,11 @@ std::vector<nvinfer1::PluginField> loadFields(string_map<std::vector<uint8_t>>&
             case ::ONNX_NAMESPACE::AttributeProto::SPARSE_TENSORS:
             case ::ONNX_NAMESPACE::AttributeProto::GRAPHS:
                 MAKE_ERROR(
-                    "Attributes of type: " + ::ONNX_NAMESPACE::AttributeProto::AttributeType_Name(attrs.type(fieldName))
+                    "Attributes of type: " + ::ONNX_NAMESPACE::AttributeProto::AttributeType_Name(attr.type())
                         + " are unsupported",
                     ErrorCode::kUNSUPPORTED_NODE);
             }
-            fields.emplace_back(fieldName.c_str(), data, type, length);
+            fields.emplace_back(fieldName, data, type, length);
     }
     return fields;
 }
@@ -4294,13 +5365,13 @@ DEFINE_BUILTIN_OP_IMPORTER(FallbackPluginImporter)
     const std::string pluginNamespace{attrs.get<std::string>("plugin_namespace", "")};
 
     LOG_INFO("Searching for plugin: " << pluginName << ", plugin_version: " << pluginVersion << ", plugin_namespace: " << pluginNamespace);
-    nvinfer1::IPluginCreator* creator = importPluginCreator(pluginName, pluginVersion, pluginNamespace);
+    nvinfer1::IPluginCreator* creator = importPluginCreator(ctx, pluginName, pluginVersion, pluginNamespace);
     ASSERT(creator && "Plugin not found, are the plugin name, version, and namespace correct?", ErrorCode::kUNSUPPORTED_NODE);
 
     const nvinfer1::PluginFieldCollection* fieldNames = creator->getFieldNames();
-    // Field data needs to be type erased, we use fieldData for temporary allocations.
-    string_map<std::vector<uint8_t>> fieldData{};
-    std::vector<nvinfer1::PluginField> fields = loadFields(fieldData, attrs, fieldNames);
+    // Field data needs to be type erased, it is copied into an arena that lives until the plugin is created.
+    PluginFieldArena arena{pluginFieldBytes(attrs, fieldNames)};
+    std::vector<nvinfer1::PluginField> fields = loadFields(arena, attrs, fieldNames);
 
     nvinfer1::IPluginV2* plugin = createPlugin(node.name(), creator, fields);
     ASSERT(plugin && "Could not create plugin", ErrorCode::kUNSUPPORTED_NODE);
@@ -27,6 +27,9 @@
 #include <iostream>
 #include <ctime>
 #include <fcntl.h> // For ::open
+#include <sys/mman.h> // For ::mmap
+#include <sys/stat.h> // For ::fstat
+#include <unistd.h> // For ::close
 #include <limits>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
@@ -91,6 +94,54 @@ namespace common
     return msg->ParseFromCodedStream(&coded_input);
   }
 
+  // Read-only memory mapping of a whole file, unmapped on destruction.
+  class MappedFile {
+    void* _data = nullptr;
+    size_t _size = 0;
+  public:
+    explicit MappedFile(const char* filename) {
+      int fd = ::open(filename, O_RDONLY);
+      if( fd < 0 ) {
+        return;
+      }
+      struct stat st;
+      if( ::fstat(fd, &st) == 0 && st.st_size > 0 ) {
+        void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if( addr != MAP_FAILED ) {
+          _data = addr;
+          _size = st.st_size;
+        }
+      }
+      ::close(fd);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+      if( _data ) {
+        ::munmap(_data, _size);
+      }
+    }
+    explicit operator bool() const { return _data != nullptr; }
+    const void* data() const { return _data; }
+    size_t size() const { return _size; }
+  };
+
+  inline bool ParseFromBuffer(google::protobuf::Message* msg,
+                              const void* data, size_t size) {
+    google::protobuf::io::ArrayInputStream raw_input(data, size);
+    google::protobuf::io::CodedInputStream coded_input(&raw_input);
+    // Note: This WARs the very low default size limit (64MB)
+    coded_input.SetTotalBytesLimit(std::numeric_limits<int>::max(),
+                                   std::numeric_limits<int>::max()/4);
+    return msg->ParseFromCodedStream(&coded_input);
+  }
+
+  inline bool ParseFromTextBuffer(google::protobuf::Message* msg,
+                                  const void* data, size_t size) {
+    google::protobuf::io::ArrayInputStream raw_input(data, size);
+    return google::protobuf::TextFormat::Parse(&raw_input, msg);
+  }
+
   inline bool MessageToFile(const google::protobuf::Message* msg,
                          const char*                filename) {
     int fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
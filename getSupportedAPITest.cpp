@@ -26,6 +26,7 @@
 #include <string>
 #include "NvOnnxParser.h"
 #include "NvInferPlugin.h"
+#include "ModelImporter.hpp"
 #include "onnx_utils.hpp"
 #include "common.hpp"
 
@@ -40,7 +41,7 @@ void print_usage() {
   cout << "Optional argument: -e TRT_engine" << endl;
 }
 
-void printSubGraphs(SubGraphCollection_t& subGraphs, ::ONNX_NAMESPACE::ModelProto onnx_model)
+void printSubGraphs(SubGraphCollection_t& subGraphs, ::ONNX_NAMESPACE::ModelProto const& onnx_model)
 {
     if (subGraphs.size() != 1)
     {
@@ -107,34 +108,33 @@ int main(int argc, char* argv[]) {
     auto trt_builder = common::infer_object(nvinfer1::createInferBuilder(trt_logger));
 
     auto trt_network = common::infer_object(trt_builder->createNetworkV2(1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH)));
-    auto trt_parser  = common::infer_object(nvonnxparser::createParser(*trt_network, trt_logger));
+    // Use the importer directly so that it can take the already deserialized model.
+    auto trt_parser  = common::infer_object(new onnx2trt::ModelImporter(trt_network.get(), &trt_logger));
 
     initLibNvInferPlugins(&trt_logger, "");
 
     cout << "Parsing model: " << onnx_filename << endl;
     
-    std::ifstream onnx_file(onnx_filename.c_str(),
-                            std::ios::binary | std::ios::ate);
-    std::streamsize file_size = onnx_file.tellg();
-    onnx_file.seekg(0, std::ios::beg);
-    std::vector<char> onnx_buf(file_size);
-
-    if( !onnx_file.read(onnx_buf.data(), onnx_buf.size()) ) {
-        cerr << "ERROR: Failed to read from file " << onnx_filename << endl;
-        return -1;
-    }
-
+    // The model is deserialized once and shared by supportsModelProto() and printSubGraphs().
     ::ONNX_NAMESPACE::ModelProto onnx_model;
-    if (!common::ParseFromFile_WAR(&onnx_model, onnx_filename.c_str()))
     {
-        cout << "Failure while parsing ONNX file" << endl;
-        return -1;
+        common::MappedFile onnx_file(onnx_filename.c_str());
+        if (!onnx_file)
+        {
+            cerr << "ERROR: Failed to read from file " << onnx_filename << endl;
+            return -1;
+        }
+        if (!common::ParseFromBuffer(&onnx_model, onnx_file.data(), onnx_file.size()))
+        {
+            cout << "Failure while parsing ONNX file" << endl;
+            return -1;
+        }
     }
 
     SubGraphCollection_t SubGraphCollection;
 
-    // supportsModel() parses the graph and returns a list of supported subgraphs.
-    if (!trt_parser->supportsModel(onnx_buf.data(), onnx_buf.size(), SubGraphCollection))
+    // supportsModelProto() parses the graph and returns a list of supported subgraphs.
+    if (!trt_parser->supportsModelProto(onnx_model, SubGraphCollection, onnx_filename.c_str()))
     {
         cout << "Model cannot be fully parsed by TensorRT!" << endl;
         printSubGraphs(SubGraphCollection, onnx_model);
@@ -144,7 +144,7 @@ int main(int argc, char* argv[]) {
     printSubGraphs(SubGraphCollection, onnx_model);
     
     // If -e was specified, create and save the TensorRT engine to disk.
-    // Note we do not call trt_parser->parse() here since it's already done above in parser->supportsModel()
+    // Note we do not call trt_parser->parse() here since it's already done above in parser->supportsModelProto()
     if( !engine_filename.empty() ) {
         trt_builder->setMaxBatchSize(max_batch_size);
         trt_builder->setMaxWorkspaceSize(max_workspace_size);
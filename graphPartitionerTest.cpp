@@ -0,0 +1,458 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+// Checks the supported-subgraph partitioner on synthetic graphs. Does not need TensorRT or a model.
+
+#include "GraphPartitioner.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace onnx2trt;
+using std::cerr;
+using std::cout;
+using std::endl;
+
+namespace
+{
+
+int failures = 0;
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition << endl;                             \
+            ++failures;                                                                                                \
+        }                                                                                                              \
+    } while (0)
+
+// Builds graphs node by node; each node produces one tensor.
+struct GraphBuilder
+{
+    PartitionGraph graph;
+
+    // Adds a node consuming the outputs of the given nodes (kNO_PRODUCER for a graph input).
+    size_t add(bool supported, std::vector<size_t> const& inputs, int64_t outputBytes = 1024)
+    {
+        const size_t node = graph.supported.size();
+        graph.supported.push_back(supported);
+        for (size_t input : inputs)
+        {
+            if (input == kNO_PRODUCER)
+            {
+                graph.tensors.push_back(tensor(kNO_PRODUCER, {node}, 1024));
+            }
+            else
+            {
+                graph.tensors[tensorOf[input]].consumers.push_back(node);
+            }
+        }
+        tensorOf.push_back(graph.tensors.size());
+        graph.tensors.push_back(tensor(node, {}, outputBytes));
+        return node;
+    }
+
+    std::vector<size_t> order() const
+    {
+        std::vector<size_t> order(graph.supported.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        return order;
+    }
+
+    static PartitionTensor tensor(size_t producer, std::vector<size_t> consumers, int64_t bytes)
+    {
+        PartitionTensor t;
+        t.producer = producer;
+        t.consumers = std::move(consumers);
+        t.bytes = bytes;
+        return t;
+    }
+
+    std::vector<size_t> tensorOf;
+};
+
+std::vector<std::vector<bool>> reachability(PartitionGraph const& graph)
+{
+    const size_t n = graph.supported.size();
+    std::vector<std::vector<size_t>> succ(n);
+    for (auto const& t : graph.tensors)
+    {
+        if (t.producer != kNO_PRODUCER)
+        {
+            for (size_t c : t.consumers)
+            {
+                succ[t.producer].push_back(c);
+            }
+        }
+    }
+    std::vector<std::vector<bool>> reach(n, std::vector<bool>(n, false));
+    // Node indices are a topological order in all graphs built here.
+    for (size_t i = n; i-- > 0;)
+    {
+        for (size_t s : succ[i])
+        {
+            reach[i][s] = true;
+            for (size_t j = 0; j < n; ++j)
+            {
+                if (reach[s][j])
+                {
+                    reach[i][j] = true;
+                }
+            }
+        }
+    }
+    return reach;
+}
+
+// A topological order of graph, chosen at random among the valid ones.
+std::vector<size_t> randomTopologicalOrder(PartitionGraph const& graph, std::mt19937& rng)
+{
+    const size_t n = graph.supported.size();
+    std::vector<int> inDegree(n, 0);
+    for (auto const& t : graph.tensors)
+    {
+        if (t.producer != kNO_PRODUCER)
+        {
+            for (size_t c : t.consumers)
+            {
+                ++inDegree[c];
+            }
+        }
+    }
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (inDegree[i] == 0)
+        {
+            ready.push_back(i);
+        }
+    }
+    std::vector<size_t> order;
+    while (!ready.empty())
+    {
+        std::swap(ready[rng() % ready.size()], ready.back());
+        const size_t node = ready.back();
+        ready.pop_back();
+        order.push_back(node);
+        for (auto const& t : graph.tensors)
+        {
+            if (t.producer != node)
+            {
+                continue;
+            }
+            for (size_t c : t.consumers)
+            {
+                if (--inDegree[c] == 0)
+                {
+                    ready.push_back(c);
+                }
+            }
+        }
+    }
+    return order;
+}
+
+// Every supported node in exactly one partition, no unsupported ones, every partition convex and connected, and
+// partitions listed in an order in which they can be executed.
+void checkValid(PartitionGraph const& graph, Partitioning const& partitioning)
+{
+    const size_t n = graph.supported.size();
+    const auto reach = reachability(graph);
+    std::vector<int> region(n, -1);
+    for (size_t p = 0; p < partitioning.size(); ++p)
+    {
+        for (size_t node : partitioning[p])
+        {
+            CHECK(graph.supported[node]);
+            CHECK(region[node] == -1);
+            region[node] = static_cast<int>(p);
+        }
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        CHECK(graph.supported[i] == (region[i] != -1));
+    }
+    for (size_t a = 0; a < n; ++a)
+    {
+        for (size_t b = 0; b < n; ++b)
+        {
+            if (!reach[a][b] || region[a] == -1 || region[b] == -1)
+            {
+                continue;
+            }
+            // Convexity: every node on a path between two nodes of a partition is in it.
+            for (size_t x = 0; x < n; ++x)
+            {
+                if (region[a] == region[b] && reach[a][x] && reach[x][b])
+                {
+                    CHECK(region[x] == region[a]);
+                }
+            }
+            CHECK(region[a] <= region[b]);
+        }
+    }
+    for (auto const& partition : partitioning)
+    {
+        // Connectivity, ignoring edge directions.
+        std::vector<size_t> stack{partition.front()};
+        std::vector<bool> seen(n, false);
+        seen[partition.front()] = true;
+        size_t nbSeen = 1;
+        while (!stack.empty())
+        {
+            const size_t x = stack.back();
+            stack.pop_back();
+            for (size_t y : partition)
+            {
+                if (!seen[y] && (reach[x][y] || reach[y][x]))
+                {
+                    bool direct = false;
+                    for (auto const& t : graph.tensors)
+                    {
+                        const bool xy = t.producer == x && std::count(t.consumers.begin(), t.consumers.end(), y);
+                        const bool yx = t.producer == y && std::count(t.consumers.begin(), t.consumers.end(), x);
+                        direct = direct || xy || yx;
+                    }
+                    if (direct)
+                    {
+                        seen[y] = true;
+                        ++nbSeen;
+                        stack.push_back(y);
+                    }
+                }
+            }
+        }
+        CHECK(nbSeen == partition.size());
+    }
+}
+
+void testInterleavedBranches()
+{
+    // Two independent branches interleaved in topological order, one of them fed by an unsupported node.
+    GraphBuilder b;
+    const size_t s0 = b.add(true, {kNO_PRODUCER});
+    const size_t u1 = b.add(false, {kNO_PRODUCER});
+    const size_t s2 = b.add(true, {s0});
+    const size_t s3 = b.add(true, {u1});
+    const size_t s4 = b.add(true, {s2});
+    const auto partitioning = partitionGraph(b.graph, b.order());
+    checkValid(b.graph, partitioning);
+    CHECK(partitioning.size() == 2);
+    CHECK((partitioning[0] == std::vector<size_t>{s0, s2, s4}));
+    CHECK((partitioning[1] == std::vector<size_t>{s3}));
+}
+
+void testConvexity()
+{
+    // s0 feeds s2 directly and through an unsupported node, so they cannot run as one unit.
+    GraphBuilder b;
+    const size_t s0 = b.add(true, {kNO_PRODUCER});
+    const size_t u1 = b.add(false, {s0});
+    const size_t s2 = b.add(true, {s0, u1});
+    const auto partitioning = partitionGraph(b.graph, b.order());
+    checkValid(b.graph, partitioning);
+    CHECK(partitioning.size() == 2);
+    CHECK((partitioning[0] == std::vector<size_t>{s0}));
+    CHECK((partitioning[1] == std::vector<size_t>{s2}));
+}
+
+void testSubgraphReadsUnsupportedRegion()
+{
+    // The Loop node l2 takes s0 as an explicit input, and its body reads the output of the unsupported u1 from the
+    // enclosing graph. That implicit read is an edge like any other, so s0 and l2 cannot be grouped.
+    GraphBuilder b;
+    const size_t s0 = b.add(true, {kNO_PRODUCER});
+    const size_t u1 = b.add(false, {s0});
+    const size_t l2 = b.add(true, {s0, u1});
+    const size_t s3 = b.add(true, {l2});
+    const auto partitioning = partitionGraph(b.graph, b.order());
+    checkValid(b.graph, partitioning);
+    CHECK(partitioning.size() == 2);
+    CHECK((partitioning[0] == std::vector<size_t>{s0}));
+    CHECK((partitioning[1] == std::vector<size_t>{l2, s3}));
+}
+
+void testFullySupportedDiamond()
+{
+    GraphBuilder b;
+    const size_t s0 = b.add(true, {kNO_PRODUCER});
+    const size_t s1 = b.add(true, {s0});
+    const size_t s2 = b.add(true, {s0});
+    b.add(true, {s1, s2});
+    const auto partitioning = partitionGraph(b.graph, b.order());
+    checkValid(b.graph, partitioning);
+    CHECK(partitioning.size() == 1);
+}
+
+void testPrefersLargeEdgesInside()
+{
+    // s0, s1 and s2 cannot all be grouped because of the path s0 -> u2 -> s3. Keeping s0 with s1 would leave the large
+    // s1 -> s3 tensor on a boundary, so s1 must be grouped with s3 instead.
+    GraphBuilder b;
+    const size_t s0 = b.add(true, {kNO_PRODUCER}, 16);
+    const size_t s1 = b.add(true, {s0}, 1 << 24);
+    const size_t u2 = b.add(false, {s0}, 16);
+    const size_t s3 = b.add(true, {s1, u2}, 16);
+    const auto partitioning = partitionGraph(b.graph, b.order());
+    checkValid(b.graph, partitioning);
+    CHECK(partitioning.size() == 2);
+    CHECK((partitioning[0] == std::vector<size_t>{s0}));
+    CHECK((partitioning[1] == std::vector<size_t>{s1, s3}));
+    const PartitionCost cost = evaluatePartitioning(b.graph, partitioning);
+    CHECK(cost.nbPartitions == 2);
+    CHECK(cost.transferBytes == 16 + 16 + 16);
+}
+
+void testEvaluatePartitioning()
+{
+    // A tensor consumed by two nodes of the same other partition is transferred once.
+    GraphBuilder b;
+    const size_t s0 = b.add(true, {kNO_PRODUCER}, 100);
+    const size_t u1 = b.add(false, {s0}, 10);
+    const size_t s2 = b.add(true, {u1}, 1);
+    const size_t s3 = b.add(true, {u1, s2}, 1);
+    const PartitionCost cost = evaluatePartitioning(b.graph, {{s0}, {s2, s3}});
+    CHECK(cost.nbPartitions == 2);
+    CHECK(cost.transferBytes == 100 + 10);
+}
+
+void testRandomGraphs()
+{
+    std::mt19937 rng(1234);
+    for (int iteration = 0; iteration < 200; ++iteration)
+    {
+        GraphBuilder b;
+        const int nbNodes = 2 + rng() % 40;
+        for (int i = 0; i < nbNodes; ++i)
+        {
+            std::vector<size_t> inputs;
+            const int nbInputs = i == 0 ? 0 : 1 + rng() % 3;
+            for (int j = 0; j < nbInputs; ++j)
+            {
+                inputs.push_back(rng() % i);
+            }
+            std::sort(inputs.begin(), inputs.end());
+            inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+            if (inputs.empty())
+            {
+                inputs.push_back(kNO_PRODUCER);
+            }
+            b.add(rng() % 4 != 0, inputs, 1 + rng() % 4096);
+        }
+        // The order only bounds the searches for paths between clusters, so any valid one must give valid results.
+        const auto order = iteration % 2 ? randomTopologicalOrder(b.graph, rng) : b.order();
+        const auto partitioning = partitionGraph(b.graph, order);
+        checkValid(b.graph, partitioning);
+
+        // Maximality: two partitions connected by an edge cannot be merged, because some other partition or
+        // unsupported node lies on a path between them.
+        std::vector<size_t> unit(nbNodes);
+        for (size_t p = 0; p < partitioning.size(); ++p)
+        {
+            for (size_t node : partitioning[p])
+            {
+                unit[node] = p;
+            }
+        }
+        for (int i = 0; i < nbNodes; ++i)
+        {
+            if (!b.graph.supported[i])
+            {
+                unit[i] = partitioning.size() + i;
+            }
+        }
+        const size_t nbUnits = partitioning.size() + nbNodes;
+        std::vector<std::vector<size_t>> unitSucc(nbUnits);
+        for (auto const& t : b.graph.tensors)
+        {
+            for (size_t c : t.consumers)
+            {
+                if (t.producer != kNO_PRODUCER && unit[t.producer] != unit[c])
+                {
+                    unitSucc[unit[t.producer]].push_back(unit[c]);
+                }
+            }
+        }
+        for (size_t p = 0; p < partitioning.size(); ++p)
+        {
+            for (size_t c : unitSucc[p])
+            {
+                if (c >= partitioning.size())
+                {
+                    continue;
+                }
+                std::vector<bool> seen(nbUnits, false);
+                std::vector<size_t> stack;
+                for (size_t s : unitSucc[p])
+                {
+                    if (s != c && !seen[s])
+                    {
+                        seen[s] = true;
+                        stack.push_back(s);
+                    }
+                }
+                while (!stack.empty() && !seen[c])
+                {
+                    const size_t x = stack.back();
+                    stack.pop_back();
+                    for (size_t s : unitSucc[x])
+                    {
+                        if (!seen[s])
+                        {
+                            seen[s] = true;
+                            stack.push_back(s);
+                        }
+                    }
+                }
+                CHECK(seen[c]);
+            }
+        }
+    }
+}
+
+} // anonymous namespace
+
+int main()
+{
+    testInterleavedBranches();
+    testConvexity();
+    testSubgraphReadsUnsupportedRegion();
+    testFullySupportedDiamond();
+    testPrefersLargeEdgesInside();
+    testEvaluatePartitioning();
+    testRandomGraphs();
+    if (failures)
+    {
+        cout << failures << " checks FAILED" << endl;
+        return 1;
+    }
+    cout << "All partitioner tests passed" << endl;
+    return 0;
+}
@@ -0,0 +1,621 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+// Checks the Loop and Scan importers on small models built in place. Parses them with TensorRT and runs them, so it
+// needs a GPU.
+
+#include "ModelImporter.hpp"
+#include "common.hpp"
+
+#include <NvInfer.h>
+#include <cuda_runtime_api.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+using ::ONNX_NAMESPACE::AttributeProto;
+using ::ONNX_NAMESPACE::GraphProto;
+using ::ONNX_NAMESPACE::ModelProto;
+using ::ONNX_NAMESPACE::NodeProto;
+using ::ONNX_NAMESPACE::TensorProto;
+using ::ONNX_NAMESPACE::ValueInfoProto;
+
+namespace
+{
+
+int failures = 0;
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition << endl;                             \
+            ++failures;                                                                                                \
+        }                                                                                                              \
+    } while (0)
+
+common::TRT_Logger gLogger;
+
+// Model building. A negative dimension is left without a value.
+
+void setType(ValueInfoProto* info, std::string const& name, int type, std::vector<int64_t> const& dims)
+{
+    info->set_name(name);
+    auto* tensorType = info->mutable_type()->mutable_tensor_type();
+    tensorType->set_elem_type(type);
+    auto* shape = tensorType->mutable_shape();
+    for (int64_t d : dims)
+    {
+        auto* dim = shape->add_dim();
+        if (d >= 0)
+        {
+            dim->set_dim_value(d);
+        }
+    }
+}
+
+void addInput(GraphProto* graph, std::string const& name, int type, std::vector<int64_t> const& dims)
+{
+    setType(graph->add_input(), name, type, dims);
+}
+
+void addOutput(GraphProto* graph, std::string const& name, int type, std::vector<int64_t> const& dims)
+{
+    setType(graph->add_output(), name, type, dims);
+}
+
+NodeProto* addNode(GraphProto* graph, std::string const& op, std::vector<std::string> const& inputs,
+    std::vector<std::string> const& outputs)
+{
+    NodeProto* node = graph->add_node();
+    node->set_op_type(op);
+    for (auto const& input : inputs)
+    {
+        node->add_input(input);
+    }
+    for (auto const& output : outputs)
+    {
+        node->add_output(output);
+    }
+    return node;
+}
+
+void addAttribute(NodeProto* node, std::string const& name, GraphProto const& graph)
+{
+    AttributeProto* attr = node->add_attribute();
+    attr->set_name(name);
+    attr->set_type(AttributeProto::GRAPH);
+    *attr->mutable_g() = graph;
+}
+
+void addAttribute(NodeProto* node, std::string const& name, int64_t value)
+{
+    AttributeProto* attr = node->add_attribute();
+    attr->set_name(name);
+    attr->set_type(AttributeProto::INT);
+    attr->set_i(value);
+}
+
+void addAttribute(NodeProto* node, std::string const& name, std::vector<int64_t> const& values)
+{
+    AttributeProto* attr = node->add_attribute();
+    attr->set_name(name);
+    attr->set_type(AttributeProto::INTS);
+    for (int64_t value : values)
+    {
+        attr->add_ints(value);
+    }
+}
+
+void addFloatInitializer(
+    GraphProto* graph, std::string const& name, std::vector<int64_t> const& dims, std::vector<float> const& values)
+{
+    TensorProto* tensor = graph->add_initializer();
+    tensor->set_name(name);
+    tensor->set_data_type(TensorProto::FLOAT);
+    for (int64_t d : dims)
+    {
+        tensor->add_dims(d);
+    }
+    for (float value : values)
+    {
+        tensor->add_float_data(value);
+    }
+}
+
+// Scalar INT64 and BOOL initializers.
+void addScalarInitializer(GraphProto* graph, std::string const& name, int type, int64_t value)
+{
+    TensorProto* tensor = graph->add_initializer();
+    tensor->set_name(name);
+    tensor->set_data_type(type);
+    if (type == TensorProto::INT64)
+    {
+        tensor->add_int64_data(value);
+    }
+    else
+    {
+        tensor->add_int32_data(static_cast<int32_t>(value));
+    }
+}
+
+ModelProto makeModel(GraphProto const& graph)
+{
+    ModelProto model;
+    model.set_ir_version(::ONNX_NAMESPACE::IR_VERSION);
+    model.add_opset_import()->set_version(11);
+    *model.mutable_graph() = graph;
+    return model;
+}
+
+// Parsing and running.
+
+// A parsed network. The parser owns weights that the network refers to, so it is kept until the network is built.
+struct ParsedModel
+{
+    std::shared_ptr<nvinfer1::IBuilder> builder;
+    std::shared_ptr<nvinfer1::INetworkDefinition> network;
+    std::shared_ptr<onnx2trt::ModelImporter> parser;
+    bool ok{false};
+};
+
+// Parses the model with the given Loop/Scan unroll limit and (node name pattern, length) scan output lengths, where
+// a null pattern sets the default length.
+ParsedModel parseModel(ModelProto const& model, int unrollLimit,
+    std::vector<std::pair<const char*, int>> const& scanOutputLengths = {})
+{
+    ParsedModel parsed;
+    parsed.builder = common::infer_object(nvinfer1::createInferBuilder(gLogger));
+    parsed.network = common::infer_object(parsed.builder->createNetworkV2(
+        1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH)));
+    parsed.parser = common::infer_object(new onnx2trt::ModelImporter(parsed.network.get(), &gLogger));
+    parsed.parser->setLoopUnrollLimit(unrollLimit);
+    for (auto const& length : scanOutputLengths)
+    {
+        parsed.parser->setMaxScanOutputLength(length.second, length.first);
+    }
+    parsed.ok = parsed.parser->parseModelProto(model);
+    for (int i = 0; i < parsed.parser->getNbErrors(); ++i)
+    {
+        cerr << "Parser error: " << parsed.parser->getError(i)->desc() << endl;
+    }
+    return parsed;
+}
+
+// Whether the network contains a layer of the given type.
+bool hasLayer(nvinfer1::INetworkDefinition& network, nvinfer1::LayerType type)
+{
+    for (int i = 0; i < network.getNbLayers(); ++i)
+    {
+        if (network.getLayer(i)->getType() == type)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the length given to the first concatenating loop output of the network when it is a constant, or -1.
+int scanOutputLength(nvinfer1::INetworkDefinition& network)
+{
+    for (int i = 0; i < network.getNbLayers(); ++i)
+    {
+        auto* layer = network.getLayer(i);
+        if (layer->getType() != nvinfer1::LayerType::kLOOP_OUTPUT
+            || static_cast<nvinfer1::ILoopOutputLayer*>(layer)->getLoopOutput() != nvinfer1::LoopOutput::kCONCATENATE)
+        {
+            continue;
+        }
+        nvinfer1::ITensor const* length = layer->getInput(1);
+        for (int j = 0; j < network.getNbLayers(); ++j)
+        {
+            auto* producer = network.getLayer(j);
+            if (producer->getType() == nvinfer1::LayerType::kCONSTANT && producer->getOutput(0) == length)
+            {
+                const nvinfer1::Weights weights = static_cast<nvinfer1::IConstantLayer*>(producer)->getWeights();
+                return weights.type == nvinfer1::DataType::kINT32 ? static_cast<const int32_t*>(weights.values)[0]
+                                                                   : -1;
+            }
+        }
+        return -1;
+    }
+    return -1;
+}
+
+using Buffers = std::map<std::string, std::vector<float>>;
+
+// Builds an engine for a network whose inputs and outputs all have static shapes and FLOAT type, and runs it once.
+bool runModel(ParsedModel const& parsed, Buffers const& inputs, Buffers* outputs)
+{
+    if (!parsed.ok)
+    {
+        return false;
+    }
+    auto config = common::infer_object(parsed.builder->createBuilderConfig());
+    config->setMaxWorkspaceSize(1 << 26);
+    auto engine = common::infer_object(parsed.builder->buildEngineWithConfig(*parsed.network, *config));
+    auto context = common::infer_object(engine->createExecutionContext());
+
+    bool ok = true;
+    std::vector<void*> bindings(engine->getNbBindings(), nullptr);
+    std::vector<size_t> counts(bindings.size(), 1);
+    for (int i = 0; ok && i < engine->getNbBindings(); ++i)
+    {
+        const nvinfer1::Dims dims = engine->getBindingDimensions(i);
+        for (int d = 0; d < dims.nbDims; ++d)
+        {
+            counts[i] *= dims.d[d];
+        }
+        ok = engine->getBindingDataType(i) == nvinfer1::DataType::kFLOAT
+            && cudaMalloc(&bindings[i], counts[i] * sizeof(float)) == cudaSuccess;
+        if (ok && engine->bindingIsInput(i))
+        {
+            auto const& values = inputs.at(engine->getBindingName(i));
+            ok = values.size() == counts[i]
+                && cudaMemcpy(bindings[i], values.data(), counts[i] * sizeof(float), cudaMemcpyHostToDevice)
+                    == cudaSuccess;
+        }
+    }
+    ok = ok && context->executeV2(bindings.data());
+    for (int i = 0; ok && i < engine->getNbBindings(); ++i)
+    {
+        if (!engine->bindingIsInput(i))
+        {
+            auto& values = (*outputs)[engine->getBindingName(i)];
+            values.resize(counts[i]);
+            ok = cudaMemcpy(values.data(), bindings[i], counts[i] * sizeof(float), cudaMemcpyDeviceToHost)
+                == cudaSuccess;
+        }
+    }
+    for (void* binding : bindings)
+    {
+        cudaFree(binding);
+    }
+    return ok;
+}
+
+// Scan output lengths of Loops without a trip count.
+
+// Adds the condition of the next iteration to a Loop body, with any initializers in the outer graph, and returns its
+// name.
+using Condition = std::function<std::string(GraphProto* outer, GraphProto* body)>;
+
+// A Loop node named name without a trip count, whose body adds 1 to its state x and scans the result.
+ModelProto makeCountingLoop(std::string const& name, Condition const& makeCondition)
+{
+    GraphProto outer;
+    outer.set_name("counting_loop");
+    addInput(&outer, "x", TensorProto::FLOAT, {1});
+    addScalarInitializer(&outer, "cond_init", TensorProto::BOOL, 1);
+    addFloatInitializer(&outer, "one", {1}, {1.f});
+
+    GraphProto body;
+    body.set_name("body");
+    addInput(&body, "i", TensorProto::INT64, {});
+    addInput(&body, "c", TensorProto::BOOL, {});
+    addInput(&body, "x_in", TensorProto::FLOAT, {1});
+    addNode(&body, "Add", {"x_in", "one"}, {"x_out"});
+    addNode(&body, "Identity", {"x_out"}, {"x_scan"});
+    const std::string cond = makeCondition(&outer, &body);
+    addOutput(&body, cond, TensorProto::BOOL, {-1});
+    addOutput(&body, "x_out", TensorProto::FLOAT, {1});
+    addOutput(&body, "x_scan", TensorProto::FLOAT, {1});
+
+    NodeProto* loop = addNode(&outer, "Loop", {"", "cond_init", "x"}, {"x_final", "xs"});
+    loop->set_name(name);
+    addAttribute(loop, "body", body);
+    addOutput(&outer, "x_final", TensorProto::FLOAT, {1});
+    addOutput(&outer, "xs", TensorProto::FLOAT, {-1, 1});
+    return makeModel(outer);
+}
+
+// The condition op(i + offset, limit), with the offset left out when it is 0.
+Condition compareIteration(std::string const& op, int64_t offset, int64_t limit)
+{
+    return [op, offset, limit](GraphProto* outer, GraphProto* body) {
+        addScalarInitializer(outer, "limit", TensorProto::INT64, limit);
+        std::string counter = "i";
+        if (offset != 0)
+        {
+            addScalarInitializer(outer, "offset", TensorProto::INT64, offset);
+            addNode(body, "Add", {"i", "offset"}, {"i_offset"});
+            counter = "i_offset";
+        }
+        addNode(body, op, {counter, "limit"}, {"cond_out"});
+        return std::string("cond_out");
+    };
+}
+
+// The condition x_in < 100, which does not depend on the iteration number.
+std::string compareState(GraphProto* outer, GraphProto* body)
+{
+    addFloatInitializer(outer, "hundred", {1}, {100.f});
+    addNode(body, "Less", {"x_in", "hundred"}, {"state_cond"});
+    return "state_cond";
+}
+
+// Runs a counting loop from x = 0 and checks that it stops after iterations iterations.
+void checkIterations(ParsedModel const& parsed, int iterations)
+{
+    Buffers outputs;
+    CHECK(runModel(parsed, {{"x", {0.f}}}, &outputs));
+    CHECK(outputs["x_final"] == std::vector<float>{static_cast<float>(iterations)});
+    std::vector<float> expected(iterations);
+    for (int k = 0; k < iterations; ++k)
+    {
+        expected[k] = k + 1;
+    }
+    CHECK(outputs["xs"] == expected);
+}
+
+void testDerivedScanOutputLength()
+{
+    // i < 5 is computed by iterations 0 to 5, and iteration k runs while iteration k - 1 computed true.
+    ParsedModel less = parseModel(makeCountingLoop("loop", compareIteration("Less", 0, 5)), 0);
+    CHECK(less.ok);
+    CHECK(scanOutputLength(*less.network) == 6);
+    checkIterations(less, 6);
+
+    // i + 2 <= 5 holds for iterations 0 to 3, so iterations 0 to 4 run.
+    ParsedModel lessOrEqual = parseModel(makeCountingLoop("loop", compareIteration("LessOrEqual", 2, 5)), 0);
+    CHECK(lessOrEqual.ok);
+    CHECK(scanOutputLength(*lessOrEqual.network) == 5);
+    checkIterations(lessOrEqual, 5);
+
+    // Iteration 0 runs on the initial condition even when the limit is already exceeded.
+    ParsedModel belowOffset = parseModel(makeCountingLoop("loop", compareIteration("Less", 0, -5)), 0);
+    CHECK(belowOffset.ok);
+    CHECK(scanOutputLength(*belowOffset.network) == 1);
+    checkIterations(belowOffset, 1);
+}
+
+void testBoundedScanOutputLength()
+{
+    // Combined with another condition, i < 5 only bounds the number of iterations. x_in < 3 ends the loop after 3.
+    auto condition = [](GraphProto* outer, GraphProto* body) {
+        compareIteration("Less", 0, 5)(outer, body);
+        addFloatInitializer(outer, "three", {1}, {3.f});
+        addNode(body, "Less", {"x_out", "three"}, {"state_cond"});
+        addNode(body, "And", {"cond_out", "state_cond"}, {"both"});
+        return std::string("both");
+    };
+    ParsedModel parsed = parseModel(makeCountingLoop("loop", condition), 0);
+    CHECK(parsed.ok);
+    CHECK(scanOutputLength(*parsed.network) == 6);
+    Buffers outputs;
+    CHECK(runModel(parsed, {{"x", {0.f}}}, &outputs));
+    CHECK(outputs["x_final"] == std::vector<float>{3.f});
+    CHECK(outputs["xs"].size() == 6);
+}
+
+void testConfiguredScanOutputLength()
+{
+    // Without a comparison of the iteration number, the default length is used.
+    ParsedModel byDefault = parseModel(makeCountingLoop("loop", compareState), 0);
+    CHECK(byDefault.ok);
+    CHECK(scanOutputLength(*byDefault.network) == 1024);
+
+    ParsedModel newDefault = parseModel(makeCountingLoop("loop", compareState), 0, {{nullptr, 50}});
+    CHECK(newDefault.ok);
+    CHECK(scanOutputLength(*newDefault.network) == 50);
+
+    // A matching pattern takes precedence over the derived length, and the first matching pattern wins.
+    const std::vector<std::pair<const char*, int>> patterns{{"other_*", 3}, {"loop_?", 7}, {"loop*", 9}};
+    ParsedModel matching = parseModel(makeCountingLoop("loop_a", compareIteration("Less", 0, 5)), 0, patterns);
+    CHECK(matching.ok);
+    CHECK(scanOutputLength(*matching.network) == 7);
+
+    ParsedModel notMatching = parseModel(makeCountingLoop("decoder", compareIteration("Less", 0, 5)), 0, patterns);
+    CHECK(notMatching.ok);
+    CHECK(scanOutputLength(*notMatching.network) == 6);
+}
+
+// Unrolled Loop and Scan nodes.
+
+bool near(std::vector<float> const& actual, std::vector<float> const& expected)
+{
+    if (actual.size() != expected.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < actual.size(); ++i)
+    {
+        if (std::abs(actual[i] - expected[i]) > 1e-5f * std::max(1.f, std::abs(expected[i])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs the model once unrolled and once as an ILoop, and checks both against the expected outputs.
+void checkUnrolled(ModelProto const& model, Buffers const& inputs, Buffers const& expected)
+{
+    for (int unrollLimit : {8, 0})
+    {
+        ParsedModel parsed = parseModel(model, unrollLimit);
+        CHECK(parsed.ok);
+        if (!parsed.ok)
+        {
+            continue;
+        }
+        CHECK(hasLayer(*parsed.network, nvinfer1::LayerType::kLOOP_OUTPUT) == (unrollLimit == 0));
+        Buffers outputs;
+        CHECK(runModel(parsed, inputs, &outputs));
+        for (auto const& output : expected)
+        {
+            if (!near(outputs[output.first], output.second))
+            {
+                cerr << "Output " << output.first << " differs with unroll limit " << unrollLimit << endl;
+                ++failures;
+            }
+        }
+    }
+}
+
+void testUnrolledLoop()
+{
+    // Three iterations of y = x + i, x = 2 * x.
+    GraphProto outer;
+    outer.set_name("unrolled_loop");
+    addInput(&outer, "x", TensorProto::FLOAT, {2});
+    addScalarInitializer(&outer, "trip_count", TensorProto::INT64, 3);
+    addScalarInitializer(&outer, "cond_init", TensorProto::BOOL, 1);
+    addFloatInitializer(&outer, "two", {1}, {2.f});
+
+    GraphProto body;
+    body.set_name("body");
+    addInput(&body, "i", TensorProto::INT64, {});
+    addInput(&body, "c", TensorProto::BOOL, {});
+    addInput(&body, "x_in", TensorProto::FLOAT, {2});
+    addNode(&body, "Mul", {"x_in", "two"}, {"x_out"});
+    addAttribute(addNode(&body, "Cast", {"i"}, {"i_float"}), "to", int64_t{TensorProto::FLOAT});
+    addNode(&body, "Add", {"x_in", "i_float"}, {"y"});
+    addOutput(&body, "c", TensorProto::BOOL, {});
+    addOutput(&body, "x_out", TensorProto::FLOAT, {2});
+    addOutput(&body, "y", TensorProto::FLOAT, {2});
+
+    addAttribute(addNode(&outer, "Loop", {"trip_count", "cond_init", "x"}, {"x_final", "ys"}), "body", body);
+    addOutput(&outer, "x_final", TensorProto::FLOAT, {2});
+    addOutput(&outer, "ys", TensorProto::FLOAT, {3, 2});
+
+    std::vector<float> x{1.f, 2.f};
+    std::vector<float> ys;
+    for (int i = 0; i < 3; ++i)
+    {
+        for (float& value : x)
+        {
+            ys.push_back(value + i);
+            value *= 2;
+        }
+    }
+    checkUnrolled(makeModel(outer), {{"x", {1.f, 2.f}}}, {{"x_final", x}, {"ys", ys}});
+}
+
+void testUnrolledScan()
+{
+    // Scans the columns of X [2, 3] from last to first, accumulating them in s, and writes 2 * s back from last to
+    // first column.
+    GraphProto outer;
+    outer.set_name("unrolled_scan");
+    addInput(&outer, "s", TensorProto::FLOAT, {2});
+    addInput(&outer, "X", TensorProto::FLOAT, {2, 3});
+    addFloatInitializer(&outer, "two", {1}, {2.f});
+
+    GraphProto body;
+    body.set_name("body");
+    addInput(&body, "s_in", TensorProto::FLOAT, {2});
+    addInput(&body, "x_t", TensorProto::FLOAT, {2});
+    addNode(&body, "Add", {"s_in", "x_t"}, {"s_out"});
+    addNode(&body, "Mul", {"s_out", "two"}, {"y_t"});
+    addOutput(&body, "s_out", TensorProto::FLOAT, {2});
+    addOutput(&body, "y_t", TensorProto::FLOAT, {2});
+
+    NodeProto* scan = addNode(&outer, "Scan", {"s", "X"}, {"s_final", "Y"});
+    addAttribute(scan, "body", body);
+    addAttribute(scan, "num_scan_inputs", int64_t{1});
+    addAttribute(scan, "scan_input_axes", std::vector<int64_t>{1});
+    addAttribute(scan, "scan_input_directions", std::vector<int64_t>{1});
+    addAttribute(scan, "scan_output_axes", std::vector<int64_t>{1});
+    addAttribute(scan, "scan_output_directions", std::vector<int64_t>{1});
+    addOutput(&outer, "s_final", TensorProto::FLOAT, {2});
+    addOutput(&outer, "Y", TensorProto::FLOAT, {2, 3});
+
+    const std::vector<float> X{1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
+    std::vector<float> s{0.f, 0.f};
+    std::vector<float> Y(6);
+    for (int k = 0; k < 3; ++k)
+    {
+        // Iteration k reads column 2 - k, and its output is prepended, so it also lands in column 2 - k.
+        const int column = 2 - k;
+        for (int row = 0; row < 2; ++row)
+        {
+            s[row] += X[row * 3 + column];
+            Y[row * 3 + column] = 2 * s[row];
+        }
+    }
+    checkUnrolled(makeModel(outer), {{"s", {0.f, 0.f}}, {"X", X}}, {{"s_final", s}, {"Y", Y}});
+}
+
+void testUnrolledPassThrough()
+{
+    // The body returns its state a unchanged, as the body input itself, and accumulates it in b.
+    GraphProto outer;
+    outer.set_name("unrolled_pass_through");
+    addInput(&outer, "a", TensorProto::FLOAT, {2});
+    addInput(&outer, "b", TensorProto::FLOAT, {2});
+    addScalarInitializer(&outer, "trip_count", TensorProto::INT64, 2);
+    addScalarInitializer(&outer, "cond_init", TensorProto::BOOL, 1);
+
+    GraphProto body;
+    body.set_name("body");
+    addInput(&body, "i", TensorProto::INT64, {});
+    addInput(&body, "c", TensorProto::BOOL, {});
+    addInput(&body, "a_in", TensorProto::FLOAT, {2});
+    addInput(&body, "b_in", TensorProto::FLOAT, {2});
+    addNode(&body, "Add", {"b_in", "a_in"}, {"b_out"});
+    addOutput(&body, "c", TensorProto::BOOL, {});
+    addOutput(&body, "a_in", TensorProto::FLOAT, {2});
+    addOutput(&body, "b_out", TensorProto::FLOAT, {2});
+
+    NodeProto* loop = addNode(&outer, "Loop", {"trip_count", "cond_init", "a", "b"}, {"a_final", "b_final"});
+    addAttribute(loop, "body", body);
+    addOutput(&outer, "a_final", TensorProto::FLOAT, {2});
+    addOutput(&outer, "b_final", TensorProto::FLOAT, {2});
+
+    checkUnrolled(makeModel(outer), {{"a", {1.f, 2.f}}, {"b", {10.f, 20.f}}},
+        {{"a_final", {1.f, 2.f}}, {"b_final", {12.f, 24.f}}});
+}
+
+} // anonymous namespace
+
+int main()
+{
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    testDerivedScanOutputLength();
+    testBoundedScanOutputLength();
+    testConfiguredScanOutputLength();
+    testUnrolledLoop();
+    testUnrolledScan();
+    testUnrolledPassThrough();
+    if (failures)
+    {
+        cout << failures << " checks FAILED" << endl;
+        return 1;
+    }
+    cout << "All Loop and Scan importer tests passed" << endl;
+    return 0;
+}
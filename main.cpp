@@ -21,8 +21,12 @@
  */
 
 #include "NvOnnxParser.h"
+#include "ModelImporter.hpp"
 #include "onnx_utils.hpp"
 #include "common.hpp"
+#include "AsyncLogger.hpp"
+#include "BatchConverter.hpp"
+#include "NetworkAnalysis.hpp"
 #include <onnx/optimizer/optimize.h>
 
 #include <google/protobuf/io/coded_stream.h>
@@ -38,6 +42,9 @@ using std::endl;
 #include <ctime>
 #include <fcntl.h> // For ::open
 #include <limits>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 void print_usage() {
   cout << "ONNX to TensorRT model parser" << endl;
@@ -50,14 +57,44 @@ void print_usage() {
        << "                [-w max_workspace_size_bytes (default 1 GiB)]" << "\n"
        << "                [-d model_data_type_bit_depth] (32 => float32, 16 => float16)" << "\n"
        << "                [-O passes] (optimize onnx model. Argument is a semicolon-separated list of passes)" << "\n"
+       << "                [-U max_trip_count] (unroll Loop/Scan nodes with a constant trip count up to max_trip_count)" << "\n"
+       << "                [-L [node_name_pattern=]length] (scan output length of Loop nodes without trip count, repeatable)" << "\n"
        << "                [-p] (list available optimization passes and exit)" << "\n"
-       << "                [-l] (list layers and their shapes)" << "\n"
+       << "                [-l] (list layers with their shapes and estimated cost)" << "\n"
+       << "                [-S input_name:d0xd1x...] (opt shape of a dynamic input for -l and -a, repeatable)" << "\n"
+       << "                [-a] (estimate peak activation memory from tensor lifetimes)" << "\n"
        << "                [-g] (debug mode)" << "\n"
        << "                [-F] (optimize onnx model in fixed mode)" << "\n"
        << "                [-v] (increase verbosity)" << "\n"
+       << "                [-j] (write log messages as JSON lines)" << "\n"
        << "                [-q] (decrease verbosity)" << "\n"
        << "                [-V] (show version information)" << "\n"
-       << "                [-h] (show help)" << endl;
+       << "                [-h] (show help)" << "\n"
+       << "       onnx2trt -B manifest.txt" << "\n"
+       << "                [-P parse_workers (default: number of CPUs)]" << "\n"
+       << "                [-C build_concurrency (default 1)]" << "\n"
+       << "                [-s summary.json (default: stdout)]" << "\n"
+       << "                (convert every '<model> <engine> [workspace=N] [fp16=0|1] [max_batch=N]' line of the manifest)" << endl;
+}
+
+// Parses "name:d0xd1x..." into an input name and its dimensions. The name may itself contain ':'.
+bool parse_shape(std::string const& arg, std::string* name, nvinfer1::Dims* dims) {
+  size_t sep = arg.rfind(':');
+  if( sep == std::string::npos || sep == 0 ) {
+    return false;
+  }
+  *name = arg.substr(0, sep);
+  dims->nbDims = 0;
+  std::stringstream dim_stream(arg.substr(sep + 1));
+  std::string dim;
+  while( std::getline(dim_stream, dim, 'x') ) {
+    if( dims->nbDims == nvinfer1::Dims::MAX_DIMS || dim.empty() ||
+        dim.find_first_not_of("0123456789") != std::string::npos ) {
+      return false;
+    }
+    dims->d[dims->nbDims++] = atoi(dim.c_str());
+  }
+  return true;
 }
 
 int main(int argc, char* argv[]) {
@@ -76,10 +113,19 @@ int main(int argc, char* argv[]) {
   bool optimize_model_fixed = false;
   bool print_optimization_passes_info = false;
   bool print_layer_info = false;
+  bool print_activation_memory = false;
+  int loop_unroll_limit = 0;
+  std::vector<std::pair<std::string, int>> scan_output_lengths; // Empty pattern sets the default
+  std::vector<std::pair<std::string, nvinfer1::Dims>> opt_shapes;
   bool debug_builder = false;
+  bool json_log = false;
+  std::string manifest_filename;
+  std::string summary_filename;
+  batch::Options batch_options;
+  batch_options.parse_workers = std::max(1u, std::thread::hardware_concurrency());
 
   int arg = 0;
-  while( (arg = ::getopt(argc, argv, "o:b:w:t:T:m:d:O:plgFvqVh")) != -1 ) {
+  while( (arg = ::getopt(argc, argv, "o:b:w:t:T:m:d:O:U:L:S:B:P:C:s:plagFvjqVh")) != -1 ) {
     switch (arg){
     case 'o':
       if( optarg ) { engine_filename = optarg; break; }
@@ -106,11 +152,48 @@ int main(int argc, char* argv[]) {
       optimize_model = true;
       if( optarg ) { optimization_passes_string = optarg; break; }
       else { cerr << "ERROR: -O flag requires argument" << endl; return -1; }
+    case 'U':
+      if( optarg ) { loop_unroll_limit = atoi(optarg); break; }
+      else { cerr << "ERROR: -U flag requires argument" << endl; return -1; }
+    case 'L':
+      if( optarg ) {
+        std::string arg = optarg;
+        size_t sep = arg.rfind('=');
+        std::string pattern = sep == std::string::npos ? "" : arg.substr(0, sep);
+        scan_output_lengths.emplace_back(pattern, atoi(arg.c_str() + (sep == std::string::npos ? 0 : sep + 1)));
+        break;
+      }
+      else { cerr << "ERROR: -L flag requires argument" << endl; return -1; }
+    case 'S':
+      if( optarg ) {
+        std::pair<std::string, nvinfer1::Dims> shape;
+        if( !parse_shape(optarg, &shape.first, &shape.second) ) {
+          cerr << "ERROR: Invalid -S argument '" << optarg << "', expected input_name:d0xd1x..." << endl;
+          return -1;
+        }
+        opt_shapes.push_back(shape);
+        break;
+      }
+      else { cerr << "ERROR: -S flag requires argument" << endl; return -1; }
+    case 'B':
+      if( optarg ) { manifest_filename = optarg; break; }
+      else { cerr << "ERROR: -B flag requires argument" << endl; return -1; }
+    case 'P':
+      if( optarg ) { batch_options.parse_workers = atoi(optarg); break; }
+      else { cerr << "ERROR: -P flag requires argument" << endl; return -1; }
+    case 'C':
+      if( optarg ) { batch_options.build_concurrency = atoi(optarg); break; }
+      else { cerr << "ERROR: -C flag requires argument" << endl; return -1; }
+    case 's':
+      if( optarg ) { summary_filename = optarg; break; }
+      else { cerr << "ERROR: -s flag requires argument" << endl; return -1; }
     case 'p': print_optimization_passes_info = true; break;
     case 'l': print_layer_info = true; break;
+    case 'a': print_activation_memory = true; break;
     case 'g': debug_builder = true; break;
     case 'F': optimize_model_fixed = true; optimize_model = true; break;
     case 'v': ++verbosity; break;
+    case 'j': json_log = true; break;
     case 'q': --verbosity; break;
     case 'V': common::print_version(); return 0;
     case 'h': print_usage(); return 0;
@@ -132,6 +215,30 @@ int main(int argc, char* argv[]) {
     return 0;
   }
 
+  if( !manifest_filename.empty() ) {
+    std::vector<batch::Job> jobs;
+    if( !batch::read_manifest(manifest_filename, &jobs) ) {
+      return -3;
+    }
+    common::AsyncLogger trt_logger((nvinfer1::ILogger::Severity)verbosity, std::cerr,
+                                   json_log ? common::AsyncLogger::Format::kJSON_LINES
+                                            : common::AsyncLogger::Format::kTEXT);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<batch::Result> results = batch::run(jobs, batch_options, trt_logger);
+    double total_ms = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+    trt_logger.flush();
+    if( summary_filename.empty() ) {
+      batch::write_summary(cout, jobs, results, total_ms);
+    } else {
+      std::ofstream summary_file(summary_filename.c_str());
+      batch::write_summary(summary_file, jobs, results, total_ms);
+    }
+    bool all_built = std::all_of(results.begin(), results.end(),
+                                 [](const batch::Result& r) { return r.built; });
+    return all_built ? 0 : -5;
+  }
+
   int num_args = argc - optind;
   if( num_args != 1 ) {
     print_usage();
@@ -148,17 +255,23 @@ int main(int argc, char* argv[]) {
     return -2;
   }
 
-  if (!std::ifstream(onnx_filename.c_str())) {
-    cerr << "Input file not found: " << onnx_filename << endl;
-    return -3;
-  }
-
-  ::ONNX_NAMESPACE::ModelProto _the_onnx_model;
-  ::ONNX_NAMESPACE::ModelProto& onnx_model = _the_onnx_model;
-  bool is_binary = common::ParseFromFile_WAR(&onnx_model, onnx_filename.c_str());
-  if( !is_binary && !common::ParseFromTextFile(&onnx_model, onnx_filename.c_str()) ) {
-    cerr << "Failed to parse ONNX model" << endl;
-    return -3;
+  // The model is read and deserialized exactly once; the printers, the
+  // optimizer and the parser all work on this in-memory copy.
+  ::ONNX_NAMESPACE::ModelProto onnx_model;
+  {
+    common::MappedFile onnx_file(onnx_filename.c_str());
+    if( !onnx_file ) {
+      cerr << "Input file not found: " << onnx_filename << endl;
+      return -3;
+    }
+    bool is_binary = common::ParseFromBuffer(&onnx_model, onnx_file.data(), onnx_file.size());
+    if( !is_binary ) {
+      onnx_model.Clear();
+      if( !common::ParseFromTextBuffer(&onnx_model, onnx_file.data(), onnx_file.size()) ) {
+        cerr << "Failed to parse ONNX model" << endl;
+        return -3;
+      }
+    }
   }
 
   if( verbosity >= (int)nvinfer1::ILogger::Severity::kWARNING ) {
@@ -183,27 +296,34 @@ int main(int argc, char* argv[]) {
          << common::onnx_ir_version_string(::ONNX_NAMESPACE::IR_VERSION) << ")." << endl;
   }
   
-  if( !model_filename.empty() ) {
-    if( optimize_model ) {
-      std::vector<std::string> passes;
+  // The optimized model replaces the original one, so that it is what gets
+  // written by -m/-t/-T and what the network is built from.
+  if( optimize_model ) {
+    std::vector<std::string> passes;
 
-      std::string curPass;
-      std::stringstream passStream(optimization_passes_string);
-      while( std::getline(passStream, curPass, ';') ) {
-        if( std::find(optimizationPassNames.begin(), optimizationPassNames.end(), curPass) != optimizationPassNames.end() ) {
-          passes.push_back(curPass);
-        }
+    std::string curPass;
+    std::stringstream passStream(optimization_passes_string);
+    while( std::getline(passStream, curPass, ';') ) {
+      if( std::find(optimizationPassNames.begin(), optimizationPassNames.end(), curPass) != optimizationPassNames.end() ) {
+        passes.push_back(curPass);
       }
+      else {
+        cerr << "WARNING: Ignoring unknown optimization pass '" << curPass << "'" << endl;
+      }
+    }
 
-      if( !passes.empty() ) {
-        cout << "Optimizing '" << model_filename << "'" << endl;
-        ::ONNX_NAMESPACE::ModelProto _the_onnx_model_optimized = optimize_model_fixed
-                                                               ? ::ONNX_NAMESPACE::optimization::OptimizeFixed(onnx_model, passes)
-                                                               : ::ONNX_NAMESPACE::optimization::Optimize(onnx_model, passes);
-        onnx_model = _the_onnx_model_optimized;
+    if( !passes.empty() ) {
+      if( verbosity >= (int)nvinfer1::ILogger::Severity::kWARNING ) {
+        cout << "Optimizing '" << onnx_filename << "'" << endl;
       }
+      ::ONNX_NAMESPACE::ModelProto optimized_model = optimize_model_fixed
+                                                   ? ::ONNX_NAMESPACE::optimization::OptimizeFixed(onnx_model, passes)
+                                                   : ::ONNX_NAMESPACE::optimization::Optimize(onnx_model, passes);
+      onnx_model.Swap(&optimized_model);
     }
+  }
 
+  if( !model_filename.empty() ) {
     if( !common::MessageToFile( &onnx_model, model_filename.c_str() ) ) {
       cerr << "ERROR: Problem writing ONNX model" << endl;
     }
@@ -214,47 +334,41 @@ int main(int argc, char* argv[]) {
       cout << "Writing ONNX model (without weights) as text to " << text_filename << endl;
     }
     std::ofstream onnx_text_file(text_filename.c_str());
-    std::string onnx_text = pretty_print_onnx_to_string(onnx_model);
-    onnx_text_file.write(onnx_text.c_str(), onnx_text.size());
+    pretty_print_onnx(onnx_text_file, onnx_model);
   }
   if( !full_text_filename.empty() ) {
     if( verbosity >= (int)nvinfer1::ILogger::Severity::kWARNING ) {
       cout << "Writing ONNX model (with weights) as text to " << full_text_filename << endl;
     }
-    std::string full_onnx_text;
-    google::protobuf::TextFormat::PrintToString(onnx_model, &full_onnx_text);
     std::ofstream full_onnx_text_file(full_text_filename.c_str());
-    full_onnx_text_file.write(full_onnx_text.c_str(), full_onnx_text.size());
+    google::protobuf::io::OstreamOutputStream full_onnx_text_stream(&full_onnx_text_file);
+    google::protobuf::TextFormat::Print(onnx_model, &full_onnx_text_stream);
   }
 
   const auto explicitBatch = 1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
-  common::TRT_Logger trt_logger((nvinfer1::ILogger::Severity)verbosity);
+  common::AsyncLogger trt_logger((nvinfer1::ILogger::Severity)verbosity, std::cout,
+                                 json_log ? common::AsyncLogger::Format::kJSON_LINES
+                                          : common::AsyncLogger::Format::kTEXT);
   auto trt_builder = common::infer_object(nvinfer1::createInferBuilder(trt_logger));
   auto trt_network = common::infer_object(trt_builder->createNetworkV2(explicitBatch));
-  auto trt_parser  = common::infer_object(nvonnxparser::createParser(
-                                      *trt_network, trt_logger));
-
-  // TODO: Fix this for the new API
-  //if( print_layer_info ) {
-  //  parser->setLayerInfoStream(&std::cout);
-  //}
-  (void)print_layer_info;
+  // Use the importer directly so that it can take the already deserialized model.
+  auto trt_parser  = common::infer_object(new onnx2trt::ModelImporter(
+                                      trt_network.get(), &trt_logger));
+  trt_parser->setLoopUnrollLimit(loop_unroll_limit);
+  for( auto const& length : scan_output_lengths ) {
+    trt_parser->setMaxScanOutputLength(length.second,
+                                       length.first.empty() ? nullptr : length.first.c_str());
+  }
 
   if( verbosity >= (int)nvinfer1::ILogger::Severity::kWARNING ) {
     cout << "Parsing model" << endl;
   }
 
   {
-    std::ifstream onnx_file(onnx_filename.c_str(),
-                            std::ios::binary | std::ios::ate);
-    std::streamsize file_size = onnx_file.tellg();
-    onnx_file.seekg(0, std::ios::beg);
-    std::vector<char> onnx_buf(file_size);
-    if( !onnx_file.read(onnx_buf.data(), onnx_buf.size()) ) {
-      cerr << "ERROR: Failed to read from file " << onnx_filename << endl;
-      return -4;
-    }
-    if( !trt_parser->parse(onnx_buf.data(), onnx_buf.size()) ) {
+    bool parsed = trt_parser->parseModelProto(onnx_model, onnx_filename.c_str());
+    // Make sure parser messages appear before anything printed directly below.
+    trt_logger.flush();
+    if( !parsed ) {
       int nerror = trt_parser->getNbErrors();
       for( int i=0; i<nerror; ++i ) {
         nvonnxparser::IParserError const* error = trt_parser->getError(i);
@@ -283,6 +397,30 @@ int main(int argc, char* argv[]) {
     }
   }
 
+  // The profile only carries the -S shapes to the analyses below; dimensions
+  // that do not follow from them are reported as unknown.
+  nvinfer1::IOptimizationProfile* analysis_profile = nullptr;
+  if( !opt_shapes.empty() ) {
+    analysis_profile = trt_builder->createOptimizationProfile();
+    for( auto const& shape : opt_shapes ) {
+      bool set = true;
+      for( auto selector : {nvinfer1::OptProfileSelector::kMIN, nvinfer1::OptProfileSelector::kOPT,
+                            nvinfer1::OptProfileSelector::kMAX} ) {
+        set = set && analysis_profile->setDimensions(shape.first.c_str(), selector, shape.second);
+      }
+      if( !set ) {
+        cerr << "ERROR: Invalid -S shape for input '" << shape.first << "'" << endl;
+        return -1;
+      }
+    }
+  }
+  if( print_layer_info ) {
+    onnx2trt::printNetworkCost(cout, onnx2trt::estimateNetworkCost(*trt_network, analysis_profile));
+  }
+  if( print_activation_memory ) {
+    onnx2trt::printActivationMemoryPlan(cout, onnx2trt::planActivationMemory(*trt_network, analysis_profile));
+  }
+
   bool fp16 = trt_builder->platformHasFastFp16();
 
   if( !engine_filename.empty() ) {
@@ -303,6 +441,7 @@ int main(int argc, char* argv[]) {
     }
     trt_builder->setDebugSync(debug_builder);
     auto trt_engine = common::infer_object(trt_builder->buildCudaEngine(*trt_network.get()));
+    trt_logger.flush();
 
     auto engine_plan = common::infer_object(trt_engine->serialize());
     std::ofstream engine_file(engine_filename.c_str());
@@ -30,6 +30,100 @@
 %{
 #define SWIG_FILE_WITH_INIT
 #include "NvOnnxParser.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only mapping of a model file. The mapping is released on destruction.
+class MappedModelFile
+{
+public:
+    explicit MappedModelFile(const char* path)
+    {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            return;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                mData = addr;
+                mSize = st.st_size;
+            }
+        }
+        ::close(fd);
+    }
+    ~MappedModelFile()
+    {
+        if (mData)
+        {
+            ::munmap(mData, mSize);
+        }
+    }
+    void const* data() const
+    {
+        return mData;
+    }
+    size_t size() const
+    {
+        return mSize;
+    }
+
+private:
+    void* mData{nullptr};
+    size_t mSize{0};
+};
+
+#include <map>
+#include <memory>
+
+// Forwards parser log messages with the GIL held, so that a logger implemented
+// in Python can be called while parse() runs with the GIL released.
+class GilAcquiringLogger : public nvinfer1::ILogger
+{
+public:
+    explicit GilAcquiringLogger(nvinfer1::ILogger* logger)
+        : mLogger(logger)
+    {
+    }
+    void log(Severity severity, const char* msg) noexcept override
+    {
+        PyGILState_STATE state = PyGILState_Ensure();
+        mLogger->log(severity, msg);
+        PyGILState_Release(state);
+    }
+
+private:
+    nvinfer1::ILogger* mLogger;
+};
+
+// The parser keeps a reference to its logger, so each forwarding logger lives
+// until its parser is destroyed. Only accessed with the GIL held.
+static std::map<nvonnxparser::IParser*, std::unique_ptr<GilAcquiringLogger>> gParserLoggers;
+
+static nvonnxparser::IParser* createPythonParser(nvinfer1::INetworkDefinition* network, nvinfer1::ILogger* logger)
+{
+    std::unique_ptr<GilAcquiringLogger> gilLogger(new GilAcquiringLogger(logger));
+    auto* parser = static_cast<nvonnxparser::IParser*>(
+        createNvOnnxParser_INTERNAL(network, gilLogger.get(), NV_ONNX_PARSER_VERSION));
+    if (parser)
+    {
+        gParserLoggers[parser] = std::move(gilLogger);
+    }
+    return parser;
+}
+
+static void destroyPythonParser(nvonnxparser::IParser* parser)
+{
+    parser->destroy();
+    gParserLoggers.erase(parser);
+}
 %}
 
 %feature("director") nvonnxparser::IParser;
@@ -45,20 +139,91 @@
 // support int64_t
 %include "stdint.i"
 
+// Accept any object exporting a contiguous buffer (bytes, bytearray, memoryview,
+// mmap.mmap, numpy arrays, ...) without copying it. The view is only released
+// if it was acquired, since the freearg code also runs on earlier failures.
+%typemap(arginit) (void const* serialized_onnx_model,
+                   size_t      serialized_onnx_model_size) {
+   view$argnum.obj = NULL;
+}
 %typemap(in) (void const* serialized_onnx_model,
-              size_t      serialized_onnx_model_size) {
-   if (!PyString_Check($input)) {
-       PyErr_SetString(PyExc_ValueError, "Expecting a string");
-       return NULL;
+              size_t      serialized_onnx_model_size) (Py_buffer view) {
+   if (PyObject_GetBuffer($input, &view, PyBUF_SIMPLE) != 0) {
+       // Keep the TypeError raised by PyObject_GetBuffer.
+       SWIG_fail;
+   }
+   $1 = view.buf;
+   $2 = view.len;
+}
+%typemap(freearg) (void const* serialized_onnx_model,
+                   size_t      serialized_onnx_model_size) {
+   if (view$argnum.obj) {
+       PyBuffer_Release(&view$argnum);
    }
-   $1 = (void *) PyString_AsString($input);
-   $2 = PyString_Size($input);
+}
+
+// Parsing can take several seconds for large models, so let other Python
+// threads run in the meantime. Parsers are created with a GilAcquiringLogger,
+// which takes the GIL back for any log callback into a Python logger.
+%exception nvonnxparser::IParser::parse {
+    Py_BEGIN_ALLOW_THREADS
+    $action
+    Py_END_ALLOW_THREADS
+}
+%exception nvonnxparser::IParser::supportsModel {
+    Py_BEGIN_ALLOW_THREADS
+    $action
+    Py_END_ALLOW_THREADS
+}
+%exception nvonnxparser::IParser::parseWithWeightDescriptors {
+    Py_BEGIN_ALLOW_THREADS
+    $action
+    Py_END_ALLOW_THREADS
+}
+%exception nvonnxparser::IParser::parseFromFile {
+    Py_BEGIN_ALLOW_THREADS
+    $action
+    Py_END_ALLOW_THREADS
 }
 
 %unrefobject nvonnxparser::IParser {
-  $this->destroy();
+  destroyPythonParser($this);
 }
-%newobject nvonnxparser::createParser;
-%delobject nvonnxparser::IParser::destroy;
+%ignore nvonnxparser::createParser;
+%rename(create_parser) createPythonParser;
+%newobject createPythonParser;
+// An explicit destroy() from Python must also release the parser's logger,
+// so it goes through destroyPythonParser like the unref hook above.
+%ignore nvonnxparser::IParser::destroy;
+%rename(destroy) nvonnxparser::IParser::destroyPythonParser;
+%delobject nvonnxparser::IParser::destroyPythonParser;
 
 %include "NvOnnxParser.h"
+
+nvonnxparser::IParser* createPythonParser(nvinfer1::INetworkDefinition* network, nvinfer1::ILogger* logger);
+
+%extend nvonnxparser::IParser {
+    /** \brief Parse a binary ONNX model file by mapping it into memory.
+     *
+     * The file is handed to parse() directly, without reading it into an
+     * intermediate buffer. External weights are resolved relative to the file.
+     */
+    bool parseFromFile(const char* onnxModelFile)
+    {
+        MappedModelFile file(onnxModelFile);
+        if (!file.data())
+        {
+            return false;
+        }
+        return $self->parse(file.data(), file.size(), onnxModelFile);
+    }
+
+    /** \brief Destroy the parser and the logger it was created with.
+     *
+     * Exposed to Python as destroy().
+     */
+    void destroyPythonParser()
+    {
+        ::destroyPythonParser($self);
+    }
+}
@@ -66,16 +66,33 @@ public:
     virtual StringMap<float>& tensorRangeMins() = 0;
     virtual StringMap<float>& tensorRangeMaxes() = 0;
     virtual StringMap<nvinfer1::DataType>& layerPrecisions() = 0;
-    virtual std::unordered_set<std::string>& unsupportedShapeTensors() = 0;
-    virtual StringMap<std::string>& loopTensors() = 0;
+    // Fixes the types of the shape tensors revealed by the layers added since the last call, and attributes those
+    // layers to the given node of the top-level graph.
+    virtual void updateShapeTensors(int nodeIndex) = 0;
     virtual void setOnnxFileLocation(std::string location) = 0;
     virtual std::string getOnnxFileLocation() = 0;
     virtual void registerTensor(TensorOrWeights tensor, const std::string& basename) = 0;
+    // Binds an ONNX name to a value without renaming it, e.g. to pass an outer value into a subgraph.
+    virtual void bindTensor(TensorOrWeights tensor, const std::string& basename) = 0;
+    // Names registered or bound between pushScope() and popScope() are removed, or restored to the values they
+    // shadowed, by popScope(). Subgraphs are imported in their own scope.
+    virtual void pushScope() = 0;
+    virtual void popScope() = 0;
     virtual void registerLayer(nvinfer1::ILayer* layer, const std::string& basename) = 0;
     virtual ShapedWeights createTempWeights(ShapedWeights::DataType type, nvinfer1::Dims shape) = 0;
     virtual int64_t getOpsetVersion(const char* domain = "") const = 0;
     virtual nvinfer1::ILogger& logger() = 0;
     virtual void insertRefitMap(std::string weightsName, std::string layerName, nvinfer1::WeightsRole role) = 0;
+    // Loops and scans with a constant trip count up to this limit are unrolled. 0 disables unrolling.
+    virtual int getLoopUnrollLimit() const = 0;
+    // Length of the scan outputs of the named Loop node if it has no trip count. *nodeSpecific tells whether the
+    // length was set for this node by name pattern, rather than being the parser-wide default.
+    virtual int getMaxScanOutputLength(const std::string& nodeName, bool* nodeSpecific) const = 0;
+    // Looks up a plugin creator in the plugin registry. Creators that are found are cached for the lifetime of the
+    // parser, so that nodes of the same plugin do not repeat the registry lookup.
+    virtual nvinfer1::IPluginCreator* getPluginCreator(
+        const std::string& pluginName, const std::string& pluginVersion, const std::string& pluginNamespace)
+        = 0;
 
 protected:
     virtual ~IImporterContext()
@@ -83,4 +100,24 @@ protected:
     }
 };
 
+// Imports a subgraph in its own scope for as long as it lives.
+class SubgraphScope
+{
+public:
+    explicit SubgraphScope(IImporterContext* ctx)
+        : mCtx(ctx)
+    {
+        mCtx->pushScope();
+    }
+    ~SubgraphScope()
+    {
+        mCtx->popScope();
+    }
+    SubgraphScope(const SubgraphScope&) = delete;
+    SubgraphScope& operator=(const SubgraphScope&) = delete;
+
+private:
+    IImporterContext* mCtx;
+};
+
 } // namespace onnx2trt
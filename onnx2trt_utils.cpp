@@ -98,15 +98,57 @@ NodeImportResult argMinMaxHelper(IImporterContext* ctx, const ::ONNX_NAMESPACE::
 //! Assert failure if t has rank greater than nbDims.
 Status broadcastTensor(IImporterContext* ctx, nvinfer1::ITensor*& t, const int nbDims)
 {
-    ASSERT(ctx->getOpsetVersion() >= 7 && "Pre-opset 7 broadcasting is unsupported in this version of the ONNX parser", ErrorCode::kUNSUPPORTED_NODE);
-    const auto inputDims = shapeOf(*t);
-    const int nbInputDims = inputDims.size();
+    const int nbInputDims = t->getDimensions().nbDims;
     assert(nbInputDims <= nbDims);
-    if (nbInputDims < nbDims)
+    if (nbInputDims == nbDims)
     {
-        nvinfer1::IShuffleLayer* reshape = addShuffle(ctx, *t, concat(ctx, fillShapeVector(ctx, 1, shapeVector(nbDims - nbInputDims)), shapeOf(*t)));
-        t = reshape->getOutput(0);
+        return Status::success();
     }
+    ASSERT(ctx->getOpsetVersion() >= 7 && "Pre-opset 7 broadcasting is unsupported in this version of the ONNX parser", ErrorCode::kUNSUPPORTED_NODE);
+    nvinfer1::IShuffleLayer* reshape = addShuffle(ctx, *t, concat(ctx, fillShapeVector(ctx, 1, shapeVector(nbDims - nbInputDims)), shapeOf(*t)));
+    t = reshape->getOutput(0);
+    return Status::success();
+}
+
+Status broadcastTensor(IImporterContext* ctx, TensorOrWeights& t, const int nbDims)
+{
+    if (t.is_tensor())
+    {
+        nvinfer1::ITensor* tensor = &t.tensor();
+        TRT_CHECK(broadcastTensor(ctx, tensor, nbDims));
+        t = tensor;
+        return Status::success();
+    }
+    // Prepending ones to the shape of weights does not move any data, so there is no need for a shuffle layer.
+    nvinfer1::Dims& shape = t.weights().shape;
+    assert(shape.nbDims <= nbDims);
+    if (shape.nbDims == nbDims)
+    {
+        return Status::success();
+    }
+    ASSERT(ctx->getOpsetVersion() >= 7 && "Pre-opset 7 broadcasting is unsupported in this version of the ONNX parser", ErrorCode::kUNSUPPORTED_NODE);
+    ASSERT(nbDims <= nvinfer1::Dims::MAX_DIMS, ErrorCode::kUNSUPPORTED_NODE);
+    const int nbNewDims = nbDims - shape.nbDims;
+    std::copy_backward(shape.d, shape.d + shape.nbDims, shape.d + nbDims);
+    std::fill(shape.d, shape.d + nbNewDims, 1);
+    shape.nbDims = nbDims;
+    return Status::success();
+}
+
+Status broadcastTensors(IImporterContext* ctx, TensorOrWeights& t1, TensorOrWeights& t2)
+{
+    const int maxDims = std::max(t1.shape().nbDims, t2.shape().nbDims);
+    TRT_CHECK(broadcastTensor(ctx, t1, maxDims));
+    TRT_CHECK(broadcastTensor(ctx, t2, maxDims));
+    return Status::success();
+}
+
+Status broadcastTensors(IImporterContext* ctx, TensorOrWeights& t1, TensorOrWeights& t2, TensorOrWeights& t3)
+{
+    const int maxDims = std::max({t1.shape().nbDims, t2.shape().nbDims, t3.shape().nbDims});
+    TRT_CHECK(broadcastTensor(ctx, t1, maxDims));
+    TRT_CHECK(broadcastTensor(ctx, t2, maxDims));
+    TRT_CHECK(broadcastTensor(ctx, t3, maxDims));
     return Status::success();
 }
 
@@ -671,6 +713,12 @@ NodeImportResult elementwiseHelper(IImporterContext* ctx, ::ONNX_NAMESPACE::Node
     std::vector<TensorOrWeights>& inputs, nvinfer1::ElementWiseOperation binary_op)
 {
     ASSERT(!inputs.empty(), ErrorCode::kINVALID_NODE);
+    bool handled = false;
+    NodeImportResult scaleResult = elementwiseScaleHelper(ctx, node, inputs, binary_op, &handled);
+    if (handled)
+    {
+        return scaleResult;
+    }
     std::vector<nvinfer1::ITensor*> inputTensors;
     int maxNbDims = -1;
     for (auto input : inputs)
@@ -680,10 +728,9 @@ NodeImportResult elementwiseHelper(IImporterContext* ctx, ::ONNX_NAMESPACE::Node
 
     for (auto input : inputs)
     {
+        // Broadcast all inputs to size of maxNbDims. Weights are broadcast before they become constant layers.
+        TRT_CHECK(broadcastTensor(ctx, input, maxNbDims));
         auto* tensor_ptr = &convertToTensor(input, ctx);
-
-        // Broadcast all input tensors to size of maxNbDims
-        broadcastTensor(ctx, tensor_ptr, maxNbDims);
         ASSERT(tensor_ptr->getDimensions().nbDims == maxNbDims && "Failed to broadcast tensors elementwise!",
             ErrorCode::kUNSUPPORTED_NODE);
         inputTensors.push_back(tensor_ptr);
@@ -976,9 +1023,10 @@ nvinfer1::ITensor* globalPoolingHelper(IImporterContext* ctx, ::ONNX_NAMESPACE::
     return layer->getOutput(0);
 }
 
-nvinfer1::IPluginCreator* importPluginCreator(const std::string& pluginName, const std::string& pluginVersion, const std::string& pluginNamespace)
+nvinfer1::IPluginCreator* importPluginCreator(IImporterContext* ctx, const std::string& pluginName,
+    const std::string& pluginVersion, const std::string& pluginNamespace)
 {
-    return getPluginRegistry()->getPluginCreator(pluginName.c_str(), pluginVersion.c_str(), pluginNamespace.c_str());
+    return ctx->getPluginCreator(pluginName, pluginVersion, pluginNamespace);
 }
 
 nvinfer1::IPluginV2* createPlugin(const std::string& name, nvinfer1::IPluginCreator* pluginCreator, const std::vector<nvinfer1::PluginField>& pluginFields)
@@ -1033,6 +1081,77 @@ bool isTransposeRequired(nvinfer1::Dims const& shape, nvinfer1::Permutation cons
     return false;
 }
 
+bool matchesNamePattern(const std::string& pattern, const std::string& name)
+{
+    // Greedy matching with backtracking to the most recent '*'.
+    size_t p = 0;
+    size_t n = 0;
+    size_t star = std::string::npos;
+    size_t starMatch = 0;
+    while (n < name.size())
+    {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n]))
+        {
+            ++p;
+            ++n;
+        }
+        else if (p < pattern.size() && pattern[p] == '*')
+        {
+            star = p++;
+            starMatch = n;
+        }
+        else if (star != std::string::npos)
+        {
+            p = star + 1;
+            n = ++starMatch;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+    {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+nvinfer1::ITensor* linearizeIndices(IImporterContext* ctx, nvinfer1::ITensor& data, nvinfer1::ITensor& indices)
+{
+    const auto dataShape = shapeOf(data);
+    const auto indicesShape = shapeOf(indices);
+    const int indicesRank = indices.getDimensions().nbDims;
+    const int k = indices.getDimensions().d[indicesRank - 1];
+    const ShapeTensor leading = gather(ctx, indicesShape, iotaShapeVector(indicesRank - 1));
+    const ShapeTensor sizes = concat(ctx, leading, shapeVector(1));
+    const ShapeTensor ones = similar(ctx, sizes, 1);
+
+    // Horner's scheme over the coordinates: linear = ((c0 * d1 + c1) * d2 + c2) ...
+    nvinfer1::ITensor* linear{nullptr};
+    for (int j = 0; j < k; ++j)
+    {
+        const ShapeTensor starts = concat(ctx, similar(ctx, leading, 0), shapeVector(j));
+        nvinfer1::ITensor* coord = addSlice(ctx, indices, starts, sizes, ones)->getOutput(0);
+        nvinfer1::ITensor* dim = &reshape(ctx, gather(ctx, dataShape, shapeVector(j)).tensor(ctx), ones);
+        // coord - floor(coord / dim) * dim maps [-dim, dim) onto [0, dim).
+        nvinfer1::ITensor* wraps
+            = ctx->network()->addElementWise(*coord, *dim, nvinfer1::ElementWiseOperation::kFLOOR_DIV)->getOutput(0);
+        wraps = ctx->network()->addElementWise(*wraps, *dim, nvinfer1::ElementWiseOperation::kPROD)->getOutput(0);
+        coord = ctx->network()->addElementWise(*coord, *wraps, nvinfer1::ElementWiseOperation::kSUB)->getOutput(0);
+        if (linear)
+        {
+            linear = ctx->network()->addElementWise(*linear, *dim, nvinfer1::ElementWiseOperation::kPROD)->getOutput(0);
+            linear = ctx->network()->addElementWise(*linear, *coord, nvinfer1::ElementWiseOperation::kSUM)->getOutput(0);
+        }
+        else
+        {
+            linear = coord;
+        }
+    }
+    return linear;
+}
+
 NodeImportResult lstmLegacyImporter(
     IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<TensorOrWeights>& inputs)
 {
@@ -1501,6 +1620,112 @@ nvinfer1::ITensor* reshapeTensor(IImporterContext* ctx, nvinfer1::ITensor& tenso
     return layer->getOutput(0);
 }
 
+bool getScaleMode(nvinfer1::Dims const& weights_shape, nvinfer1::Dims const& tensor_shape, nvinfer1::ScaleMode* mode)
+{
+    const int nbDims = tensor_shape.nbDims;
+    if (weights_shape.nbDims > nbDims || nbDims < 2)
+    {
+        return false;
+    }
+    // Align the weights with the trailing dimensions of the tensor, as for ONNX broadcasting.
+    const int offset = nbDims - weights_shape.nbDims;
+    auto weightsDim = [&](int axis) { return axis < offset ? 1 : weights_shape.d[axis - offset]; };
+    bool uniform = true;
+    bool channel = true;
+    bool elementwise = weightsDim(0) == 1;
+    for (int axis = 0; axis < nbDims; ++axis)
+    {
+        const int w = weightsDim(axis);
+        uniform = uniform && w == 1;
+        if (axis == 1)
+        {
+            channel = channel && w == tensor_shape.d[1] && w > 0;
+        }
+        else
+        {
+            channel = channel && w == 1;
+        }
+        if (axis > 0)
+        {
+            elementwise = elementwise && w == tensor_shape.d[axis] && w > 0;
+        }
+    }
+    if (uniform)
+    {
+        *mode = nvinfer1::ScaleMode::kUNIFORM;
+    }
+    else if (channel)
+    {
+        *mode = nvinfer1::ScaleMode::kCHANNEL;
+    }
+    else if (elementwise)
+    {
+        *mode = nvinfer1::ScaleMode::kELEMENTWISE;
+    }
+    return uniform || channel || elementwise;
+}
+
+NodeImportResult elementwiseScaleHelper(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node,
+    std::vector<TensorOrWeights>& inputs, nvinfer1::ElementWiseOperation binary_op, bool* handled)
+{
+    using eOp = nvinfer1::ElementWiseOperation;
+    *handled = false;
+    if (inputs.size() != 2 || !(binary_op == eOp::kSUM || binary_op == eOp::kSUB || binary_op == eOp::kPROD
+        || binary_op == eOp::kDIV))
+    {
+        return std::vector<TensorOrWeights>{};
+    }
+    // Sub and Div are only folded when the constant is the right-hand operand.
+    const bool commutative = binary_op == eOp::kSUM || binary_op == eOp::kPROD;
+    const int weightsIndex = inputs.at(1).is_weights() ? 1 : (commutative && inputs.at(0).is_weights() ? 0 : -1);
+    if (weightsIndex < 0 || !inputs.at(1 - weightsIndex).is_tensor())
+    {
+        return std::vector<TensorOrWeights>{};
+    }
+    nvinfer1::ITensor& tensor = inputs.at(1 - weightsIndex).tensor();
+    ShapedWeights const& weights = inputs.at(weightsIndex).weights();
+    const nvinfer1::Dims tensorDims = tensor.getDimensions();
+    nvinfer1::ScaleMode mode;
+    // Scale layers take 4D or 5D inputs; other ranks would need reshapes around the layer.
+    if ((tensorDims.nbDims != 4 && tensorDims.nbDims != 5) || weights.type != ::ONNX_NAMESPACE::TensorProto::FLOAT
+        || tensor.getType() != nvinfer1::DataType::kFLOAT
+        || !getScaleMode(weights.shape, tensorDims, &mode))
+    {
+        return std::vector<TensorOrWeights>{};
+    }
+    *handled = true;
+
+    const auto emptyWeights = ShapedWeights::empty(weights.type);
+    ShapedWeights shift = emptyWeights;
+    ShapedWeights scale = emptyWeights;
+    if (binary_op == eOp::kSUM)
+    {
+        shift = weights;
+    }
+    else if (binary_op == eOp::kPROD)
+    {
+        scale = weights;
+    }
+    else
+    {
+        // x - c = x + (-c) and x / c = x * (1 / c), computed once here.
+        ShapedWeights folded = ctx->createTempWeights(weights.type, weights.shape);
+        const float* src = static_cast<const float*>(weights.values);
+        float* dst = static_cast<float*>(folded.values);
+        for (size_t i = 0; i < weights.count(); ++i)
+        {
+            dst[i] = binary_op == eOp::kSUB ? -src[i] : 1.f / src[i];
+        }
+        (binary_op == eOp::kSUB ? shift : scale) = folded;
+    }
+    LOG_VERBOSE("Importing " << node.op_type() << " node " << getNodeName(node) << " with constant operand "
+                             << weights.getName() << " as a scale layer");
+    // Only weights taken verbatim from the model can be refitted.
+    const bool folded = binary_op == eOp::kSUB || binary_op == eOp::kDIV;
+    return scaleHelper(ctx, node, tensor, mode, shift, scale, emptyWeights, folded ? nullptr : shift.getName(),
+        folded ? nullptr : scale.getName());
+}
+
 NodeImportResult scaleHelper(IImporterContext* ctx, const ::ONNX_NAMESPACE::NodeProto& node, nvinfer1::ITensor& tensor_,
     nvinfer1::ScaleMode mode, const nvinfer1::Weights& shift, const nvinfer1::Weights& scale,
     const nvinfer1::Weights& power, const char* shiftName, const char* scaleName)
@@ -1532,6 +1757,14 @@ NodeImportResult scaleHelper(IImporterContext* ctx, const ::ONNX_NAMESPACE::Node
     ASSERT(layer && "Failed to add a Scale layer.", ErrorCode::kUNSUPPORTED_NODE);
     // Register layer name, and shift and scale weight names for the refit map.
     ctx->registerLayer(layer, getNodeName(node));
+    if (shiftName && shift.count > 0)
+    {
+        ctx->insertRefitMap(shiftName, layer->getName(), nvinfer1::WeightsRole::kSHIFT);
+    }
+    if (scaleName && scale.count > 0)
+    {
+        ctx->insertRefitMap(scaleName, layer->getName(), nvinfer1::WeightsRole::kSCALE);
+    }
 
     tensorPtr = layer->getOutput(0);
 
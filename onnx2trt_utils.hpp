@@ -149,6 +149,13 @@ NodeImportResult argMinMaxHelper(IImporterContext* ctx, const ::ONNX_NAMESPACE::
 //! Assert failure if t has rank greater than nbDims.
 Status broadcastTensor(IImporterContext* ctx, nvinfer1::ITensor*& t, const int nbDims);
 
+//! Same as above, but weights are broadcast by updating their shape, without adding any layers.
+Status broadcastTensor(IImporterContext* ctx, TensorOrWeights& t, const int nbDims);
+
+// Helper functions to broadcast tensors or weights to the largest rank, before they are converted to tensors
+Status broadcastTensors(IImporterContext* ctx, TensorOrWeights& t1, TensorOrWeights& t2);
+Status broadcastTensors(IImporterContext* ctx, TensorOrWeights& t1, TensorOrWeights& t2, TensorOrWeights& t3);
+
 // Helper function to broadcast two tensors to the larger one's shape
 Status broadcastTensors(IImporterContext* ctx, nvinfer1::ITensor*& t1, nvinfer1::ITensor*& t2);
 
@@ -249,8 +256,9 @@ void getKernelParams(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& o
 // Helper function to convert ONNX node name. If no node name is provided, use the name of the first output.
 const std::string getNodeName(const ::ONNX_NAMESPACE::NodeProto& node);
 
-// Helper function to get the scaling mode for TRT's scale layer
-nvinfer1::ScaleMode getScaleMode(nvinfer1::Dims const& weights_shape, nvinfer1::Dims const& tensor_shape);
+// Helper function to get the scaling mode for TRT's scale layer when weights of weights_shape are broadcast against
+// a tensor of tensor_shape with channels on axis 1. Returns false if the weights cannot be expressed as a scale.
+bool getScaleMode(nvinfer1::Dims const& weights_shape, nvinfer1::Dims const& tensor_shape, nvinfer1::ScaleMode* mode);
 
 // Helper function to map ONNX Global Pooling ops into TensorRT.
 nvinfer1::ITensor* globalPoolingHelper(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, nvinfer1::ITensor& tensor, nvinfer1::ReduceOperation op);
@@ -261,8 +269,9 @@ bool isDynamic(const nvinfer1::Dims& shape);
 // Helper function to determine if a ONNX tensor is empty
 bool isOnnxTensorEmpty(const ::ONNX_NAMESPACE::TensorProto& onnxTensor);
 
-// Helper function to load a creator from the registry
-nvinfer1::IPluginCreator* importPluginCreator(const std::string& pluginName, const std::string& pluginVersion, const std::string& pluginNamespace="");
+// Helper function to load a creator from the registry, through the cache of the importer context
+nvinfer1::IPluginCreator* importPluginCreator(IImporterContext* ctx, const std::string& pluginName,
+    const std::string& pluginVersion, const std::string& pluginNamespace = "");
 
 // Helper function to get a plugin from the PluginRegistry
 nvinfer1::IPluginV2* createPlugin(const std::string& name,
@@ -271,6 +280,15 @@ nvinfer1::IPluginV2* createPlugin(const std::string& name,
 // Helper function to determine if a transpose is required
 bool isTransposeRequired(nvinfer1::Dims const& shape, nvinfer1::Permutation const& perm);
 
+// Helper function to match a name against a pattern in which '*' matches any sequence of characters and '?' any
+// single character.
+bool matchesNamePattern(const std::string& pattern, const std::string& name);
+
+// Helper function to convert GatherND/ScatterND style indices, whose last axis of static length k holds coordinates
+// into the first k axes of data, into linear indices into those k axes. Negative coordinates are wrapped. The
+// returned tensor has the shape of indices with the last axis reduced to length 1.
+nvinfer1::ITensor* linearizeIndices(IImporterContext* ctx, nvinfer1::ITensor& data, nvinfer1::ITensor& indices);
+
 // Helper function to import LSTM ops through the legacy CUDNN path
 NodeImportResult lstmLegacyImporter(
     IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<TensorOrWeights>& inputs);
@@ -293,6 +311,11 @@ NodeImportResult reduceTensor(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto
 // Helper function to shape a Tensor given a new shape
 nvinfer1::ITensor* reshapeTensor(IImporterContext* ctx, nvinfer1::ITensor& tensor, nvinfer1::Dims shape);
 
+// Helper function to import Add/Sub/Mul/Div of a 4D or 5D tensor and constant per-channel or scalar weights as a
+// scale layer, which TensorRT fuses into preceding convolutions. Returns false in *handled if the node does not qualify.
+NodeImportResult elementwiseScaleHelper(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node,
+    std::vector<TensorOrWeights>& inputs, nvinfer1::ElementWiseOperation binary_op, bool* handled);
+
 // Helper function to map attributes to a TRT scale layer
 NodeImportResult scaleHelper(IImporterContext* ctx, const ::ONNX_NAMESPACE::NodeProto& node, nvinfer1::ITensor& tensor_,
     nvinfer1::ScaleMode mode, const nvinfer1::Weights& shift, const nvinfer1::Weights& scale,
@@ -24,11 +24,18 @@ from __future__ import print_function
 from __future__ import unicode_literals
 
 import os
+import threading
+import time
 
+import numpy as np
+import tensorrt
 import unittest
+import onnx
 import onnx.backend.test
+from onnx import helper, TensorProto
 
 import onnx_tensorrt.backend as trt
+from onnx_tensorrt.tensorrt_engine import EnginePool
 
 # This is a pytest magic variable to load extra plugins
 pytest_plugins = 'onnx.backend.test.report',
@@ -57,6 +64,7 @@ backend_test.include(r'.*test_constant.*')
 backend_test.include(r'.*test_Conv[1-3]d*')
 backend_test.include(r'.*test_cos.*')
 backend_test.include(r'.*test_cosh.*')
+backend_test.include(r'.*test_cumsum.*')
 backend_test.include(r'.*test_depthtospace.*')
 backend_test.include(r'.*test_div.*')
 backend_test.include(r'.*test_dropout.*')
@@ -69,6 +77,7 @@ backend_test.include(r'.*test_eyelike.*')
 backend_test.include(r'.*test_flatten.*')
 backend_test.include(r'.*test_floor.*')
 backend_test.include(r'.*test_gather.*')
+backend_test.include(r'.*test_gathernd.*')
 backend_test.include(r'.*test_gemm.*')
 backend_test.include(r'.*test_globalaveragepool.*')
 backend_test.include(r'.*test_globalmaxpool.*')
@@ -124,6 +133,7 @@ backend_test.include(r'.*test_reciprocal.*')
 backend_test.include(r'.*test_reduce.*')
 backend_test.include(r'.*test_ReLU*')
 backend_test.include(r'.*test_relu.*')
+backend_test.include(r'.*test_scatternd.*')
 backend_test.include(r'.*test_selu.*')
 backend_test.include(r'.*test_shape.*')
 backend_test.include(r'.*test_Sigmoid*')
@@ -172,6 +182,9 @@ backend_test.include(r'.*test_topk.*custom.*')
 backend_test.include(r'.*test_upsample.*custom.*')
 backend_test.include(r'.*test_constant_pad_custom.*')
 backend_test.include(r'.*test_resize.*custom.*')
+backend_test.include(r'.*test_resize.*cubic.*')
+backend_test.include(r'.*test_resize.*nearest.*round_prefer.*')
+backend_test.include(r'.*test_resize_tf_crop_and_resize.*')
 backend_test.include(r'.*test_split.*custom.*')
 backend_test.include(r'.*test_instancenorm_.*_custom.*')
 backend_test.include(r'.*test_slice.*custom.*')
@@ -190,9 +203,348 @@ backend_test.exclude(r'.*test_maxunpool.*')
 # Absolute diff failed because
 # numpy compares the difference between actual and desired to atol + rtol * abs(desired)
 backend_test.exclude(r'.*test_convtranspose_3d_custom_cuda')
+# CumSum needs the axis as an initializer unless the input is 1D
+backend_test.exclude(r'.*test_cumsum_2d.*')
+# GatherND with batch_dims and ScatterND with reduction are not supported
+backend_test.exclude(r'.*test_gathernd_.*batch_dim.*')
+backend_test.exclude(r'.*test_scatternd_(add|multiply|min|max).*')
 # dilations not supported in ConvTRanspose layer
 backend_test.exclude(r'.*test_convtranspose_dilations_custom_cuda')
 
+class EnginePoolTest(unittest.TestCase):
+    def test_concurrent_callers_own_their_outputs(self):
+        # A single slot forces both threads through the same host buffers.
+        node = helper.make_node('Add', ['x', 'x'], ['y'])
+        graph = helper.make_graph([node], 'pool_test',
+            [helper.make_tensor_value_info('x', TensorProto.FLOAT, [1024])],
+            [helper.make_tensor_value_info('y', TensorProto.FLOAT, [1024])])
+        model = helper.make_model(graph)
+        rep = trt.prepare(model, device='CUDA:0')
+        pool = EnginePool(rep.engine.engine, pool_size=1)
+
+        errors = []
+        def worker(value):
+            x = np.full(1024, value, dtype=np.float32)
+            for _ in range(50):
+                y, = pool.run([x])
+                # Give the other thread time to run on the returned slot.
+                time.sleep(0.001)
+                if not np.all(y == 2 * value):
+                    errors.append(value)
+                    return
+
+        threads = [threading.Thread(target=worker, args=(v,)) for v in (1.0, 3.0)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEqual(errors, [])
+
+class LegacyBroadcastTest(unittest.TestCase):
+    def test_opset6_same_rank_add(self):
+        # Operands of equal rank need no broadcasting, so pre-opset 7 models must still import.
+        node = helper.make_node('Add', ['a', 'b'], ['y'])
+        graph = helper.make_graph([node], 'opset6_add',
+            [helper.make_tensor_value_info('a', TensorProto.FLOAT, [2, 3, 4]),
+             helper.make_tensor_value_info('b', TensorProto.FLOAT, [2, 3, 4])],
+            [helper.make_tensor_value_info('y', TensorProto.FLOAT, [2, 3, 4])])
+        model = helper.make_model(graph, opset_imports=[helper.make_opsetid('', 6)])
+        a = np.random.rand(2, 3, 4).astype(np.float32)
+        b = np.random.rand(2, 3, 4).astype(np.float32)
+        y, = trt.prepare(model, device='CUDA:0').run([a, b])
+        np.testing.assert_allclose(y, a + b, rtol=1e-6)
+
+class ConvScaleTest(unittest.TestCase):
+    def test_per_channel_add_becomes_scale_layer(self):
+        # A constant [C, 1, 1] operand after a Conv is imported as a single IScaleLayer, without a constant layer.
+        rng = np.random.RandomState(0)
+        x = rng.uniform(size=(1, 3, 8, 8)).astype(np.float32)
+        w = rng.uniform(size=(4, 3, 1, 1)).astype(np.float32)
+        b = rng.uniform(size=(4, 1, 1)).astype(np.float32)
+        nodes = [helper.make_node('Conv', ['x', 'w'], ['conv']),
+                 helper.make_node('Add', ['conv', 'b'], ['y'])]
+        graph = helper.make_graph(nodes, 'conv_add',
+            [helper.make_tensor_value_info('x', TensorProto.FLOAT, x.shape)],
+            [helper.make_tensor_value_info('y', TensorProto.FLOAT, [1, 4, 8, 8])],
+            initializer=[helper.make_tensor('w', TensorProto.FLOAT, w.shape, w.flatten()),
+                         helper.make_tensor('b', TensorProto.FLOAT, b.shape, b.flatten())])
+        rep = trt.prepare(helper.make_model(graph), device='CUDA:0')
+
+        layer_types = [rep.network[i].type for i in range(rep.network.num_layers)]
+        self.assertEqual(layer_types, [tensorrt.LayerType.CONVOLUTION, tensorrt.LayerType.SCALE])
+        y, = rep.run([x])
+        np.testing.assert_allclose(y, np.einsum('oi,nihw->nohw', w[:, :, 0, 0], x) + b, rtol=1e-5)
+
+class RuntimeIfTest(unittest.TestCase):
+    def make_if_model(self, then_nodes, else_nodes, then_output, else_output, inputs, output_shape, initializers=()):
+        then_graph = helper.make_graph(then_nodes, 'then_branch', [],
+            [helper.make_tensor_value_info(then_output, TensorProto.FLOAT, output_shape)])
+        else_graph = helper.make_graph(else_nodes, 'else_branch', [],
+            [helper.make_tensor_value_info(else_output, TensorProto.FLOAT, output_shape)])
+        node = helper.make_node('If', ['cond'], ['y'], then_branch=then_graph, else_branch=else_graph)
+        graph = helper.make_graph([node], 'runtime_if',
+            [helper.make_tensor_value_info('cond', TensorProto.BOOL, [1])]
+            + [helper.make_tensor_value_info(name, TensorProto.FLOAT, shape) for name, shape in inputs],
+            [helper.make_tensor_value_info('y', TensorProto.FLOAT, output_shape)],
+            initializer=list(initializers))
+        return helper.make_model(graph)
+
+    def parse(self, model):
+        logger = tensorrt.Logger(tensorrt.Logger.WARNING)
+        builder = tensorrt.Builder(logger)
+        network = builder.create_network(1 << int(tensorrt.NetworkDefinitionCreationFlag.EXPLICIT_BATCH))
+        parser = tensorrt.OnnxParser(network, logger)
+        return parser.parse(model.SerializeToString()), parser, network, builder
+
+    def test_tensor_condition_selects_branch(self):
+        model = self.make_if_model(
+            [helper.make_node('Add', ['x', 'one'], ['then_y'])], [helper.make_node('Mul', ['x', 'two'], ['else_y'])],
+            'then_y', 'else_y', [('x', [2, 3])], [2, 3],
+            [helper.make_tensor('one', TensorProto.FLOAT, [1], [1.0]),
+             helper.make_tensor('two', TensorProto.FLOAT, [1], [2.0])])
+        rep = trt.prepare(model, device='CUDA:0')
+        x = np.random.RandomState(0).uniform(size=(2, 3)).astype(np.float32)
+        y, = rep.run([np.array([True]), x])
+        np.testing.assert_allclose(y, x + 1, rtol=1e-6)
+        y, = rep.run([np.array([False]), x])
+        np.testing.assert_allclose(y, x * 2, rtol=1e-6)
+
+    def test_branch_returns_outer_scope_tensor(self):
+        model = self.make_if_model([], [helper.make_node('Neg', ['x'], ['else_y'])], 'x', 'else_y',
+            [('x', [4])], [4])
+        rep = trt.prepare(model, device='CUDA:0')
+        x = np.arange(4, dtype=np.float32)
+        y, = rep.run([np.array([True]), x])
+        np.testing.assert_array_equal(y, x)
+        y, = rep.run([np.array([False]), x])
+        np.testing.assert_array_equal(y, -x)
+
+    def test_random_branch_is_rejected(self):
+        model = self.make_if_model(
+            [helper.make_node('RandomNormal', [], ['then_y'], shape=[4])], [helper.make_node('Neg', ['x'], ['else_y'])],
+            'then_y', 'else_y', [('x', [4])], [4])
+        parsed, parser, _, _ = self.parse(model)
+        self.assertFalse(parsed)
+        self.assertIn('must not contain random operators', parser.get_error(0).desc())
+
+    def test_expensive_branches_are_rejected_before_import(self):
+        # A 1024^3 MatMul is 2^31 FLOPs, well above MAX_SELECT_IF_FLOPS.
+        model = self.make_if_model(
+            [helper.make_node('MatMul', ['a', 'b'], ['then_y'])], [helper.make_node('Add', ['a', 'b'], ['else_y'])],
+            'then_y', 'else_y', [('a', [1024, 1024]), ('b', [1024, 1024])], [1024, 1024])
+        parsed, parser, network, _ = self.parse(model)
+        self.assertFalse(parsed)
+        self.assertIn('too expensive to execute both', parser.get_error(0).desc())
+        # The If is the only node, so nothing of either branch may be left behind.
+        self.assertEqual(network.num_layers, 0)
+
+class ShapeTensorTrackerTest(unittest.TestCase):
+    def test_second_output_becomes_shape_tensor(self):
+        # The indices of the TopK become a shape tensor through the Reshape. Only that output's type may be fixed.
+        nodes = [helper.make_node('TopK', ['x', 'k'], ['values', 'indices']),
+                 helper.make_node('Reshape', ['data', 'indices'], ['y'])]
+        graph = helper.make_graph(nodes, 'topk_shape',
+            [helper.make_tensor_value_info('x', TensorProto.FLOAT, [4]),
+             helper.make_tensor_value_info('data', TensorProto.FLOAT, [2, 3])],
+            [helper.make_tensor_value_info('values', TensorProto.FLOAT, [2]),
+             helper.make_tensor_value_info('y', TensorProto.FLOAT, [None, None])],
+            initializer=[helper.make_tensor('k', TensorProto.INT64, [1], [2])])
+        logger = tensorrt.Logger(tensorrt.Logger.WARNING)
+        builder = tensorrt.Builder(logger)
+        network = builder.create_network(1 << int(tensorrt.NetworkDefinitionCreationFlag.EXPLICIT_BATCH))
+        parser = tensorrt.OnnxParser(network, logger)
+        self.assertTrue(parser.parse(helper.make_model(graph).SerializeToString()))
+
+        topk = [network[i] for i in range(network.num_layers) if network[i].type == tensorrt.LayerType.TOPK]
+        self.assertEqual(len(topk), 1)
+        layer = topk[0]
+        self.assertTrue(layer.get_output(1).is_shape_tensor)
+        self.assertTrue(layer.output_type_is_set(1))
+        self.assertEqual(layer.get_output_type(1), tensorrt.int32)
+        self.assertFalse(layer.output_type_is_set(0))
+        self.assertEqual(layer.get_output(0).dtype, tensorrt.float32)
+
+def cumsum_reference(x, axis, exclusive, reverse):
+    """CumSum following the ONNX specification, accumulated in float64."""
+    if reverse:
+        x = np.flip(x, axis)
+    y = np.cumsum(x.astype(np.float64), axis=axis)
+    if exclusive:
+        # Shift the inclusive sums by one along axis and fill in a zero.
+        zeros = np.zeros_like(np.take(y, [0], axis=axis))
+        y = np.concatenate([zeros, np.delete(y, -1, axis=axis)], axis=axis)
+    if reverse:
+        y = np.flip(y, axis)
+    return y
+
+class CumSumTest(unittest.TestCase):
+    def check(self, shape, axis, dtype, expected_layer, dynamic_axis=False):
+        onnx_type = TensorProto.FLOAT16 if dtype == np.float16 else TensorProto.FLOAT
+        # Small integers keep every partial sum exact in FP16, so all lowerings must match the reference exactly.
+        x = np.random.RandomState(0).randint(0, 4, size=shape).astype(dtype)
+        io_shape = ['n' if dynamic_axis and i == axis else d for i, d in enumerate(shape)]
+        for exclusive in (0, 1):
+            for reverse in (0, 1):
+                node = helper.make_node('CumSum', ['x', 'axis'], ['y'], exclusive=exclusive, reverse=reverse)
+                graph = helper.make_graph([node], 'cumsum',
+                    [helper.make_tensor_value_info('x', onnx_type, io_shape)],
+                    [helper.make_tensor_value_info('y', onnx_type, io_shape)],
+                    initializer=[helper.make_tensor('axis', TensorProto.INT32, [], [axis])])
+                rep = trt.prepare(helper.make_model(graph), device='CUDA:0')
+
+                layer_types = [rep.network[i].type for i in range(rep.network.num_layers)]
+                if expected_layer is None:
+                    self.assertNotIn(tensorrt.LayerType.MATRIX_MULTIPLY, layer_types)
+                    self.assertNotIn(tensorrt.LayerType.LOOP_OUTPUT, layer_types)
+                else:
+                    self.assertIn(expected_layer, layer_types)
+                y, = rep.run([x])
+                np.testing.assert_array_equal(y.astype(np.float64), cumsum_reference(x, axis, exclusive, reverse),
+                    err_msg='exclusive=%d, reverse=%d' % (exclusive, reverse))
+
+    def test_fp16_short_axis_uses_matmul(self):
+        self.check((3, 200, 4), 1, np.float16, tensorrt.LayerType.MATRIX_MULTIPLY)
+
+    def test_long_static_axis_uses_prefix_scan(self):
+        self.check((2, 1000, 3), 1, np.float32, None)
+
+    def test_dynamic_axis_uses_loop(self):
+        self.check((7, 5), 0, np.float32, tensorrt.LayerType.LOOP_OUTPUT, dynamic_axis=True)
+
+def gather_elements_reference(data, indices, axis):
+    """GatherElements following the ONNX specification, for indices no larger than data."""
+    axis = axis % data.ndim
+    indices = np.where(indices < 0, indices + data.shape[axis], indices)
+    # Only the leading part of the other axes of data is read when indices are smaller.
+    window = tuple(slice(None) if i == axis else slice(0, n) for i, n in enumerate(indices.shape))
+    return np.take_along_axis(data[window], indices, axis=axis)
+
+class GatherElementsTest(unittest.TestCase):
+    def check(self, data_shape, indices_shape, axis):
+        rng = np.random.RandomState(0)
+        data = rng.uniform(size=data_shape).astype(np.float32)
+        size = data_shape[axis]
+        # Cover the whole range [-size, size) allowed for indices, negative values included.
+        indices = rng.randint(-size, size, size=indices_shape).astype(np.int64)
+        node = helper.make_node('GatherElements', ['data', 'indices'], ['y'], axis=axis)
+        y, = trt.run_node(node, [data, indices])
+        np.testing.assert_array_equal(y, gather_elements_reference(data, indices, axis))
+
+    def test_first_axis(self):
+        self.check((4, 5, 6), (3, 5, 6), 0)
+
+    def test_middle_axis(self):
+        self.check((4, 5, 6), (4, 7, 6), 1)
+
+    def test_last_axis(self):
+        self.check((4, 5, 6), (4, 5, 9), 2)
+
+    def test_negative_axis(self):
+        self.check((3, 4, 5), (3, 4, 2), -1)
+
+    def test_indices_smaller_than_data(self):
+        self.check((6, 7, 8), (2, 3, 4), 1)
+
+def reverse_sequence_reference(x, sequence_lens, batch_axis, time_axis):
+    """ReverseSequence following the ONNX specification."""
+    y = x.copy()
+    for b, length in enumerate(sequence_lens):
+        index = [slice(None)] * x.ndim
+        index[batch_axis] = b
+        index[time_axis] = slice(0, length)
+        # Indexing the batch axis leaves the time axis first.
+        y[tuple(index)] = x[tuple(index)][::-1]
+    return y
+
+class ReverseSequenceTest(unittest.TestCase):
+    def check(self, batch_axis):
+        time_axis = 1 - batch_axis
+        batch, steps = 4, 5
+        shape = [0, 0, 3]
+        shape[batch_axis], shape[time_axis] = batch, steps
+        x = np.random.RandomState(0).uniform(size=shape).astype(np.float32)
+        # No reversal, a single step, a partial and a full-length reversal.
+        sequence_lens = np.array([0, 1, 3, steps], dtype=np.int64)
+        node = helper.make_node('ReverseSequence', ['x', 'sequence_lens'], ['y'],
+            batch_axis=batch_axis, time_axis=time_axis)
+        y, = trt.run_node(node, [x, sequence_lens])
+        np.testing.assert_array_equal(y, reverse_sequence_reference(x, sequence_lens, batch_axis, time_axis))
+
+    def test_batch_axis_0(self):
+        self.check(0)
+
+    def test_batch_axis_1(self):
+        self.check(1)
+
+def nms_reference(boxes, scores, max_output_boxes_per_class, iou_threshold, score_threshold):
+    """CPU NonMaxSuppression following the ONNX specification, for corner boxes."""
+    def iou(a, b):
+        y1, x1 = np.maximum(a[:2], b[:2])
+        y2, x2 = np.minimum(a[2:], b[2:])
+        inter = max(y2 - y1, 0) * max(x2 - x1, 0)
+        area = lambda r: (r[2] - r[0]) * (r[3] - r[1])
+        return inter / (area(a) + area(b) - inter)
+    selected = []
+    for b in range(scores.shape[0]):
+        for c in range(scores.shape[1]):
+            kept = []
+            for i in np.argsort(-scores[b, c], kind='stable'):
+                if scores[b, c, i] <= score_threshold or len(kept) == max_output_boxes_per_class:
+                    break
+                if all(iou(boxes[b, i], boxes[b, j]) <= iou_threshold for j in kept):
+                    kept.append(i)
+            selected += [[b, c, i] for i in kept]
+    return np.array(selected, dtype=np.int64).reshape(-1, 3)
+
+class NonMaxSuppressionTest(unittest.TestCase):
+    def run_nms(self, boxes, scores, max_output, iou_threshold, score_threshold):
+        node = helper.make_node('NonMaxSuppression',
+            ['boxes', 'scores', 'max_output', 'iou_threshold', 'score_threshold'], ['selected'])
+        graph = helper.make_graph([node], 'nms_test',
+            [helper.make_tensor_value_info('boxes', TensorProto.FLOAT, boxes.shape),
+             helper.make_tensor_value_info('scores', TensorProto.FLOAT, scores.shape)],
+            [helper.make_tensor_value_info('selected', TensorProto.INT64, [None, 3])],
+            initializer=[helper.make_tensor('max_output', TensorProto.INT64, [1], [max_output]),
+                         helper.make_tensor('iou_threshold', TensorProto.FLOAT, [1], [iou_threshold]),
+                         helper.make_tensor('score_threshold', TensorProto.FLOAT, [1], [score_threshold])])
+        selected, = trt.prepare(helper.make_model(graph), device='CUDA:0').run([boxes, scores])
+
+        # Rows past the number of boxes kept for a class are padding. The EfficientNMS plugin, when registered, orders
+        # the rows of an image by score across classes, so regroup them by image and class before comparing.
+        selected = selected[selected[:, 0] >= 0]
+        selected = selected[np.lexsort((selected[:, 1], selected[:, 0]))]
+        expected = nms_reference(boxes, scores, max_output, iou_threshold, score_threshold)
+        np.testing.assert_array_equal(selected, expected)
+
+    def test_matches_reference(self):
+        rng = np.random.RandomState(0)
+        batch, nb_boxes, nb_classes = 2, 64, 3
+        corners = rng.uniform(0, 1, size=(batch, nb_boxes, 2, 2)).astype(np.float32)
+        boxes = np.concatenate([corners.min(axis=2), corners.max(axis=2)], axis=2)
+        scores = rng.uniform(0, 1, size=(batch, nb_classes, nb_boxes)).astype(np.float32)
+        self.run_nms(boxes, scores, 5, 0.3, 0.2)
+
+    def test_duplicate_boxes(self):
+        # Identical boxes never exceed an IoU threshold of 1, so each copy is selected under its own index.
+        rng = np.random.RandomState(0)
+        corners = rng.uniform(0, 1, size=(1, 4, 2, 2)).astype(np.float32)
+        boxes = np.concatenate([corners.min(axis=2), corners.max(axis=2)], axis=2)
+        boxes = np.concatenate([boxes, boxes], axis=1)
+        scores = rng.permutation(8).astype(np.float32).reshape(1, 1, 8)
+        self.run_nms(boxes, scores, 8, 1.0, -1.0)
+
+class PairwiseSizeLimitTest(unittest.TestCase):
+    def test_large_scatternd_is_rejected(self):
+        # 2^20 data rows times 2^7 updates exceeds the 2^26-element budget of the one-hot hit matrix.
+        node = helper.make_node('ScatterND', ['data', 'indices', 'updates'], ['y'])
+        graph = helper.make_graph([node], 'scatternd_limit',
+            [helper.make_tensor_value_info('data', TensorProto.FLOAT, [1 << 20]),
+             helper.make_tensor_value_info('indices', TensorProto.INT64, [1 << 7, 1]),
+             helper.make_tensor_value_info('updates', TensorProto.FLOAT, [1 << 7])],
+            [helper.make_tensor_value_info('y', TensorProto.FLOAT, [1 << 20])])
+        with self.assertRaisesRegex(RuntimeError, 'ScatterND has too many data rows and updates'):
+            trt.prepare(helper.make_model(graph), device='CUDA:0')
+
 globals().update(backend_test
                  .enable_report()
                  .test_cases)
@@ -19,7 +19,7 @@
  # DEALINGS IN THE SOFTWARE.
 
 from __future__ import print_function
-from .tensorrt_engine import Engine
+from .tensorrt_engine import Engine, EnginePool
 import tensorrt as trt
 from onnx.backend.base import Backend, BackendRep, Device, DeviceType, namedtupledict
 import onnx
@@ -27,6 +27,8 @@ from onnx import helper as onnx_helper
 from onnx import numpy_helper
 import numpy as np
 import six
+import threading
+import warnings
 
 # HACK Should look for a better way/place to do this
 from ctypes import cdll, c_char_p
@@ -50,7 +52,8 @@ TRT_LOGGER = trt.Logger(trt.Logger.WARNING)
 
 class TensorRTBackendRep(BackendRep):
     def __init__(self, model, device,
-            max_workspace_size=None, serialize_engine=False, verbose=False, **kwargs):
+            max_workspace_size=None, serialize_engine=False, verbose=False,
+            pool_size=1, **kwargs):
         if not isinstance(device, Device):
             device = Device(device)
         self._set_device(device)
@@ -63,6 +66,10 @@ class TensorRTBackendRep(BackendRep):
         self.serialize_engine = serialize_engine
         self.verbose = verbose
         self.dynamic = False
+        # Number of execution contexts that may run concurrently. With a pool
+        # size above 1, run() can be called from multiple Python threads.
+        self.pool_size = pool_size
+        self._build_lock = threading.Lock()
 
         if self.verbose:
             print(f'\nRunning {model.graph.name}...')
@@ -102,6 +109,13 @@ class TensorRTBackendRep(BackendRep):
 
             print(f'Output shape: {self.network[-1].get_output(0).shape}')
         
+        if self.dynamic and self.pool_size > 1:
+            # The engine is rebuilt for the shapes of every run() call, so
+            # there is no single engine to pool contexts of.
+            warnings.warn("pool_size=%d is ignored for models with dynamic input shapes; "
+                          "run() calls are serialized instead." % self.pool_size)
+            self.pool_size = 1
+
         if self.dynamic:
             if self.verbose:
                 print("Found dynamic inputs! Deferring engine build to run stage")
@@ -148,7 +162,10 @@ class TensorRTBackendRep(BackendRep):
             raise RuntimeError("Failed to build TensorRT engine from network")
         if self.serialize_engine:
             trt_engine = self._serialize_deserialize(trt_engine)
-        self.engine = Engine(trt_engine)
+        if self.pool_size > 1:
+            self.engine = EnginePool(trt_engine, self.pool_size)
+        else:
+            self.engine = Engine(trt_engine)
 
     def _set_device(self, device):
         self.device = device
@@ -171,10 +188,16 @@ class TensorRTBackendRep(BackendRep):
             inputs = [inputs]
         
         if self.dynamic:
-            self._build_engine(inputs)
-
-        outputs = self.engine.run(inputs)
-        output_names = [output.name for output in self.engine.outputs]
+            # The engine is rebuilt for every input shape, so concurrent
+            # callers have to be serialized.
+            with self._build_lock:
+                self._build_engine(inputs)
+                outputs = self.engine.run(inputs)
+                # Read the names before another caller can swap the engine.
+                output_names = [output.name for output in self.engine.outputs]
+        else:
+            outputs = self.engine.run(inputs)
+            output_names = [output.name for output in self.engine.outputs]
 
         for i, (name, array) in enumerate(zip(output_names, outputs)):
             output_shape = self._output_shapes[name]
@@ -24,6 +24,8 @@ import pycuda.gpuarray
 import pycuda.autoinit
 import numpy as np
 from six import string_types
+from six.moves import queue
+import contextlib
 
 class Binding(object):
     def __init__(self, engine, idx_or_name):
@@ -105,34 +107,42 @@ def check_input_validity(input_idx, input_array, input_binding):
             else:
                 raise TypeError("Wrong dtype for input %i. Expected %s, got %s. Cannot safely cast." %
                             (input_idx, input_binding.dtype, input_array.dtype))
+        #TRT does not support DOUBLE, need to convert to FLOAT
+        elif input_array.dtype == np.float64 and input_binding.dtype == np.float32:
+            casted_input_array = np.array(input_array, copy=True, dtype=np.float32)
+            if np.equal(input_array, casted_input_array).all():
+                input_array = casted_input_array
+            else:
+                raise TypeError("Wrong dtype for input %i. Expected %s, got %s. Cannot safely cast." %
+                            (input_idx, input_binding.dtype, input_array.dtype))
         else:
             raise TypeError("Wrong dtype for input %i. Expected %s, got %s." %
                             (input_idx, input_binding.dtype, input_array.dtype))
     return input_array
 
 
-class Engine(object):
+class ExecutionSlot(object):
+    """An execution context together with the stream and bindings it runs on.
+
+    Slots created from the same engine share its weights but own their device
+    and host buffers, so different slots may execute concurrently.
+    """
     def __init__(self, trt_engine):
-        self.engine = trt_engine
-        nbinding = self.engine.num_bindings
+        nbinding = trt_engine.num_bindings
 
-        bindings = [Binding(self.engine, i)
+        bindings = [Binding(trt_engine, i)
                     for i in range(nbinding)]
         self.binding_addrs = [b.device_buffer.ptr for b in bindings]
         self.inputs  = [b for b in bindings if     b.is_input]
         self.outputs = [b for b in bindings if not b.is_input]
-        
+
         for binding in self.inputs + self.outputs:
             _ = binding.device_buffer # Force buffer allocation
         for binding in self.outputs:
             _ = binding.host_buffer   # Force buffer allocation
-        self.context = self.engine.create_execution_context()
+        self.context = trt_engine.create_execution_context()
         self.stream = pycuda.driver.Stream()
 
-    def __del__(self):
-        if self.engine is not None:
-            del self.engine
-
     def run(self, inputs):
         # len(inputs) > len(self.inputs) with Shape operator, input is never used
         # len(inputs) == len(self.inputs) for other operators
@@ -141,7 +151,7 @@ class Engine(object):
                              (len(self.inputs), len(inputs)))
         if isinstance(inputs, dict):
             inputs = [inputs[b.name] for b in self.inputs]
-        
+
 
         for i, (input_array, input_binding) in enumerate(zip(inputs, self.inputs)):
             input_array = check_input_validity(i, input_array, input_binding)
@@ -165,3 +175,74 @@ class Engine(object):
     def run_no_dma(self, batch_size):
         self.context.execute_async(
             batch_size, self.binding_addrs, self.stream.handle)
+
+
+class Engine(object):
+    def __init__(self, trt_engine):
+        self.engine = trt_engine
+        self._slot = ExecutionSlot(self.engine)
+        self.binding_addrs = self._slot.binding_addrs
+        self.inputs  = self._slot.inputs
+        self.outputs = self._slot.outputs
+        self.context = self._slot.context
+        self.stream = self._slot.stream
+
+    def __del__(self):
+        if self.engine is not None:
+            del self.engine
+
+    def run(self, inputs):
+        return self._slot.run(inputs)
+
+    def run_no_dma(self, batch_size):
+        self._slot.run_no_dma(batch_size)
+
+
+class EnginePool(object):
+    """A thread-safe engine wrapper holding several execution slots.
+
+    All slots are created from a single deserialized engine. Each call to run()
+    checks out a free slot, blocking until one is returned if all of them are
+    in use, so up to pool_size callers can execute concurrently.
+    """
+    def __init__(self, trt_engine, pool_size=1):
+        if pool_size < 1:
+            raise ValueError("Engine pool size must be at least 1, got %i." % pool_size)
+        self.engine = trt_engine
+        # pycuda.autoinit only makes its context current on the importing thread.
+        self.cuda_context = pycuda.autoinit.context
+        self.pool_size = pool_size
+        self._slots = [ExecutionSlot(self.engine) for _ in range(pool_size)]
+        self._free = queue.Queue()
+        for slot in self._slots:
+            self._free.put(slot)
+        # Binding metadata is identical across slots.
+        self.inputs  = self._slots[0].inputs
+        self.outputs = self._slots[0].outputs
+
+    def __del__(self):
+        if self.engine is not None:
+            del self.engine
+
+    @contextlib.contextmanager
+    def checkout(self, timeout=None):
+        """Borrow an execution slot for the duration of a with-block.
+        timeout -- Seconds to wait for a free slot, or None to wait forever.
+        """
+        try:
+            slot = self._free.get(timeout=timeout)
+        except queue.Empty:
+            raise RuntimeError("Timed out waiting for a free execution slot.")
+        self.cuda_context.push()
+        try:
+            yield slot
+        finally:
+            pycuda.driver.Context.pop()
+            self._free.put(slot)
+
+    def run(self, inputs, timeout=None):
+        with self.checkout(timeout) as slot:
+            # The results alias the slot's pagelocked host buffers, which the
+            # next caller overwrites as soon as the slot is returned.
+            results = slot.run(inputs)
+            return [r.copy() for r in results]
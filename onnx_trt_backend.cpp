@@ -20,6 +20,7 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include "AsyncLogger.hpp"
 #include "NvOnnxParser.h"
 #include "onnx/onnxifi.h"
 #include <NvInfer.h>
@@ -61,33 +62,9 @@ inline std::shared_ptr<T> infer_object(T* obj)
     return std::shared_ptr<T>(obj, InferDeleter());
 }
 
-// Logger for TRT info/warning/errors
-class TRT_Logger : public nvinfer1::ILogger
-{
-    nvinfer1::ILogger::Severity _verbosity;
-    std::ostream* _ostream;
-
-public:
-    TRT_Logger(Severity verbosity = Severity::kWARNING, std::ostream& ostream = std::cout)
-        : _verbosity(verbosity)
-        , _ostream(&ostream)
-    {
-    }
-    void log(Severity severity, const char* msg) override
-    {
-        if (severity <= _verbosity)
-        {
-            time_t rawtime = std::time(0);
-            char buf[256];
-            strftime(&buf[0], 256, "%Y-%m-%d %H:%M:%S", std::gmtime(&rawtime));
-            const char* sevstr = (severity == Severity::kINTERNAL_ERROR ? "    BUG" : severity == Severity::kERROR
-                        ? "  ERROR"
-                        : severity == Severity::kWARNING ? "WARNING" : severity == Severity::kINFO ? "   INFO"
-                                                                                                   : "UNKNOWN");
-            (*_ostream) << "[" << buf << " " << sevstr << "] " << msg << std::endl;
-        }
-    }
-};
+// Logger for TRT info/warning/errors. Logging happens on a background thread so that
+// verbose builds and parses are not slowed down by per-message flushes.
+using TRT_Logger = common::AsyncLogger;
 
 onnxStatus CheckShape(const nvinfer1::Dims& dims, const onnxTensorDescriptorV1& desc, bool allow_same_size)
 {
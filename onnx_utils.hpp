@@ -21,12 +21,14 @@
  */
 
 #include <fstream>
+#include <google/protobuf/descriptor.h>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/text_format.h>
 #include <iostream>
 #include <onnx/onnx_pb.h>
 #include <sstream>
+#include <vector>
 
 #pragma once
 
@@ -48,75 +50,98 @@ bool convertOnnxDims(OnnxDims const& onnxDims, nvinfer1::Dims& trtDims)
     return true;
 }
 
-// Removes raw data from the text representation of an ONNX model
-void remove_raw_data_strings(std::string& s)
+// Tensor payloads (raw_data, float_data, ...) are elided from text dumps unless they are this short.
+constexpr size_t kMAX_PRINTED_STRING_SIZE = 128;
+
+// Whether field holds TensorProto values: raw_data, string_data and the numeric *_data fields. Other strings, such
+// as names, doc strings and attribute values, are always printed in full.
+bool is_tensor_payload_field(::google::protobuf::FieldDescriptor const* field)
 {
-    std::string::size_type beg = 0;
-    const std::string key = "raw_data: \"";
-    const std::string sub = "...";
-    while ((beg = s.find(key, beg)) != std::string::npos)
-    {
-        beg += key.length();
-        std::string::size_type end = beg - 1;
-        // Note: Must skip over escaped end-quotes
-        while (s[(end = s.find("\"", ++end)) - 1] == '\\')
-        {
-        }
-        if (end - beg > 128)
-        { // Only remove large data strings
-            s.replace(beg, end - beg, "...");
-        }
-        beg += sub.length();
-    }
+    using ::google::protobuf::FieldDescriptor;
+    const std::string& name = field->name();
+    return field->containing_type()->name() == "TensorProto" && field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE
+        && name.size() > 5 && name.compare(name.size() - 5, 5, "_data") == 0;
 }
 
-// Removes float_data, int32_data etc. from the text representation of an ONNX model
-std::string remove_repeated_data_strings(std::string& s)
+bool is_elided_repeated_field(::google::protobuf::FieldDescriptor const* field)
 {
-    std::istringstream iss(s);
-    std::ostringstream oss;
-    bool is_repeat = false;
-    for (std::string line; std::getline(iss, line);)
+    using ::google::protobuf::FieldDescriptor;
+    return field->is_repeated() && field->cpp_type() != FieldDescriptor::CPPTYPE_STRING
+        && is_tensor_payload_field(field);
+}
+
+void print_elided_text(std::ostream& stream, ::google::protobuf::Message const& message, int indent)
+{
+    using ::google::protobuf::FieldDescriptor;
+    const ::google::protobuf::Reflection* reflection = message.GetReflection();
+    std::vector<FieldDescriptor const*> fields;
+    reflection->ListFields(message, &fields);
+    const std::string prefix(indent, ' ');
+    std::string value;
+    for (FieldDescriptor const* field : fields)
     {
-        if (line.find("float_data:") != std::string::npos || line.find("int32_data:") != std::string::npos
-            || line.find("int64_data:") != std::string::npos)
+        if (is_elided_repeated_field(field))
         {
-            if (!is_repeat)
-            {
-                is_repeat = true;
-                oss << line.substr(0, line.find(":") + 1) << " ...\n";
-            }
+            stream << prefix << field->name() << ": ...\n";
+            continue;
         }
-        else
+        const int count = field->is_repeated() ? reflection->FieldSize(message, field) : 1;
+        for (int i = 0; i < count; ++i)
         {
-            is_repeat = false;
-            oss << line << "\n";
+            if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE)
+            {
+                ::google::protobuf::Message const& child = field->is_repeated()
+                    ? reflection->GetRepeatedMessage(message, field, i)
+                    : reflection->GetMessage(message, field);
+                stream << prefix << field->name() << " {\n";
+                print_elided_text(stream, child, indent + 2);
+                stream << prefix << "}\n";
+                continue;
+            }
+            if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING && is_tensor_payload_field(field))
+            {
+                std::string scratch;
+                const std::string& str = field->is_repeated()
+                    ? reflection->GetRepeatedStringReference(message, field, i, &scratch)
+                    : reflection->GetStringReference(message, field, &scratch);
+                if (str.size() > kMAX_PRINTED_STRING_SIZE)
+                {
+                    stream << prefix << field->name() << ": \"...\"\n";
+                    continue;
+                }
+            }
+            value.clear();
+            ::google::protobuf::TextFormat::PrintFieldValueToString(message, field, field->is_repeated() ? i : -1, &value);
+            stream << prefix << field->name() << ": " << value << "\n";
         }
     }
-    return oss.str();
 }
 
 } // anonymous namespace
 
+// Writes the text format of message to stream with tensor payloads elided, without materializing the
+// whole text in memory first.
+inline std::ostream& pretty_print_onnx(std::ostream& stream, ::google::protobuf::Message const& message)
+{
+    print_elided_text(stream, message, 0);
+    return stream;
+}
+
 inline std::string pretty_print_onnx_to_string(::google::protobuf::Message const& message)
 {
-    std::string s;
-    ::google::protobuf::TextFormat::PrintToString(message, &s);
-    remove_raw_data_strings(s);
-    s = remove_repeated_data_strings(s);
-    return s;
+    std::ostringstream ss;
+    pretty_print_onnx(ss, message);
+    return ss.str();
 }
 
 inline std::ostream& operator<<(std::ostream& stream, ::ONNX_NAMESPACE::ModelProto const& message)
 {
-    stream << pretty_print_onnx_to_string(message);
-    return stream;
+    return pretty_print_onnx(stream, message);
 }
 
 inline std::ostream& operator<<(std::ostream& stream, ::ONNX_NAMESPACE::NodeProto const& message)
 {
-    stream << pretty_print_onnx_to_string(message);
-    return stream;
+    return pretty_print_onnx(stream, message);
 }
 
 //...
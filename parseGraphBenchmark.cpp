@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+// Measures how long the parser takes to import a long chain of trivial nodes, which is dominated by the per-node
+// overhead of parseGraph: input lookup, importer dispatch, result handling and output registration.
+// With -p, the chain alternates between nodes imported through the plugin fallback and InstanceNormalization nodes,
+// which adds the overhead of plugin creator lookup and plugin field marshalling.
+
+#include "ModelImporter.hpp"
+#include "NvInferPlugin.h"
+#include "common.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h> // For ::getopt
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+namespace
+{
+
+::ONNX_NAMESPACE::ModelProto makeChain(int nbNodes, bool plugins)
+{
+    ::ONNX_NAMESPACE::ModelProto model;
+    model.set_ir_version(::ONNX_NAMESPACE::IR_VERSION);
+    model.add_opset_import()->set_version(11);
+    ::ONNX_NAMESPACE::GraphProto& graph = *model.mutable_graph();
+    graph.set_name(plugins ? "plugin_chain" : "relu_chain");
+
+    constexpr int kCHANNELS = 16;
+    auto addValueInfo = [&](::ONNX_NAMESPACE::ValueInfoProto* info, const std::string& name) {
+        info->set_name(name);
+        auto* tensorType = info->mutable_type()->mutable_tensor_type();
+        tensorType->set_elem_type(::ONNX_NAMESPACE::TensorProto::FLOAT);
+        tensorType->mutable_shape()->add_dim()->set_dim_value(1);
+        tensorType->mutable_shape()->add_dim()->set_dim_value(kCHANNELS);
+        if (plugins)
+        {
+            // InstanceNormalization requires 3D or 4D inputs.
+            tensorType->mutable_shape()->add_dim()->set_dim_value(4);
+            tensorType->mutable_shape()->add_dim()->set_dim_value(4);
+        }
+    };
+    auto addInitializer = [&](const std::string& name, float value) {
+        ::ONNX_NAMESPACE::TensorProto* tensor = graph.add_initializer();
+        tensor->set_name(name);
+        tensor->set_data_type(::ONNX_NAMESPACE::TensorProto::FLOAT);
+        tensor->add_dims(kCHANNELS);
+        for (int c = 0; c < kCHANNELS; ++c)
+        {
+            tensor->add_float_data(value);
+        }
+    };
+    if (plugins)
+    {
+        addInitializer("scale", 1.F);
+        addInitializer("bias", 0.F);
+    }
+
+    addValueInfo(graph.add_input(), "x");
+    std::string previous = "x";
+    for (int i = 0; i < nbNodes; ++i)
+    {
+        const std::string output = "node_" + std::to_string(i);
+        ::ONNX_NAMESPACE::NodeProto* node = graph.add_node();
+        node->set_name(output);
+        node->add_input(previous);
+        node->add_output(output);
+        if (!plugins)
+        {
+            node->set_op_type("Relu");
+        }
+        else if (i % 2 == 0)
+        {
+            // Not an ONNX operator, so it is imported by the plugin fallback.
+            node->set_op_type("LReLU_TRT");
+            ::ONNX_NAMESPACE::AttributeProto* negSlope = node->add_attribute();
+            negSlope->set_name("negSlope");
+            negSlope->set_type(::ONNX_NAMESPACE::AttributeProto::FLOAT);
+            negSlope->set_f(0.01F);
+        }
+        else
+        {
+            node->set_op_type("InstanceNormalization");
+            node->add_input("scale");
+            node->add_input("bias");
+        }
+        previous = output;
+    }
+    addValueInfo(graph.add_output(), previous);
+    return model;
+}
+
+void printUsage()
+{
+    cout << "Usage: parseGraphBenchmark [-n nb_nodes (default 100000)] [-r repetitions (default 5)] [-p]" << endl;
+    cout << "  -p  Chain plugin and InstanceNormalization nodes instead of Relu nodes" << endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    int nbNodes = 100000;
+    int repetitions = 5;
+    bool plugins = false;
+    int arg = 0;
+    while ((arg = ::getopt(argc, argv, "n:r:ph")) != -1)
+    {
+        switch (arg)
+        {
+        case 'n': nbNodes = std::max(std::atoi(optarg), 1); break;
+        case 'r': repetitions = std::max(std::atoi(optarg), 1); break;
+        case 'p': plugins = true; break;
+        case 'h': printUsage(); return 0;
+        default: printUsage(); return -1;
+        }
+    }
+
+    std::string serialized;
+    makeChain(nbNodes, plugins).SerializeToString(&serialized);
+
+    common::TRT_Logger trtLogger(nvinfer1::ILogger::Severity::kWARNING);
+    initLibNvInferPlugins(&trtLogger, "");
+    auto trtBuilder = common::infer_object(nvinfer1::createInferBuilder(trtLogger));
+
+    std::vector<double> seconds;
+    for (int i = 0; i < repetitions; ++i)
+    {
+        auto trtNetwork = common::infer_object(trtBuilder->createNetworkV2(
+            1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH)));
+        auto trtParser = common::infer_object(new onnx2trt::ModelImporter(trtNetwork.get(), &trtLogger));
+
+        const auto start = std::chrono::steady_clock::now();
+        const bool parsed = trtParser->parse(serialized.data(), serialized.size());
+        const auto end = std::chrono::steady_clock::now();
+        if (!parsed)
+        {
+            cerr << "ERROR: Failed to parse the benchmark model" << endl;
+            return -1;
+        }
+        seconds.push_back(std::chrono::duration<double>(end - start).count());
+    }
+
+    std::sort(seconds.begin(), seconds.end());
+    const double median = seconds[seconds.size() / 2];
+    cout << "Parsed " << nbNodes << (plugins ? " plugin" : " Relu") << " nodes " << repetitions << " times" << endl;
+    cout << "  min:    " << seconds.front() * 1e3 << " ms (" << seconds.front() * 1e9 / nbNodes << " ns/node)" << endl;
+    cout << "  median: " << median * 1e3 << " ms (" << median * 1e9 / nbNodes << " ns/node)" << endl;
+    return 0;
+}
@@ -22,7 +22,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <iostream>
@@ -33,6 +36,80 @@ using std::endl;
 namespace
 {
 
+// Calls visit with each value read by graph, or any graph nested in it, that is neither defined in it nor in
+// defined. The names graph defines are added to defined while it is visited, and removed again afterwards.
+template <class Graph, class Visitor>
+void visit_outer_scope_inputs(Graph const& graph, std::unordered_set<std::string>* defined, Visitor& visit)
+{
+    std::vector<std::string const*> added;
+    auto define = [defined, &added](std::string const& name) {
+        if (defined->insert(name).second)
+        {
+            added.push_back(&name);
+        }
+    };
+    for (auto const& input : graph.input())
+    {
+        define(input.name());
+    }
+    for (auto const& initializer : graph.initializer())
+    {
+        define(initializer.name());
+    }
+    for (auto const& node : graph.node())
+    {
+        for (auto const& output : node.output())
+        {
+            define(output);
+        }
+    }
+    for (auto const& node : graph.node())
+    {
+        for (auto const& input : node.input())
+        {
+            if (!input.empty() && !defined->count(input))
+            {
+                visit(input);
+            }
+        }
+        for (auto const& attr : node.attribute())
+        {
+            if (attr.has_g())
+            {
+                visit_outer_scope_inputs(attr.g(), defined, visit);
+            }
+            for (auto const& subgraph : attr.graphs())
+            {
+                visit_outer_scope_inputs(subgraph, defined, visit);
+            }
+        }
+    }
+    for (std::string const* name : added)
+    {
+        defined->erase(*name);
+    }
+}
+
+// Calls visit with each value that the subgraphs of node (e.g. the body of a Loop, or the branches of an If) read
+// from the graph the node is in, without them being inputs of the node. They are dependencies of the node just like
+// its inputs. A value read more than once may be visited more than once.
+template <class Node, class Visitor>
+void for_each_outer_scope_input(Node const& node, Visitor visit)
+{
+    std::unordered_set<std::string> defined;
+    for (auto const& attr : node.attribute())
+    {
+        if (attr.has_g())
+        {
+            visit_outer_scope_inputs(attr.g(), &defined, visit);
+        }
+        for (auto const& subgraph : attr.graphs())
+        {
+            visit_outer_scope_inputs(subgraph, &defined, visit);
+        }
+    }
+}
+
 enum NodeState
 {
     NODE_UNVISITED,
@@ -58,24 +135,35 @@ bool get_post_order(size_t node_idx, Container const& nodes, std::unordered_map<
     else
     {
         node_state = NODE_ACTIVE;
-        // TODO: This .Get().input() is highly specific to protobuf, should
-        //       generalise it somehow.
-        for (auto const& input : nodes.Get(node_idx).input())
-        {
+        auto visit_input = [&](std::string const& input) {
             if (!node_map.count(input))
             {
                 // Input node not found in graph!
                 // cerr << "ERROR: Input node not found in graph: "
                 //     << input << endl;
                 // return false;
-                continue; // Skip missing input edges
+                return true; // Skip missing input edges
             }
             size_t input_node_idx = node_map.at(input);
-            if (!get_post_order(input_node_idx, nodes, node_map, node_states, order))
+            return get_post_order(input_node_idx, nodes, node_map, node_states, order);
+        };
+        // TODO: This .Get().input() is highly specific to protobuf, should
+        //       generalise it somehow.
+        for (auto const& input : nodes.Get(node_idx).input())
+        {
+            if (!visit_input(input))
             {
                 return false;
             }
         }
+        // Values read by subgraphs of the node are edges too.
+        bool ok = true;
+        for_each_outer_scope_input(
+            nodes.Get(node_idx), [&](std::string const& input) { ok = ok && visit_input(input); });
+        if (!ok)
+        {
+            return false;
+        }
         node_state = NODE_VISITED;
         order->push_back(node_idx);
     }